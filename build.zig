@@ -53,12 +53,24 @@ const examples = [_]Example{
     .{ .name = "09_log_error_handling", .source = "examples/09_log_error_handling.c" },
 };
 
+const Benchmark = struct {
+    name: []const u8,
+    source: []const u8,
+    stats: bool = false,
+};
+
+const benchmarks = [_]Benchmark{
+    .{ .name = "bench_lookup", .source = "testing/bench_lookup.c" },
+    .{ .name = "bench_parse", .source = "testing/bench_parse.c", .stats = true },
+};
+
 const CExecutableOptions = struct {
     name: []const u8,
     source: []const u8,
     target: std.Build.ResolvedTarget,
     optimize: std.builtin.OptimizeMode,
     link_math: bool = false,
+    stats: bool = false,
 };
 
 fn gnuMultiarchSubdir(target: std.Target) ?[]const u8 {
@@ -190,6 +202,9 @@ fn addCExecutable(b: *std.Build, options: CExecutableOptions) *std.Build.Step.Co
         .link_libc = true,
     });
     module.addIncludePath(b.path("include"));
+    if (options.stats) {
+        module.addCMacro("CLAGS_STATS", "1");
+    }
     module.addCSourceFile(.{
         .file = b.path("src/clags.c"),
         .flags = c_flags,
@@ -227,6 +242,7 @@ pub fn build(b: *std.Build) void {
     const examples_step = b.step("examples", "Build all examples");
     const tests_step = b.step("tests", "Build the test binary");
     const test_run_step = b.step("test", "Build and run the tests");
+    const bench_step = b.step("bench", "Build and run the benchmarks");
 
     b.default_step = all;
     all.dependOn(examples_step);
@@ -253,9 +269,34 @@ pub fn build(b: *std.Build) void {
         .link_math = true,
     });
 
+    // validate the shared config at build time and generate its tables
+    const gen_tables_exe = addCExecutable(b, .{
+        .name = "gen_tables",
+        .source = "testing/gen_tables.c",
+        .target = b.graph.host,
+        .optimize = optimize,
+    });
+    const gen_tables = b.addRunArtifact(gen_tables_exe);
+    const tables_header = gen_tables.addOutputFileArg("tables_generated.h");
+    tests_exe.root_module.addIncludePath(tables_header.dirname());
+
     b.installArtifact(tests_exe);
     tests_step.dependOn(&tests_exe.step);
 
     const run_tests = b.addRunArtifact(tests_exe);
     test_run_step.dependOn(&run_tests.step);
+
+    for (benchmarks) |benchmark| {
+        const bench_exe = addCExecutable(b, .{
+            .name = benchmark.name,
+            .source = benchmark.source,
+            .target = target,
+            .optimize = .ReleaseFast,
+            .link_math = true,
+            .stats = benchmark.stats,
+        });
+
+        const run_bench = b.addRunArtifact(bench_exe);
+        bench_step.dependOn(&run_bench.step);
+    }
 }
@@ -85,6 +85,10 @@ clags_arg_t main_args[] = {
 clags_config_t main_config = clags_config(main_args);
 
 int main(int argc, char **argv) {
+  // Answer shell completion requests, install the script with e.g.:
+  // `source <(./07_subcommands __completion bash)`
+  if (clags_handle_completion(argc, argv, &main_config))
+    return 0;
 
   // `clags_parse` returns the config that failed.
   // In basic examples this will always be the config provided to `clags_parse`
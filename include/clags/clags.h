@@ -31,6 +31,7 @@
 #include <float.h>
 #include <inttypes.h>
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -67,6 +68,65 @@
 #define CLAGS_LIST_INIT_CAPACITY 8
 #endif // CLAGS_LIST_INIT_CAPACITY
 
+// the maximal nesting depth of subcommands
+#ifndef CLAGS_MAX_PARSE_DEPTH
+#define CLAGS_MAX_PARSE_DEPTH 64
+#endif // CLAGS_MAX_PARSE_DEPTH
+
+// the maximal nesting depth of `@file` response files
+#ifndef CLAGS_MAX_RESPONSE_DEPTH
+#define CLAGS_MAX_RESPONSE_DEPTH 16
+#endif // CLAGS_MAX_RESPONSE_DEPTH
+
+// the maximal amount of threads checking deferred paths, at least 1
+#ifndef CLAGS_PATH_CHECK_THREADS
+#define CLAGS_PATH_CHECK_THREADS 8
+#endif // CLAGS_PATH_CHECK_THREADS
+
+// the minimal amount of deferred paths per path checking thread
+#ifndef CLAGS_PATH_CHECK_BATCH
+#define CLAGS_PATH_CHECK_BATCH 32
+#endif // CLAGS_PATH_CHECK_BATCH
+
+// the maximal amount of threads parsing the vectors of `clags_parse_batch`,
+// at least 1
+#ifndef CLAGS_BATCH_THREADS
+#define CLAGS_BATCH_THREADS 8
+#endif // CLAGS_BATCH_THREADS
+
+// the minimal amount of vectors per batch parsing thread
+#ifndef CLAGS_BATCH_SIZE
+#define CLAGS_BATCH_SIZE 256
+#endif // CLAGS_BATCH_SIZE
+
+// the minimal size of the blocks an arena allocates
+#ifndef CLAGS_ARENA_BLOCK_SIZE
+#define CLAGS_ARENA_BLOCK_SIZE (64 * 1024)
+#endif // CLAGS_ARENA_BLOCK_SIZE
+
+// set to 1 when compiling clags to collect `clags_parse_stats_t` counters,
+// instrumentation is compiled out entirely otherwise
+#ifndef CLAGS_STATS
+#define CLAGS_STATS 0
+#endif // CLAGS_STATS
+
+// set to 0 when compiling clags to classify tokens with the portable scalar
+// loop, SSE2 or NEON are used otherwise whenever the target supports them
+#ifndef CLAGS_SIMD
+#define CLAGS_SIMD 1
+#endif // CLAGS_SIMD
+
+// the hidden first arguments through which the generated completion scripts
+// query candidates and a program prints its script, see
+// `clags_handle_completion`
+#ifndef CLAGS_COMPLETE_COMMAND
+#define CLAGS_COMPLETE_COMMAND "__complete"
+#endif // CLAGS_COMPLETE_COMMAND
+
+#ifndef CLAGS_COMPLETION_SCRIPT_COMMAND
+#define CLAGS_COMPLETION_SCRIPT_COMMAND "__completion"
+#endif // CLAGS_COMPLETION_SCRIPT_COMMAND
+
 // the character column at which ':' appears in `clags_usage` output
 // you can adjust this value to control the alignment of argument descriptions
 #ifndef CLAGS_USAGE_ALIGNMENT
@@ -111,6 +171,10 @@ typedef void (*clags_log_handler_t)(
     va_list args); // the function type of custom log handlers
 typedef void (*clags_callback_func_t)(
     clags_config_t *config); // the function type of callback functions
+typedef bool (*clags_element_func_t)(
+    clags_config_t *config, const void *element,
+    void *data); // the function type of list element callbacks, returning
+                 // false rejects the element
 typedef uint64_t clags_fsize_t;
 typedef uint64_t clags_time_t;
 
@@ -188,18 +252,39 @@ clags_verify_func_t clags__verify_time_ns;
     "argument value does not match expected type or criteria")                 \
   X(Clags_Error_InvalidOption, "unrecognized option or flag syntax")           \
   X(Clags_Error_TooManyArguments, "too many positional arguments provided")    \
-  X(Clags_Error_TooFewArguments, "required positional arguments missing")
+  X(Clags_Error_TooFewArguments, "required positional arguments missing")      \
+  X(Clags_Error_InvalidResponseFile, "response file could not be read")        \
+  X(Clags_Error_InvalidConfigFile, "config file could not be read")            \
+  X(Clags_Error_InvalidSnapshot, "snapshot does not match the config")
 
 // an auto-generated enum of all supported value types
 #define X(type, func, name) type,
 typedef enum { clags__types } clags_value_type_t;
 #undef X
 
+// the number of value types
+#define X(type, func, name) +1
+enum { CLAGS_VALUE_TYPE_COUNT = 0 clags__types };
+#undef X
+
 // an auto-generated enum of all error types
 #define X(type, desc) type,
 typedef enum { clags__errors } clags_error_t;
 #undef X
 
+// the details of the last parse error, turn it into a message on demand with
+// `clags_error_message`
+typedef struct {
+  clags_error_t error;  // the kind of the error
+  size_t index;         // the argv index of the offending token, after the
+                        // expansion of response files; 0 if there is none
+  const char *arg_name; // the argument or flag the token was given for, if any
+  const char *token;    // the offending part of the token, not terminated
+  size_t token_length;  // the length of `token`
+  clags_value_type_t expected; // the value type the token failed to verify
+                               // as, only for `Clags_Error_InvalidValue`
+} clags_error_record_t;
+
 // all available flag types
 // if a flag's `type` is not explicitly set, `Clags_BoolFlag` is used by default
 typedef enum {
@@ -220,14 +305,47 @@ typedef struct {
   size_t capacity;
 } clags_sb_t;
 
+// entirely internal, the open addressing table of the interned strings of a
+// pool, see `clags_options_t.intern_strings`
+typedef struct {
+  char **slots;
+  size_t capacity; // the number of slots, a power of two
+  size_t count;    // the number of interned strings
+} clags_interned_t;
+
+// a bump allocator that backs duplicated strings and list storage, construct
+// zero-initialized and release everything at once with `clags_arena_reset`
+typedef struct clags_arena_block_t clags_arena_block_t;
+typedef struct {
+  clags_arena_block_t *blocks; // internal, the allocated blocks, newest first
+  size_t block_size; // the minimal block size, `CLAGS_ARENA_BLOCK_SIZE` if 0
+  clags_interned_t interned; // internal, the strings interned in the arena
+} clags_arena_t;
+
 // the definition of a "generic" list
 typedef struct {
   void *items;
   size_t item_size; // set by the appropiate `clags_list_<type>` macro
   size_t count;
   size_t capacity;
+  clags_arena_t *arena; // the arena backing `items`, nullptr if allocated via
+                        // `CLAGS_REALLOC`; set automatically
+  clags_element_func_t on_element; // receives every verified element instead
+                                   // of the list storing it, see
+                                   // `clags_streamed_list`
+  void *element_data;              // passed to `on_element`
+  size_t streamed; // the number of elements handed to `on_element`; set
+                   // automatically
+  bool fixed; // `items` is caller storage of `capacity` items, which is never
+              // grown or freed, see `clags_fixed_list`
 } clags_list_t;
 
+// the file status of a path argument, see `clags_options_t.path_stats`
+typedef struct {
+  const char *path;
+  struct stat attr;
+} clags_path_stat_t;
+
 // the definition of a choice
 typedef struct {
   const char *value;
@@ -241,6 +359,10 @@ typedef struct {
   bool print_no_details; // do not print the full choice descriptions in
                          // `clags_usage`, if possible
   bool case_insensitive; // match choices regardless of case
+
+  // internal, set by `clags_choices_build_index`
+  size_t *hash_slots;   // open addressing table of choice indices plus one
+  size_t hash_capacity; // the amount of slots, a power of two
 } clags_choices_t;
 
 // the definition of a subcommand
@@ -298,7 +420,9 @@ typedef struct {
   clags_value_type_t value_type; // type of the option's value. See
                                  // `clags__types` for a list of all types
   bool is_list; // if true, each occurrence appends one value to a clags_list_t
-  union {       // only one of these should be set
+  const char *env; // environment variable providing the value if argv gives
+                   // none, nullptr if none; empty variables count as unset
+  union {          // only one of these should be set
     clags_custom_verify_func_t
         verify; // a custom verification function pointer, only if `value_type`
                 // == `Clags_Custom`
@@ -323,6 +447,19 @@ typedef struct {
                                   // `Clags_CallbackFlag`
 } clags_flag_t;
 
+typedef enum {
+  Clags_Positional,
+  Clags_Option,
+  Clags_Flag,
+} clags_arg_type_t;
+
+// entirely internal, an entry of the sorted long flag lookup table
+typedef struct {
+  const char *name; // the long flag, without the leading "--"
+  size_t length;    // the length of `name`
+  size_t index;     // index of the option or flag in `clags_config_t.args`
+} clags_long_entry_t;
+
 // entirely internal
 typedef struct {
   clags_positional_t *positional;
@@ -332,13 +469,37 @@ typedef struct {
   size_t option_count;
   clags_flag_t *flags;
   size_t flag_count;
+  clags_long_entry_t *longs; // long flags of all options and flags, sorted by
+                             // name for binary search
+  size_t long_count;
+  uint8_t short_slots[256]; // maps a short flag character to its slot in
+                            // `shorts`, 0 if the character is unused
+  size_t shorts[256]; // index in `clags_config_t.args` per slot, slot 0 unused
+  size_t *subcmd_slots;   // open addressing table of subcommand indices plus
+                          // one, only in compiled tables of subcommand configs
+  size_t subcmd_capacity; // the number of slots, a power of two
+  size_t *env_slots;   // open addressing table of the indices plus one in
+                       // `clags_config_t.args` of options bound to an
+                       // environment variable, by variable name
+  size_t env_capacity; // the number of slots, a power of two
 } clags_args_t;
 
-typedef enum {
-  Clags_Positional,
-  Clags_Option,
-  Clags_Flag,
-} clags_arg_type_t;
+// the lookup tables of a config, generated offline by `clags_write_tables`
+// and installed without validation by `clags_compile_tables`
+typedef struct clags_tables_t {
+  uint64_t fingerprint; // hash of the argument definitions the tables match
+  size_t args_count;
+  const clags_long_entry_t *longs; // see `clags_args_t.longs`
+  size_t long_count;
+  const unsigned char *short_flags; // the short flags in slot order
+  const size_t *short_indices;      // index in `clags_config_t.args` per flag
+  size_t short_count;
+  const size_t *subcmd_slots; // see `clags_args_t.subcmd_slots`
+  size_t subcmd_capacity;
+  const struct clags_tables_t *const
+      *subcmd_tables; // the tables of the subcommand configs by subcommand
+                      // index, nullptr for subcommands without a config
+} clags_tables_t;
 
 // a wrapper for all arg types
 // automatically construct with `clags_positional`, `clags_option` and
@@ -367,6 +528,32 @@ typedef struct {
   bool duplicate_strings; // duplicate all strings instead of setting variables
                           // to the content of argv, free the allocated memory
                           // via `clags_config_free_allocs`
+  clags_arena_t *arena; // allocate duplicated strings and list storage from
+                        // this arena instead of individual heap allocations
+  bool intern_strings; // duplicate equal strings only once per pool, the
+                       // config's, context's or arena's, so that they share
+                       // one allocation and compare equal by pointer
+  bool presize_lists; // count the items of every list in a pre-scan of argv
+                      // and allocate each list once at its exact size
+  bool defer_path_checks; // check path, file and dir values together at the
+                          // end of the parse instead of one after another,
+                          // in parallel for large amounts of paths
+  clags_list_t *path_stats; // receives a `clags_path_stat_t` for every
+                            // deferred path in argument order, may be a
+                            // `clags_field` offset like argument variables
+  bool response_files; // expand '@file' arguments in front of the first "--"
+                       // into the whitespace separated, optionally quoted
+                       // tokens of that file, the file stays mapped until
+                       // `clags_config_free`
+  bool cache_usage; // keep the rendered usage on the config and reuse it until
+                    // the program name, the subcommand path or anything the
+                    // usage prints changes, freed via `clags_config_free`
+  bool abbreviate_long_flags; // accept unique prefixes of long options and
+                              // flags, e.g. `--verb` for `--verbose`, like
+                              // GNU getopt; exact names always take precedence
+  bool lazy_conversion; // only record the tokens of typed values during the
+                        // parse and convert them on their first access via
+                        // `clags_get`, or all at once via `clags_validate_all`
   clags_log_handler_t log_handler; // a custom log handler
   clags_log_level_t
       min_log_level;       // the minimal log level for which to print logs
@@ -387,9 +574,91 @@ struct clags_config_t {
   clags_list_t
       allocs; // all duplicated strings allocated in this config's context, only
               // if `options.duplicate_strings` is enabled
+  clags_interned_t interned; // the index of `allocs`, only if
+                             // `options.intern_strings` is enabled too
   clags_error_t error; // the last error detected while parsing this config
+  clags_error_record_t error_record; // the details of `error`
+  clags_args_t *compiled; // cached argument tables, set by `clags_compile`
+  bool compiled_lazily;   // `compiled` was built on the config's first
+                          // selection as a subcommand of a compiled config
+  clags_list_t mappings; // the response files mapped while parsing, only if
+                         // `options.response_files` is enabled
+  clags_sb_t usage;   // the rendered usage, only if `options.cache_usage` is
+                      // enabled
+  uint64_t usage_key; // hash of what `usage` was rendered for
+  clags_list_t lazy_values; // the values awaiting their conversion on the
+                            // root config of the last parse, only if
+                            // `options.lazy_conversion` is enabled
 };
 
+// the mutable state of a single parse, construct with `clags_context`
+// parsing with a context leaves the config untouched, so one config can be
+// parsed concurrently by multiple threads, each with its own context
+typedef struct {
+  void *variables; // base address of the struct receiving the parsed values if
+                   // the arguments' variables are `clags_field` offsets,
+                   // nullptr if they are absolute pointers
+  clags_arena_t *arena; // the arena to allocate from instead of the configs'
+                        // `options.arena`, see `clags_options_t`
+
+  // set automatically
+  clags_config_t *config; // the (sub)command config the parse ended in
+  const char *name;       // the name of `config`, see `clags_config_t.name`
+  clags_list_t allocs; // all strings duplicated during the parse, only if the
+                       // configs' `options.duplicate_strings` is enabled
+  clags_interned_t interned; // the index of `allocs`, only if the configs'
+                             // `options.intern_strings` is enabled too
+  clags_list_t mappings; // the response files mapped during the parse
+  clags_list_t lazy_values; // the values awaiting their conversion, see
+                            // `clags_config_t.lazy_values`
+  clags_error_t error;   // the last error detected while parsing
+  clags_error_record_t error_record; // the details of `error`
+} clags_context_t;
+
+// an argument vector of `clags_parse_batch`
+typedef struct {
+  int argc;
+  char **argv;
+} clags_argv_t;
+
+// the state of an incremental parse, start with `clags_parser_begin`
+typedef struct {
+  // entirely internal
+  clags_config_t *config;   // the (sub)command config currently parsed
+  clags_context_t *context; // the context receiving the parse state, if any
+  clags_args_t *args;       // the argument tables of `config`
+  clags_args_t local_args;  // temporary tables if `config` is not compiled
+  const clags_config_t *path[CLAGS_MAX_PARSE_DEPTH]; // the configs entered
+  const char *names[CLAGS_MAX_PARSE_DEPTH]; // the names `path` was entered by
+  size_t depth;                             // the length of `path`
+  size_t index; // the position of the next token within the (sub)command
+  const clags_option_t *pending; // an option waiting for its value
+  const char *pending_name;      // the flag `pending` was given through
+  size_t pending_index;          // the argv index of `pending_name`
+  size_t ignore_prefix_length;   // the length of `.ignore_prefix`, if set
+  size_t list_terminator_length; // the length of `.list_terminator`, if set
+  bool arguments_ignored;
+  bool in_list;
+  bool parsing_optionals;
+  bool accept_options;
+  size_t positional_count;
+  size_t required_count;
+  bool finished;          // the parse ended early or successfully
+  clags_config_t *failed; // the config in which the parse failed
+  char **argv;            // the whole argument vector, if known up front
+  size_t argc;
+  size_t position; // the position of the next token in `argv`
+  clags_list_t path_checks; // the paths awaiting their deferred check
+  clags_list_t held_lists; // config file and environment values of list
+                           // options, applied when leaving the (sub)command
+                           // if argv gave the list none
+  const clags_list_t *file_entries; // the key value pairs of the config file
+                                    // layer, see `clags_parse_layered`
+  bool file_only; // apply the config file layer only, see `clags_parse_file`
+  clags_list_t *lazy_values; // the `.lazy_values` of the root config or the
+                             // context
+} clags_parser_t;
+
 // helper macros
 #define clags_arr_len(arr) (sizeof(arr) / sizeof((arr)[0]))
 #define clags_return_defer(value)                                              \
@@ -438,6 +707,23 @@ struct clags_config_t {
 #define clags_size_list() clags__sized_list(sizeof(clags_fsize_t))
 #define clags_time_list() clags__sized_list(sizeof(clags_time_t))
 #define clags_choice_list() clags__sized_list(sizeof(clags_choice_t *))
+#define clags_path_stat_list() clags__sized_list(sizeof(clags_path_stat_t))
+
+// a list that hands each verified element of `size` bytes to `callback` as
+// soon as it is parsed instead of storing it, so that its memory stays
+// constant in the amount of elements. `count` stays 0, and `items` holds only
+// the element being handed over, valid for the duration of the callback
+#define clags_streamed_list(size, callback, data)                              \
+  {.item_size = (size), .on_element = (callback), .element_data = (data)}
+
+// a list over the caller's array `buf` of `cap` elements, which never
+// allocates; more than `cap` values fail the parse with
+// `Clags_Error_InvalidValue`, and `clags_list_free` only empties it
+#define clags_fixed_list(buf, cap)                                             \
+  {.items = (buf),                                                             \
+   .item_size = sizeof(*(buf)),                                                \
+   .capacity = (cap),                                                          \
+   .fixed = true}
 
 // macros for easy value extraction from lists
 // `value_type` must match the type stored within the list
@@ -456,6 +742,17 @@ struct clags_config_t {
 #define clags_subcmds(subcmds)                                                 \
   {.items = (subcmds), .count = clags_arr_len(subcmds)}
 
+// use the offset of a struct member as an argument's variable
+// the member is written relative to `clags_context_t.variables` when parsing
+// with `clags_parse_context`; the offset is stored plus one, so that nullptr
+// keeps meaning "no variable"
+#define clags_field(type, member)                                              \
+  ((void *)(uintptr_t)(offsetof(type, member) + 1))
+
+// construct a `clags_context_t`, optionally receiving values in a struct
+#define clags_context(vars)                                                    \
+  {.variables = (vars), .allocs = {.item_size = sizeof(char *)}}
+
 /* Argument Constructors */
 
 /*
@@ -594,7 +891,363 @@ struct clags_config_t {
                                           clags_config_t *config);
 
 /*
-  Print a detailed usage based on the provided config.
+  Parse a config file into the long options and flags of a config, as if each
+  `key = value` line was given as `--key=value`. Lines are split in place in a
+  private mapping of the file, which stays mapped until `clags_config_free`.
+  Blank lines and lines starting with '#' or ';' are skipped, values may be
+  quoted, and flags take a boolean value. Keys below an INI `[name]` header
+  belong to the subcommand of that path from the root, its names separated
+  by dots like `[remote.build]`, and are only applied by
+  `clags_parse_layered`. Positional arguments are not checked.
+
+  Arguments:
+    - path          : the path of the config file
+    - config        : pointer to a config with argument definitions and other
+  options
+
+  Returns:
+    clags_config_t* : pointer to the failed config, nullptr on success. An
+  unreadable or malformed file, or a section naming no subcommand path, sets
+  `Clags_Error_InvalidConfigFile`.
+*/
+[[nodiscard]] clags_config_t *clags_parse_file(const char *path,
+                                               clags_config_t *config);
+
+/*
+  Parse a config file, the bound environment variables and the argument
+  vector in one pass, each layer taking precedence over the previous one.
+  Whenever a (sub)command is entered, the keys of its section of the file are
+  applied first, then its environment variables, then the arguments; list
+  options receive the values of the highest layer giving any. See
+  `clags_parse_file` for the file format.
+
+  Arguments:
+    - path          : the path of the config file, nullptr for none
+    - argc          : the number of arguments
+    - argv          : the array of arguments
+    - config        : pointer to a config with argument definitions and other
+  options
+
+  Returns:
+    clags_config_t* : pointer to the failed config, nullptr on success.
+*/
+[[nodiscard]] clags_config_t *clags_parse_layered(const char *path, int argc,
+                                                  char **argv,
+                                                  clags_config_t *config);
+
+/*
+  Validate a config once and cache its sorted arguments and lookup tables on
+  it, so that following calls to `clags_parse` skip validation and do not
+  allocate any scratch memory. The config's arguments must not be changed
+  afterwards. The subcommands are indexed by name for constant time dispatch.
+  Subcommand configs are not compiled up front: each one is compiled on its
+  first selection by `clags_parse`, so only the configs on the selected
+  subcommand path are ever validated and sorted. Parsing with a context reads
+  configs only and builds temporary tables for uncompiled subcommands instead.
+
+  Arguments:
+    - config        : pointer to the config to compile
+
+  Returns:
+    bool            : true if the config is valid and was compiled, false
+  otherwise. On failure, the config's `.error` field is set.
+*/
+[[nodiscard]] bool clags_compile(clags_config_t *config);
+
+/*
+  Validate a config and every subcommand config below it, and write their
+  lookup tables as C definitions of static `clags_tables_t`, to be generated
+  at build time and included by the program that defines the same config.
+  The tables of a subcommand config are named after its parent's, followed by
+  `_` and the subcommand's index, and linked through `.subcmd_tables`. Run it
+  from a build step, see testing/gen_tables.c, so that config errors anywhere
+  in the subcommand tree fail the build.
+
+  Arguments:
+    - out           : the stream to write the definition to
+    - name          : the identifier of the generated `clags_tables_t`
+    - config        : pointer to the config to generate the tables for
+
+  Returns:
+    bool            : true if all configs are valid and the tables were
+  written, false otherwise. On failure, nothing is written if a config is
+  invalid, and the config's `.error` field is set.
+*/
+[[nodiscard]] bool clags_write_tables(FILE *out, const char *name,
+                                      clags_config_t *config);
+
+/*
+  Compile a config from tables generated by `clags_write_tables`, like
+  `clags_compile` but without validating, sorting or hashing the arguments.
+  The subcommand configs are compiled from their linked tables as well, so
+  no config of the tree is validated at runtime; they are released along with
+  the config by `clags_config_free_compiled`. Tables generated from different
+  argument definitions are rejected.
+
+  Arguments:
+    - config        : pointer to the config to compile
+    - tables        : pointer to the tables generated for the config
+
+  Returns:
+    bool            : true if the tables match the config and were installed,
+  false otherwise. On failure, the config's `.error` field is set to
+  `Clags_Error_InvalidConfig`.
+*/
+[[nodiscard]] bool clags_compile_tables(clags_config_t *config,
+                                        const clags_tables_t *tables);
+
+/*
+  Parse arguments based on a config compiled with `clags_compile`. Apart from
+  string duplication and list storage, parsing performs no heap allocations.
+  Subcommand configs that are not compiled themselves are validated, compiled
+  and cached on their first selection, so the first parse down each
+  subcommand path allocates their tables. `clags_config_free_compiled` on the
+  root config releases them along with its own tables.
+
+  Arguments:
+    - argc          : the number of arguments
+    - argv          : the array of arguments
+    - config        : pointer to a compiled config
+
+  Returns:
+    clags_config_t* : pointer to the failed config, see `clags_parse`. Fails
+  with `Clags_Error_InvalidConfig` if the config was not compiled.
+*/
+[[nodiscard]] clags_config_t *clags_parse_compiled(int argc, char **argv,
+                                                   clags_config_t *config);
+
+/*
+  Parse arguments with a caller-provided context that receives all parse
+  state. The config, its arguments and its compiled tables are only read, so a
+  config can be parsed by multiple threads at the same time, as long as each
+  thread uses its own context and variables. If the context's `.variables` is
+  set, all argument variables must be `clags_field` offsets into it. Without
+  glibc's `strtod_l`, doubles beyond the exact fast path read `localeconv`,
+  so no thread may change the locale meanwhile.
+
+  Compile the configs with `clags_compile` up front to skip the validation and
+  the allocations of temporary tables on every call. Subcommand configs do not
+  get their `.parent` set, and Clags_ConfigFlag variables and callbacks
+  receive the shared config.
+
+  Arguments:
+    - argc          : the number of arguments
+    - argv          : the array of arguments
+    - config        : pointer to a config with argument definitions and other
+  options, left unmodified
+    - context       : pointer to the context receiving the parse state
+
+  Returns:
+    clags_config_t* : pointer to the failed config, nullptr on success. The
+  error is stored in the context's `.error` field.
+*/
+[[nodiscard]] clags_config_t *clags_parse_context(int argc, char **argv,
+                                                  clags_config_t *config,
+                                                  clags_context_t *context);
+
+/*
+  Parse many argument vectors against one config, each into its own context
+  like `clags_parse_context`. A config that is not compiled yet is compiled
+  for the batch only, and its subcommand configs are compiled along with it,
+  so that all vectors share the same tables. If the config or one of its
+  subcommand configs is invalid, every vector fails with
+  Clags_Error_InvalidConfig.
+  If every context has its own `.variables`, the vectors are spread over up
+  to `CLAGS_BATCH_THREADS` threads of at least `CLAGS_BATCH_SIZE` vectors
+  each, so the contexts must not share an arena then either. Otherwise the
+  vectors are parsed one after another, in order, on the calling thread.
+
+  Arguments:
+    - config        : pointer to the config with argument definitions
+    - vectors       : the `count` argument vectors to parse
+    - count         : the number of vectors
+    - results       : the `count` contexts receiving the parse state of each
+  vector, see `clags_context`; their `.error` and `.error_record` tell which
+  vectors failed and why
+
+  Returns:
+    size_t          : the number of vectors that failed to parse
+*/
+[[nodiscard]] size_t clags_parse_batch(clags_config_t *config,
+                                       const clags_argv_t *vectors,
+                                       size_t count,
+                                       clags_context_t *results);
+
+/*
+  Start an incremental parse, which accepts the arguments one at a time via
+  `clags_parser_feed` and rejects invalid input on the first offending token.
+  The tokens must stay valid as long as the parsed values are used, unless
+  string duplication is enabled. Response files and presized lists are only
+  supported by `clags_parse`.
+
+  Arguments:
+    - parser        : pointer to the parser state to initialize
+    - program_name  : the name of the program, as in argv[0]
+    - config        : pointer to the config with argument definitions
+    - context       : pointer to a context receiving the parse state like in
+  `clags_parse_context`, or nullptr to write it to the config
+
+  Returns:
+    - nullptr on success, or a pointer to the config if it is invalid
+*/
+[[nodiscard]] clags_config_t *clags_parser_begin(clags_parser_t *parser,
+                                                 const char *program_name,
+                                                 clags_config_t *config,
+                                                 clags_context_t *context);
+
+/*
+  Parse the next argument of an incremental parse. Once an error occurred or
+  an exit flag was encountered, all following tokens are ignored.
+
+  Arguments:
+    - parser        : pointer to the parser state
+    - token         : the next argument
+
+  Returns:
+    - nullptr on success, or a pointer to the (sub)command config that failed
+*/
+[[nodiscard]] clags_config_t *clags_parser_feed(clags_parser_t *parser,
+                                                const char *token);
+
+/*
+  Finish an incremental parse, reporting missing option values and required
+  arguments, and release its temporary state. Must be called once for every
+  `clags_parser_begin`.
+
+  Arguments:
+    - parser        : pointer to the parser state
+
+  Returns:
+    - nullptr on success, or a pointer to the (sub)command config that failed
+*/
+[[nodiscard]] clags_config_t *clags_parser_end(clags_parser_t *parser);
+
+/*
+  Free the strings duplicated into a context, the response files mapped during
+  its parses, its recorded lazy values and the lists of a config that were
+  written relative to the context's variables.
+  The function does not propagate to child configs.
+
+  Arguments:
+    - context       : pointer to the context to free
+    - config        : pointer to the config whose lists to free, may be
+  nullptr to only free the duplicated strings
+*/
+void clags_context_free(clags_context_t *context, clags_config_t *config);
+
+/*
+  Convert the values a parse recorded for a variable of a config with
+  `.lazy_conversion` enabled, on the variable's first access. The result is
+  memoized, so later accesses neither convert nor verify again. Variables
+  without recorded values, like strings and flags, are left untouched.
+
+  Arguments:
+    - config        : pointer to the config passed to `clags_parse`
+    - variable      : pointer to the variable of the option or positional
+  argument to access
+
+  Returns:
+    bool            : true if the variable holds its converted value, false if
+  a value failed to convert. The error is stored on the config of its
+  argument, like after a failed parse.
+*/
+[[nodiscard]] bool clags_get(clags_config_t *config, void *variable);
+
+/*
+  Like `clags_get`, for a parse with `clags_parse_context`.
+
+  Arguments:
+    - context       : pointer to the context given to the parse
+    - variable      : pointer to the variable to access, within
+  `context->variables` for `clags_field` offsets
+
+  Returns:
+    bool            : true if the variable holds its converted value, false if
+  a value failed to convert. The error is stored in the context.
+*/
+[[nodiscard]] bool clags_get_context(clags_context_t *context,
+                                     void *variable);
+
+/*
+  Convert all values a parse recorded with `.lazy_conversion` enabled at once,
+  in argument order, for programs that want every error up front.
+
+  Arguments:
+    - config        : pointer to the config passed to `clags_parse`
+
+  Returns:
+    clags_config_t* : pointer to the (sub)command config of the first value
+  that failed to convert, nullptr on success
+*/
+[[nodiscard]] clags_config_t *clags_validate_all(clags_config_t *config);
+
+/*
+  Like `clags_validate_all`, for a parse with `clags_parse_context`.
+
+  Arguments:
+    - context       : pointer to the context given to the parse
+
+  Returns:
+    clags_config_t* : pointer to the (sub)command config of the first value
+  that failed to convert, nullptr on success
+*/
+[[nodiscard]] clags_config_t *
+clags_validate_all_context(clags_context_t *context);
+
+/*
+  Write the parse result held by the argument variables into one contiguous
+  snapshot: all scalar values, the list contents, the selected subcommand path
+  and the strings they point to. The snapshot holds no pointers, so it can be
+  passed through a pipe, shared memory or an environment variable and loaded
+  with `clags_snapshot_load` by a process with the same config.
+  Arguments of type `Clags_Custom` cannot be snapshotted, and streamed lists
+  are written empty.
+
+  Arguments:
+    - config        : pointer to the root config of the parse
+    - context       : pointer to the context of a parse with
+  `clags_parse_context`, whose `.variables` are read, or nullptr
+    - out           : pointer to the string builder receiving the snapshot,
+  replacing its content
+
+  Returns:
+    bool            : true on success, false if an argument cannot be
+  snapshotted
+*/
+[[nodiscard]] bool clags_snapshot(clags_config_t *config,
+                                  clags_context_t *context, clags_sb_t *out);
+
+/*
+  Load a snapshot of `clags_snapshot` back into the argument variables,
+  without parsing. The strings and list items are used in place, with their
+  pointers fixed up inside the buffer, so the buffer must be writable, aligned
+  like malloc'd or mapped memory and outlive the variables. A buffer may be
+  loaded again after moving it.
+  Lists become fixed lists over the buffer, see `clags_fixed_list`, and
+  must be reset to their empty constructor before parsing into them again.
+  Nothing is written if the snapshot does not match the config.
+
+  Arguments:
+    - config        : pointer to the root config the snapshot was taken of
+    - context       : pointer to a context, whose `.variables` receive the
+  values and whose `.config` is set to the last config on the subcommand
+  path, or nullptr
+    - buffer        : the snapshot
+    - size          : the size of the snapshot in bytes
+
+  Returns:
+    bool            : true on success, false with the error
+  Clags_Error_InvalidSnapshot if the snapshot is damaged or was taken of
+  another config
+*/
+[[nodiscard]] bool clags_snapshot_load(clags_config_t *config,
+                                       clags_context_t *context, void *buffer,
+                                       size_t size);
+
+/*
+  Print a detailed usage based on the provided config, rendered with
+  `clags_usage_sb` and written to stdout at once. Configs with
+  `options.cache_usage` render it once and write the cached text afterwards.
 
   Arguments:
     - program_name  : the name of the program
@@ -603,6 +1256,20 @@ struct clags_config_t {
 */
 void clags_usage(const char *program_name, clags_config_t *config);
 
+/*
+  Render the usage printed by `clags_usage` into a string builder, so it can be
+  written at once or kept for later. The text is appended to the builder's
+  content without a terminating null byte, see `clags_sb_append_null`.
+
+  Arguments:
+    - program_name  : the name of the program
+    - config        : pointer to a config with argument definitions and other
+  options
+    - out           : pointer to the string builder receiving the usage
+*/
+void clags_usage_sb(const char *program_name, clags_config_t *config,
+                    clags_sb_t *out);
+
 /*
   Get the index of a selected subcommand in the provided subcommand array.
 
@@ -634,9 +1301,31 @@ void clags_usage(const char *program_name, clags_config_t *config);
 [[nodiscard]] int clags_choice_index(clags_choices_t *choices,
                                      clags_choice_t *choice);
 
+/*
+  Build a hash index over a choice set, so that values are matched in
+  constant time instead of by comparing them against every choice. Matching
+  keeps the first of multiple equal choices, like without an index. The
+  choices must not change while the index exists.
+
+  Arguments:
+    - choices       : pointer to the clags_choices_t to index
+*/
+void clags_choices_build_index(clags_choices_t *choices);
+
+/*
+  Free the hash index of a choice set, see `clags_choices_build_index`.
+
+  Arguments:
+    - choices       : pointer to the indexed clags_choices_t
+*/
+void clags_choices_free_index(clags_choices_t *choices);
+
 /*
   Duplicate a string if string duplication is enabled in the config,
-  otherwise return the original string.
+  otherwise return the original string. The duplicate is allocated from the
+  active arena if one is set, see `clags_options_t.arena`. With
+  `.intern_strings`, an equal string duplicated before into the same pool is
+  returned instead.
 
   Arguments:
     - config  : pointer to the clags configuration
@@ -652,8 +1341,9 @@ void clags_usage(const char *program_name, clags_config_t *config);
                                                   const char *string);
 
 /*
-  Free all memory allocated for strings duplicated during parsing.
-  This only applies if `.duplicate_strings` was enabled in the config.
+  Free all memory allocated for strings duplicated during parsing, along with
+  their interning table. This only applies if `.duplicate_strings` was
+  enabled in the config.
 
   Arguments:
     - config        : pointer to the clags_config_t whose duplicated strings
@@ -662,8 +1352,21 @@ void clags_usage(const char *program_name, clags_config_t *config);
 void clags_config_free_allocs(clags_config_t *config);
 
 /*
-  Free all lists and allocated strings of a config.
-  The function does not propagate to child configs.
+  Free the argument tables cached on a config by `clags_compile`, along with
+  the tables of the subcommand configs compiled on their first selection.
+  Following parses validate and sort the configs again.
+
+  Arguments:
+    - config        : pointer to the compiled config
+*/
+void clags_config_free_compiled(clags_config_t *config);
+
+/*
+  Free all lists and allocated strings of a config, its cached usage and its
+  recorded lazy values, and unmap the response files of its parses,
+  invalidating the values pointing into them.
+  The function does not propagate to child configs, and keeps compiled
+  argument tables, see `clags_config_free_compiled`.
 
   Arguments:
     - config        : pointer to the config of which to free all strings and
@@ -672,7 +1375,9 @@ void clags_config_free_allocs(clags_config_t *config);
 void clags_config_free(clags_config_t *config);
 
 /*
-  Free all memory associated with a `clags_list_t` instance.
+  Free all memory associated with a `clags_list_t` instance. Storage backed by
+  an arena is only released by resetting the arena, and the caller's storage
+  of a fixed list is kept and only emptied.
 
   Arguments:
     - list          : a pointer to the list to free
@@ -690,6 +1395,83 @@ void clags_list_free(clags_list_t *list);
 */
 [[nodiscard]] const char *clags_error_description(clags_error_t error);
 
+/*
+  Format the message of an error record, e.g. taken from a failed config's or
+  a context's `.error_record`. Parsing itself never formats error records.
+
+  Arguments:
+    - record        : pointer to the error record to describe
+    - out           : pointer to the string builder the message is appended
+  to, without a terminating null byte
+*/
+void clags_error_message(const clags_error_record_t *record, clags_sb_t *out);
+
+/* Shell Completion */
+
+// the shells completion scripts can be generated for
+typedef enum {
+  Clags_Shell_Bash,
+  Clags_Shell_Zsh,
+  Clags_Shell_Fish,
+} clags_shell_t;
+
+/*
+  List the completion candidates for the last token of a partial command line,
+  one per line, each followed by a tab and its description if it has one. The
+  tokens in front of it only select the subcommand and position: they are
+  looked up in the (compiled) tables but never verified or stored, so paths
+  are not checked and the config and variables stay untouched. Candidates are
+  long and short flags for tokens starting with '-', subcommand names, and
+  the values of choices. No candidates means free-form input like a path.
+
+  Arguments:
+    - argc          : the number of tokens, including the program name
+    - argv          : the tokens, the last being the one to complete; a
+  program name alone completes an empty token
+    - config        : pointer to the config with argument definitions
+    - out           : pointer to the string builder the candidates are
+  appended to, without a terminating null byte
+
+  Returns:
+    bool            : true if the candidates were listed, false if the input
+  is invalid or a config on the path is invalid
+*/
+[[nodiscard]] bool clags_complete(int argc, char **argv,
+                                  clags_config_t *config, clags_sb_t *out);
+
+/*
+  Render a completion script for a shell, which completes the program by
+  running it with `CLAGS_COMPLETE_COMMAND` followed by the words up to the
+  cursor, and falls back to file completion if no candidates are printed.
+
+  Arguments:
+    - shell         : the shell to generate the script for
+    - program_name  : the name of the program, only its last path component
+  is used
+    - out           : pointer to the string builder the script is appended to,
+  without a terminating null byte
+*/
+void clags_completion_script(clags_shell_t shell, const char *program_name,
+                             clags_sb_t *out);
+
+/*
+  Serve the hidden completion commands in front of parsing: with
+  `CLAGS_COMPLETE_COMMAND` as the first argument, the candidates for the
+  following words are printed to stdout, and with
+  `CLAGS_COMPLETION_SCRIPT_COMMAND` followed by "bash", "zsh" or "fish", the
+  script of that shell. Call it first in `main` and exit if it returns true.
+
+  Arguments:
+    - argc          : the number of arguments
+    - argv          : the array of arguments
+    - config        : pointer to the config with argument definitions
+
+  Returns:
+    bool            : true if a completion command was handled
+*/
+[[nodiscard]] bool clags_handle_completion(int argc, char **argv,
+                                           clags_config_t *config);
+
 /* Logging */
 
 /*
@@ -708,6 +1490,63 @@ void clags_log(clags_config_t *config, clags_log_level_t level,
 void clags_log_sb(clags_config_t *config, clags_log_level_t level,
                   clags_sb_t *sb);
 
+/* Instrumentation */
+
+// counters and timings of the parses on a thread, see `clags_stats_attach`
+// all times are in nanoseconds of a monotonic clock
+typedef struct {
+  uint64_t parses;        // the parses started
+  uint64_t validations;   // the configs validated
+  uint64_t validation_ns; // the time spent validating configs
+  uint64_t sorts;         // the argument tables sorted and indexed
+  uint64_t sort_ns;       // the time spent sorting and indexing
+  uint64_t verifier_calls[CLAGS_VALUE_TYPE_COUNT]; // verifications per type
+  uint64_t verifier_ns[CLAGS_VALUE_TYPE_COUNT];    // their time per type
+  uint64_t path_checks;   // the deferred path checks
+  uint64_t path_check_ns; // the time spent in deferred `stat` calls
+  uint64_t allocations;   // the calls to `CLAGS_CALLOC` and `CLAGS_REALLOC`
+  uint64_t list_reallocs; // the times list storage was grown
+  uint64_t strings_duplicated; // the strings duplicated for the parse state
+  uint64_t bytes_duplicated;   // their size, including the null bytes
+  uint64_t strings_interned;   // the duplications answered with an interned
+                               // string; against `strings_duplicated`, the
+                               // deduplication ratio
+  uint64_t bytes_interned;     // their size, including the null bytes
+  uint64_t subcmd_descents;    // the subcommands entered
+  uint64_t max_subcmd_depth;   // the deepest subcommand nesting, 0 for none
+} clags_parse_stats_t;
+
+/*
+  Add the counters of all following parses on the calling thread to a stats
+  struct, until the function is called with nullptr. Has no effect unless
+  clags is compiled with `CLAGS_STATS` set to 1.
+
+  Arguments:
+    - stats         : pointer to the stats to add to, or nullptr
+*/
+void clags_stats_attach(clags_parse_stats_t *stats);
+
+/* Arena Allocation */
+
+/*
+  Release all strings and list storage allocated from an arena at once. The
+  largest block is kept for reuse by following parses, and the strings
+  interned in the arena are forgotten. Lists backed by the arena must be reset
+  via `clags_list_free` or `clags_config_free` before they are used again.
+
+  Arguments:
+    - arena         : pointer to the arena to reset
+*/
+void clags_arena_reset(clags_arena_t *arena);
+
+/*
+  Free all blocks of an arena.
+
+  Arguments:
+    - arena         : pointer to the arena to free
+*/
+void clags_arena_free(clags_arena_t *arena);
+
 /* String Builder Functionality */
 void clags_sb_appendf(clags_sb_t *sb, const char *format, ...);
 void clags_sb_append_null(clags_sb_t *sb);
@@ -1,9 +1,55 @@
+// `MAP_ANONYMOUS` is not part of strict ISO C modes
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif // _DEFAULT_SOURCE
+// `strtod_l` is a GNU extension in glibc
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif // _GNU_SOURCE
+
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <locale.h>
 #include <math.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifndef __STDC_NO_THREADS__
+#include <threads.h>
+#endif // __STDC_NO_THREADS__
 
 #include "clags/clags.h"
 
+#if CLAGS_SIMD && (defined(__GNUC__) || defined(__clang__))
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define CLAGS__SIMD_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__) &&                           \
+    __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#include <arm_neon.h>
+#define CLAGS__SIMD_NEON 1
+#endif
+#endif // CLAGS_SIMD
+
+// required by POSIX, but declared by no header in strict ISO C modes
+extern char **environ;
+
+// parse the doubles `clags__scan_double` cannot in a "C" locale object with
+// `strtod_l`, instead of reading the global locale with `localeconv`
+#if defined(__GLIBC__)
+#define CLAGS__STRTOD_L 1
+#endif
+
+#if CLAGS_PATH_CHECK_THREADS < 1
+#error "CLAGS_PATH_CHECK_THREADS must be at least 1"
+#endif
+
+#if CLAGS_BATCH_THREADS < 1
+#error "CLAGS_BATCH_THREADS must be at least 1"
+#endif
+
 #define X(type, func, name) [type] = func,
 static clags_verify_func_ptr_t clags__verify_funcs[] = {clags__types};
 #undef X
@@ -18,20 +64,213 @@ clags__is_valid_value_type(clags_value_type_t value_type) {
 static const char *clags__type_names[] = {clags__types};
 #undef X
 
-#ifndef CLAGS_MAX_PARSE_DEPTH
-#define CLAGS_MAX_PARSE_DEPTH 64
-#endif // CLAGS_MAX_PARSE_DEPTH
+// the context of the parse running on this thread, used to route string
+// duplication of verifiers away from the shared config
+static thread_local clags_context_t *clags__active_context = nullptr;
+
+#if CLAGS_STATS
+// the stats the parses on this thread count into, see `clags_stats_attach`
+static thread_local clags_parse_stats_t *clags__stats = nullptr;
+
+// the current time if stats are attached, 0 otherwise
+[[nodiscard]] static inline uint64_t clags__stats_clock() {
+  if (clags__stats == nullptr)
+    return 0;
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1'000'000'000ULL + (uint64_t)ts.tv_nsec;
+}
+
+#define clags__stats_add(field, amount)                                        \
+  do {                                                                         \
+    if (clags__stats != nullptr)                                               \
+      clags__stats->field += (amount);                                         \
+  } while (0)
+#define clags__stats_max(field, value)                                         \
+  do {                                                                         \
+    if (clags__stats != nullptr && clags__stats->field < (value))              \
+      clags__stats->field = (value);                                           \
+  } while (0)
+#else
+#define clags__stats_clock() ((uint64_t)0)
+#define clags__stats_add(field, amount) ((void)0)
+#define clags__stats_max(field, value) ((void)0)
+#endif // CLAGS_STATS
+
+// the heap allocation functions, counting their calls
+[[nodiscard]] static inline void *clags__calloc(size_t count, size_t size) {
+  clags__stats_add(allocations, 1);
+  return CLAGS_CALLOC(count, size);
+}
+[[nodiscard]] static inline void *clags__realloc(void *ptr, size_t size) {
+  clags__stats_add(allocations, 1);
+  return CLAGS_REALLOC(ptr, size);
+}
 
+// run the verifier of a value type, counting its calls and time
 [[nodiscard]] static inline bool
-clags__has_config_cycle(const clags_config_t *parent,
-                        const clags_config_t *candidate) {
-  for (const clags_config_t *current = parent; current != nullptr;
-       current = current->parent) {
-    if (current == candidate) {
-      return true;
+clags__verify(clags_value_type_t value_type, clags_config_t *config,
+              const char *arg_name, const char *arg, void *pvalue, void *data) {
+  [[maybe_unused]] uint64_t started = clags__stats_clock();
+  bool result =
+      clags__verify_funcs[value_type](config, arg_name, arg, pvalue, data);
+  clags__stats_add(verifier_calls[value_type], 1);
+  clags__stats_add(verifier_ns[value_type], clags__stats_clock() - started);
+  return result;
+}
+
+// the error record of the context if there is one, of the config otherwise
+[[nodiscard]] static inline clags_error_record_t *
+clags__error_record(clags_config_t *config, clags_context_t *context) {
+  return context != nullptr ? &context->error_record : &config->error_record;
+}
+
+// record a parse error on the context if there is one, on the config
+// otherwise, and reset the details of the previous one
+static inline void clags__set_error(clags_config_t *config,
+                                    clags_context_t *context,
+                                    clags_error_t error) {
+  if (context != nullptr)
+    context->error = error;
+  else
+    config->error = error;
+  clags_error_record_t *record = clags__error_record(config, context);
+  *record = (clags_error_record_t){.error = error};
+}
+
+// whether `clags_log` would pass a message of this level to a handler
+[[nodiscard]] static inline bool clags__logs(const clags_config_t *config,
+                                             clags_log_level_t level) {
+  return config == nullptr || config->options.min_log_level <= level;
+}
+
+// log without calling into `clags_log`, or evaluating the format arguments,
+// below the config's minimal log level
+#define clags__log(config, level, ...)                                         \
+  do {                                                                         \
+    if (clags__logs((config), (level)))                                        \
+      clags_log((config), (level), __VA_ARGS__);                               \
+  } while (0)
+
+// resolve a `clags_field` offset against the context's variables, if any
+[[nodiscard]] static inline void *clags__variable(clags_context_t *context,
+                                                  void *variable) {
+  if (context == nullptr || context->variables == nullptr ||
+      variable == nullptr)
+    return variable;
+  return (char *)context->variables + ((uintptr_t)variable - 1);
+}
+
+// the shape of a token, as far as the parser dispatches on it
+typedef enum {
+  Clags__Token_Value,  // a positional argument or an option value
+  Clags__Token_Toggle, // exactly `--`
+  Clags__Token_Long,   // `--name` or `--name=value`
+  Clags__Token_Short,  // `-` not followed by a digit
+} clags__token_kind_t;
+
+typedef struct {
+  clags__token_kind_t kind;
+  size_t length;     // the length of the token
+  size_t assignment; // the offset of the first '=', `length` if there is none
+} clags__token_t;
+
+#if defined(CLAGS__SIMD_SSE2) || defined(CLAGS__SIMD_NEON)
+#if defined(CLAGS__SIMD_SSE2)
+// the bits per byte in the masks of `clags__match_block`
+#define CLAGS__MASK_STRIDE 1
+
+// mask the null and '=' bytes of an aligned 16 byte block
+[[gnu::no_sanitize_address]] static inline void
+clags__match_block(const char *block, uint64_t *ends, uint64_t *splits) {
+  __m128i bytes = _mm_load_si128((const __m128i *)block);
+  *ends = (uint32_t)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(bytes, _mm_setzero_si128()));
+  *splits = (uint32_t)_mm_movemask_epi8(
+      _mm_cmpeq_epi8(bytes, _mm_set1_epi8('=')));
+}
+#else
+#define CLAGS__MASK_STRIDE 4
+
+// NEON has no byte movemask, narrowing the comparison keeps 4 bits per byte
+static inline uint64_t clags__narrow_mask(uint8x16_t matches) {
+  uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+
+[[gnu::no_sanitize_address]] static inline void
+clags__match_block(const char *block, uint64_t *ends, uint64_t *splits) {
+  uint8x16_t bytes = vld1q_u8((const uint8_t *)block);
+  *ends = clags__narrow_mask(vceqq_u8(bytes, vdupq_n_u8(0)));
+  *splits = clags__narrow_mask(vceqq_u8(bytes, vdupq_n_u8('=')));
+}
+#endif
+
+// find the length of a token and its first '=' 16 bytes at a time. The
+// aligned blocks may extend past the null byte, but never into another page
+[[gnu::no_sanitize_address]] static inline void
+clags__scan_token_bytes(const char *token, size_t *length,
+                        size_t *assignment) {
+  const char *block = (const char *)((uintptr_t)token & ~(uintptr_t)15);
+  uint64_t valid = UINT64_MAX << ((size_t)(token - block) * CLAGS__MASK_STRIDE);
+  *assignment = SIZE_MAX;
+  for (;; block += 16, valid = UINT64_MAX) {
+    uint64_t ends = 0;
+    uint64_t splits = 0;
+    clags__match_block(block, &ends, &splits);
+    ends &= valid;
+    splits &= valid;
+    // drop the '=' bytes behind the end of the token
+    if (ends != 0)
+      splits &= (ends & -ends) - 1;
+    if (splits != 0 && *assignment == SIZE_MAX)
+      *assignment = (size_t)(block - token) +
+                    (size_t)__builtin_ctzll(splits) / CLAGS__MASK_STRIDE;
+    if (ends != 0) {
+      *length = (size_t)(block - token) +
+                (size_t)__builtin_ctzll(ends) / CLAGS__MASK_STRIDE;
+      return;
     }
   }
-  return false;
+}
+#else
+// find the length of a token and its first '=', leaving the byte loops to
+// the C library, whose string functions are usually vectorized themselves
+static inline void clags__scan_token_bytes(const char *token, size_t *length,
+                                           size_t *assignment) {
+  *length = strlen(token);
+  const char *split = memchr(token, '=', *length);
+  *assignment = split != nullptr ? (size_t)(split - token) : SIZE_MAX;
+}
+#endif // CLAGS__SIMD_SSE2 || CLAGS__SIMD_NEON
+
+// classify a token, replacing the separate comparisons of every token rule
+[[nodiscard]] static inline clags__token_t
+clags__scan_token(const char *token) {
+  clags__token_t result = {0};
+  clags__scan_token_bytes(token, &result.length, &result.assignment);
+  if (result.assignment > result.length)
+    result.assignment = result.length;
+  if (token[0] == '-' && token[1] == '-')
+    result.kind = result.length == 2 ? Clags__Token_Toggle : Clags__Token_Long;
+  else if (token[0] == '-' && !isdigit((unsigned char)token[1]))
+    result.kind = Clags__Token_Short;
+  return result;
+}
+
+// whether a scanned token starts with, or equals, a string of known length
+[[nodiscard]] static inline bool
+clags__token_starts_with(const char *arg, const clags__token_t *token,
+                         const char *prefix, size_t prefix_length) {
+  return prefix != nullptr && token->length >= prefix_length &&
+         memcmp(arg, prefix, prefix_length) == 0;
+}
+
+[[nodiscard]] static inline bool
+clags__token_equals(const char *arg, const clags__token_t *token,
+                    const char *string, size_t string_length) {
+  return string != nullptr && token->length == string_length &&
+         memcmp(arg, string, string_length) == 0;
 }
 
 [[nodiscard]] static inline bool
@@ -62,19 +301,78 @@ clags__checked_mul_size(size_t *result, size_t lhs, size_t rhs) {
 #endif
 }
 
-static inline const char *clags__skip_space(const char *value) {
-  if (value == nullptr) {
-    return nullptr;
+[[nodiscard]] static inline bool
+clags__checked_add_u64(uint64_t *result, uint64_t lhs, uint64_t rhs) {
+#if CLAGS_HAS_STDCKDINT
+  return ckd_add(result, lhs, rhs);
+#elif defined(__GNUC__) || defined(__clang__)
+  return __builtin_add_overflow(lhs, rhs, result);
+#else
+  if (UINT64_MAX - lhs < rhs)
+    return true;
+  *result = lhs + rhs;
+  return false;
+#endif
+}
+
+[[nodiscard]] static inline bool
+clags__checked_mul_u64(uint64_t *result, uint64_t lhs, uint64_t rhs) {
+#if CLAGS_HAS_STDCKDINT
+  return ckd_mul(result, lhs, rhs);
+#elif defined(__GNUC__) || defined(__clang__)
+  return __builtin_mul_overflow(lhs, rhs, result);
+#else
+  if (lhs != 0 && rhs > UINT64_MAX / lhs)
+    return true;
+  *result = lhs * rhs;
+  return false;
+#endif
+}
+
+// the whitespace skipped in front of numbers, as in the "C" locale
+[[nodiscard]] static inline bool clags__is_space(char c) {
+  return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+// fold an ASCII letter to lower case, independent of the locale
+[[nodiscard]] static inline char clags__lower(char c) {
+  return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+}
+
+// FNV-1a over a string, folding ASCII case if requested
+[[nodiscard]] static inline uint64_t clags__string_hash(const char *value,
+                                                        bool fold_case) {
+  uint64_t hash = 0xCBF2'9CE4'8422'2325ULL;
+  for (const char *c = value; *c != '\0'; ++c) {
+    hash ^= (unsigned char)(fold_case ? clags__lower(*c) : *c);
+    hash *= 0x0000'0100'0000'01B3ULL;
   }
-  while (*value != '\0' && isspace((unsigned char)*value)) {
-    value++;
+  return hash;
+}
+
+// FNV-1a over the first `length` bytes of a string, equal to the unfolded
+// `clags__string_hash` of that prefix
+[[nodiscard]] static inline uint64_t clags__prefix_hash(const char *value,
+                                                        size_t length) {
+  uint64_t hash = 0xCBF2'9CE4'8422'2325ULL;
+  for (size_t i = 0; i < length; ++i) {
+    hash ^= (unsigned char)value[i];
+    hash *= 0x0000'0100'0000'01B3ULL;
   }
-  return value;
+  return hash;
 }
 
-[[nodiscard]] static inline bool clags__has_sign_prefix(const char *value) {
-  const char *trimmed = clags__skip_space(value);
-  return trimmed != nullptr && (*trimmed == '-' || *trimmed == '+');
+// the power of two slot count keeping an index of `count` keys half empty
+[[nodiscard]] static size_t clags__index_capacity(size_t count) {
+  size_t required = 0;
+  clags_assert(!clags__checked_mul_size(&required, count, (size_t)2),
+               "Index capacity overflow!");
+  size_t capacity = 1;
+  while (capacity < required) {
+    clags_assert(!clags__checked_mul_size(&capacity, capacity, (size_t)2),
+                 "Index capacity overflow!");
+  }
+  return capacity;
 }
 
 [[nodiscard]] static inline bool clags__is_empty_string(const char *value) {
@@ -145,7 +443,7 @@ clags__list_expected_item_size(clags_value_type_t value_type,
   size_t alloc_size = 0;
   clags_assert(!clags__checked_add_size(&alloc_size, length, (size_t)1),
                "String duplication size overflow!");
-  char *new_string = CLAGS_CALLOC(alloc_size, sizeof(char));
+  char *new_string = clags__calloc(alloc_size, sizeof(char));
   clags_assert(new_string != nullptr, "Out of memory!");
   memcpy(new_string, string, alloc_size);
   return new_string;
@@ -180,6 +478,31 @@ clags__next_capacity(size_t current, size_t required, size_t *next) {
   return true;
 }
 
+// append a copy of an item to a heap allocated list
+static void clags__list_push(clags_list_t *list, const void *item) {
+  if (list->count >= list->capacity) {
+    size_t required_capacity = 0;
+    clags_assert(
+        !clags__checked_add_size(&required_capacity, list->count, (size_t)1),
+        "List capacity overflow!");
+    size_t new_capacity = 0;
+    clags_assert(clags__next_capacity(list->capacity, required_capacity,
+                                      &new_capacity),
+                 "List capacity overflow!");
+    size_t alloc_size = 0;
+    clags_assert(
+        !clags__checked_mul_size(&alloc_size, list->item_size, new_capacity),
+        "List allocation size overflow!");
+    list->items = clags__realloc(list->items, alloc_size);
+    clags_assert(list->items != nullptr, "Out of memory!");
+    list->capacity = new_capacity;
+    clags__stats_add(list_reallocs, 1);
+  }
+  memcpy((char *)list->items + list->count * list->item_size, item,
+         list->item_size);
+  list->count++;
+}
+
 static inline void clags__sb_reserve(clags_sb_t *sb, size_t capacity) {
   if (sb->capacity >= capacity)
     return;
@@ -190,22 +513,44 @@ static inline void clags__sb_reserve(clags_sb_t *sb, size_t capacity) {
   clags_assert(
       !clags__checked_mul_size(&alloc_size, new_capacity, sizeof(*sb->items)),
       "String builder allocation overflow!");
-  sb->items = CLAGS_REALLOC(sb->items, alloc_size);
+  sb->items = clags__realloc(sb->items, alloc_size);
   clags_assert(sb->items != nullptr, "Out of memory!");
   sb->capacity = new_capacity;
 }
 
+// append raw bytes, without a terminating null byte
+static void clags__sb_append(clags_sb_t *sb, const char *data, size_t length) {
+  size_t capacity = 0;
+  clags_assert(!clags__checked_add_size(&capacity, sb->count, length),
+               "String builder length overflow!");
+  clags__sb_reserve(sb, capacity);
+  memcpy(sb->items + sb->count, data, length);
+  sb->count = capacity;
+}
+
+static inline void clags__sb_append_cstr(clags_sb_t *sb, const char *string) {
+  clags__sb_append(sb, string, strlen(string));
+}
+
 void clags_sb_appendf(clags_sb_t *sb, const char *format, ...) {
   va_list args, args_copy;
 
   va_start(args, format);
   va_copy(args_copy, args);
 
-  int n = vsnprintf(nullptr, 0, format, args_copy);
+  // format in place if the spare capacity suffices, measure otherwise
+  size_t available = sb->capacity - sb->count;
+  int n = vsnprintf(available > 0 ? sb->items + sb->count : nullptr,
+                    available, format, args_copy);
   va_end(args_copy);
   clags_assert(n >= 0, "Failed to format string!");
 
   size_t formatted_len = (size_t)n;
+  if (formatted_len < available) {
+    va_end(args);
+    sb->count += formatted_len;
+    return;
+  }
   size_t capacity = 0;
   clags_assert(!clags__checked_add_size(&capacity, sb->count, formatted_len),
                "String builder length overflow!");
@@ -236,6 +581,152 @@ void clags_sb_free(clags_sb_t *sb) {
   sb->count = sb->capacity = 0;
 }
 
+void clags_stats_attach([[maybe_unused]] clags_parse_stats_t *stats) {
+#if CLAGS_STATS
+  clags__stats = stats;
+#endif // CLAGS_STATS
+}
+
+struct clags_arena_block_t {
+  clags_arena_block_t *next;
+  size_t capacity;
+  size_t used;
+  alignas(max_align_t) unsigned char data[];
+};
+
+// the active arena, the context's takes precedence over the config's
+[[nodiscard]] static inline clags_arena_t *
+clags__arena(const clags_config_t *config) {
+  if (clags__active_context != nullptr &&
+      clags__active_context->arena != nullptr)
+    return clags__active_context->arena;
+  return config != nullptr ? config->options.arena : nullptr;
+}
+
+[[nodiscard]] static inline size_t clags__align_up(size_t value,
+                                                   size_t alignment) {
+  size_t aligned = 0;
+  clags_assert(!clags__checked_add_size(&aligned, value, alignment - 1),
+               "Arena allocation size overflow!");
+  return aligned & ~(alignment - 1);
+}
+
+[[nodiscard]] static void *
+clags__arena_alloc(clags_arena_t *arena, size_t size, size_t alignment) {
+  clags_arena_block_t *block = arena->blocks;
+  if (block != nullptr) {
+    size_t offset = clags__align_up(block->used, alignment);
+    if (offset <= block->capacity && size <= block->capacity - offset) {
+      block->used = offset + size;
+      return block->data + offset;
+    }
+  }
+  size_t capacity =
+      arena->block_size != 0 ? arena->block_size : CLAGS_ARENA_BLOCK_SIZE;
+  if (capacity < size)
+    capacity = size;
+  size_t alloc_size = 0;
+  clags_assert(!clags__checked_add_size(&alloc_size, sizeof(*block), capacity),
+               "Arena allocation size overflow!");
+  block = clags__calloc(1, alloc_size);
+  clags_assert(block != nullptr, "Out of memory!");
+  block->capacity = capacity;
+  block->used = size;
+  block->next = arena->blocks;
+  arena->blocks = block;
+  return block->data;
+}
+
+// grow the last allocation of the newest block in place if it fits, otherwise
+// move it into a fresh allocation
+[[nodiscard]] static void *clags__arena_realloc(clags_arena_t *arena,
+                                                void *ptr, size_t old_size,
+                                                size_t new_size) {
+  clags_arena_block_t *block = arena->blocks;
+  if (ptr != nullptr && block != nullptr &&
+      (unsigned char *)ptr + old_size == block->data + block->used) {
+    size_t offset = block->used - old_size;
+    if (new_size <= block->capacity - offset) {
+      block->used = offset + new_size;
+      return ptr;
+    }
+  }
+  void *moved = clags__arena_alloc(arena, new_size, alignof(max_align_t));
+  if (ptr != nullptr && old_size != 0)
+    memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+  return moved;
+}
+
+// the slot of an interned string equal to `string`, or the empty slot it
+// belongs in, growing the table to keep it half empty
+[[nodiscard]] static char **clags__intern_slot(clags_interned_t *interned,
+                                               const char *string) {
+  if (interned->count + 1 > interned->capacity / 2) {
+    size_t capacity = clags__index_capacity(interned->count + 1);
+    char **slots = clags__calloc(capacity, sizeof(*slots));
+    clags_assert(slots != nullptr, "Out of memory!");
+    for (size_t i = 0; i < interned->capacity; ++i) {
+      char *value = interned->slots[i];
+      if (value == nullptr)
+        continue;
+      size_t slot = (size_t)clags__string_hash(value, false) & (capacity - 1);
+      while (slots[slot] != nullptr)
+        slot = (slot + 1) & (capacity - 1);
+      slots[slot] = value;
+    }
+    CLAGS_FREE(interned->slots);
+    interned->slots = slots;
+    interned->capacity = capacity;
+  }
+  size_t mask = interned->capacity - 1;
+  size_t slot = (size_t)clags__string_hash(string, false) & mask;
+  while (interned->slots[slot] != nullptr &&
+         strcmp(interned->slots[slot], string) != 0)
+    slot = (slot + 1) & mask;
+  return &interned->slots[slot];
+}
+
+static void clags__intern_free(clags_interned_t *interned) {
+  CLAGS_FREE(interned->slots);
+  *interned = (clags_interned_t){0};
+}
+
+void clags_arena_reset(clags_arena_t *arena) {
+  if (arena == nullptr)
+    return;
+  clags_arena_block_t *largest = nullptr;
+  clags_arena_block_t *block = arena->blocks;
+  while (block != nullptr) {
+    clags_arena_block_t *next = block->next;
+    if (largest == nullptr || block->capacity > largest->capacity) {
+      CLAGS_FREE(largest);
+      largest = block;
+    } else {
+      CLAGS_FREE(block);
+    }
+    block = next;
+  }
+  if (largest != nullptr) {
+    largest->next = nullptr;
+    largest->used = 0;
+  }
+  arena->blocks = largest;
+  clags__intern_free(&arena->interned);
+}
+
+void clags_arena_free(clags_arena_t *arena) {
+  if (arena == nullptr)
+    return;
+  clags_arena_block_t *block = arena->blocks;
+  while (block != nullptr) {
+    clags_arena_block_t *next = block->next;
+    CLAGS_FREE(block);
+    block = next;
+  }
+  arena->blocks = nullptr;
+  clags__intern_free(&arena->interned);
+}
+
 void clags__default_log_handler(clags_log_level_t level, const char *format,
                                 va_list args) {
   switch (level) {
@@ -282,7 +773,8 @@ void clags_log(clags_config_t *config, clags_log_level_t level,
 
 void clags_log_sb(clags_config_t *config, clags_log_level_t level,
                   clags_sb_t *sb) {
-  clags_log(config, level, "%s", sb->items);
+  clags__log(config, level, "%.*s", (int)sb->count,
+             sb->items ? sb->items : "");
 }
 
 [[nodiscard]] char *clags_config_duplicate_string(clags_config_t *config,
@@ -290,34 +782,45 @@ void clags_log_sb(clags_config_t *config, clags_log_level_t level,
   if (config == nullptr)
     return (char *)string;
   char *duplicate;
+  clags_arena_t *arena = clags__arena(config);
   if (config->options.duplicate_strings) {
+    clags__stats_add(strings_duplicated, 1);
+    clags__stats_add(bytes_duplicated, strlen(string) + 1);
+  }
+  // equal strings share one duplicate per pool, the pool owning the table
+  char **interned = nullptr;
+  if (config->options.duplicate_strings && config->options.intern_strings) {
+    clags_interned_t *table = arena != nullptr ? &arena->interned
+                              : clags__active_context != nullptr
+                                  ? &clags__active_context->interned
+                                  : &config->interned;
+    interned = clags__intern_slot(table, string);
+    if (*interned != nullptr) {
+      clags__stats_add(strings_interned, 1);
+      clags__stats_add(bytes_interned, strlen(string) + 1);
+      return *interned;
+    }
+    table->count++;
+  }
+  if (config->options.duplicate_strings && arena != nullptr) {
+    size_t length = strlen(string);
+    duplicate = clags__arena_alloc(arena, length + 1, 1);
+    memcpy(duplicate, string, length + 1);
+  } else if (config->options.duplicate_strings) {
     duplicate = clags__strdup(string);
     clags_assert(duplicate != nullptr, "Out of memory!");
 
-    clags_list_t *allocs = &config->allocs;
+    clags_list_t *allocs = clags__active_context != nullptr
+                               ? &clags__active_context->allocs
+                               : &config->allocs;
     if (allocs->item_size == 0)
       allocs->item_size = sizeof(char *);
-    if (allocs->count >= allocs->capacity) {
-      size_t required_capacity = 0;
-      clags_assert(!clags__checked_add_size(&required_capacity, allocs->count,
-                                            (size_t)1),
-                   "Allocation tracking capacity overflow!");
-      size_t new_capacity = 0;
-      clags_assert(clags__next_capacity(allocs->capacity, required_capacity,
-                                        &new_capacity),
-                   "Allocation tracking capacity overflow!");
-      size_t alloc_size = 0;
-      clags_assert(!clags__checked_mul_size(&alloc_size, allocs->item_size,
-                                            new_capacity),
-                   "Allocation tracking size overflow!");
-      allocs->items = CLAGS_REALLOC(allocs->items, alloc_size);
-      clags_assert(allocs->items != nullptr, "Out of memory!");
-      allocs->capacity = new_capacity;
-    }
-    ((char **)allocs->items)[allocs->count++] = duplicate;
+    clags__list_push(allocs, &duplicate);
   } else {
     duplicate = (char *)string;
   }
+  if (interned != nullptr)
+    *interned = duplicate;
   return duplicate;
 }
 
@@ -344,31 +847,131 @@ bool clags__verify_bool(clags_config_t *config, const char *arg_name,
       *(bool *)pvalue = false;
     return true;
   }
-  clags_log(config, Clags_Error,
-            "Invalid boolean value for argument '%s': '%s'!", arg_name, arg);
+  clags__log(config, Clags_Error,
+             "Invalid boolean value for argument '%s': '%s'!", arg_name, arg);
   return false;
 }
 
-bool clags__verify_int8(clags_config_t *config, const char *arg_name,
-                        const char *arg, void *pvalue,
-                        [[maybe_unused]] void *data) {
-  char *endptr;
-  errno = 0;
-  long value = strtol(arg, &endptr, 0);
+// the outcome of scanning an integer literal
+typedef enum {
+  Clags__Scan_Ok,
+  Clags__Scan_Invalid,  // no digits
+  Clags__Scan_Overflow, // the magnitude exceeds `UINT64_MAX`
+} clags__scan_status_t;
+
+[[nodiscard]] static inline unsigned clags__digit_value(char c) {
+  if (c >= '0' && c <= '9')
+    return (unsigned)(c - '0');
+  c = clags__lower(c);
+  if (c >= 'a' && c <= 'f')
+    return (unsigned)(c - 'a' + 10);
+  return 16;
+}
+
+/*
+  Scan an integer like `strtoull`, independent of the locale: leading
+  whitespace, an optional sign and, with base 0, a "0x" prefix for hexadecimal
+  and a leading '0' for octal numbers. All digits are consumed even if the
+  magnitude overflows, so `end` always points behind the literal.
+*/
+[[nodiscard]] static clags__scan_status_t
+clags__scan_integer(const char *arg, unsigned base, char *sign,
+                    uint64_t *magnitude, const char **end) {
+  const char *c = arg;
+  while (clags__is_space(*c))
+    c++;
+  *sign = '\0';
+  if (*c == '+' || *c == '-')
+    *sign = *c++;
+  if (base == 0) {
+    base = 10;
+    if (c[0] == '0') {
+      base = 8;
+      if (clags__lower(c[1]) == 'x' && clags__digit_value(c[2]) < 16) {
+        base = 16;
+        c += 2;
+      }
+    }
+  }
+
+  const char *digits = c;
+  uint64_t value = 0;
+  bool overflow = false;
+  for (unsigned digit; (digit = clags__digit_value(*c)) < base; ++c) {
+    overflow = overflow || clags__checked_mul_u64(&value, value, base) ||
+               clags__checked_add_u64(&value, value, digit);
+  }
+  *magnitude = value;
+  if (c == digits) {
+    *end = arg;
+    return Clags__Scan_Invalid;
+  }
+  *end = c;
+  return overflow ? Clags__Scan_Overflow : Clags__Scan_Ok;
+}
+
+// the shared core of the signed integer verifiers
+[[nodiscard]] static bool
+clags__parse_signed(clags_config_t *config, const char *arg_name,
+                    const char *arg, const char *type_name, int64_t min,
+                    int64_t max, int64_t *value) {
+  char sign;
+  uint64_t magnitude;
+  const char *end;
+  clags__scan_status_t status =
+      clags__scan_integer(arg, 0, &sign, &magnitude, &end);
+  if (status == Clags__Scan_Invalid || *end != '\0') {
+    clags__log(config, Clags_Error, "Invalid %s value for argument '%s': '%s'!",
+               type_name, arg_name, arg);
+    return false;
+  }
+  // the magnitude of `min` is computed without overflowing on INT64_MIN
+  uint64_t limit =
+      sign == '-' ? (uint64_t)(-(min + 1)) + 1 : (uint64_t)max;
+  if (status == Clags__Scan_Overflow || magnitude > limit) {
+    clags__log(config, Clags_Error,
+               "%s value out of range (%" PRId64 " to %" PRId64
+               ") for argument '%s': '%s'!",
+               type_name, min, max, arg_name, arg);
+    return false;
+  }
+  if (sign == '-' && magnitude != 0)
+    *value = -(int64_t)(magnitude - 1) - 1;
+  else
+    *value = (int64_t)magnitude;
+  return true;
+}
 
-  if (endptr == arg || *endptr != '\0') {
-    clags_log(config, Clags_Error,
-              "Invalid int8 value for argument '%s': '%s'!", arg_name, arg);
+// the shared core of the unsigned integer verifiers, which reject any sign
+[[nodiscard]] static bool
+clags__parse_unsigned(clags_config_t *config, const char *arg_name,
+                      const char *arg, const char *type_name, uint64_t max,
+                      uint64_t *value) {
+  char sign;
+  const char *end;
+  clags__scan_status_t status = clags__scan_integer(arg, 0, &sign, value, &end);
+  if (status == Clags__Scan_Invalid || *end != '\0') {
+    clags__log(config, Clags_Error, "Invalid %s value for argument '%s': '%s'!",
+               type_name, arg_name, arg);
     return false;
   }
-  if (errno == ERANGE || value < INT8_MIN || value > INT8_MAX) {
-    clags_log(config, Clags_Error,
-              "int8 value out of range (%" PRId8 " to %" PRId8
-              ") for argument '%s': '%s'!",
-              INT8_MIN, INT8_MAX, arg_name, arg);
+  if (status == Clags__Scan_Overflow || *value > max || sign != '\0') {
+    clags__log(config, Clags_Error,
+               "%s value out of range (0 to %" PRIu64
+               ") for argument '%s': '%s'!",
+               type_name, max, arg_name, arg);
     return false;
   }
+  return true;
+}
 
+bool clags__verify_int8(clags_config_t *config, const char *arg_name,
+                        const char *arg, void *pvalue,
+                        [[maybe_unused]] void *data) {
+  int64_t value;
+  if (!clags__parse_signed(config, arg_name, arg, "int8", INT8_MIN, INT8_MAX,
+                           &value))
+    return false;
   if (pvalue)
     *(int8_t *)pvalue = (int8_t)value;
   return true;
@@ -377,23 +980,10 @@ bool clags__verify_int8(clags_config_t *config, const char *arg_name,
 bool clags__verify_uint8(clags_config_t *config, const char *arg_name,
                          const char *arg, void *pvalue,
                          [[maybe_unused]] void *data) {
-  char *endptr;
-  errno = 0;
-  unsigned long value = strtoul(arg, &endptr, 0);
-
-  if (endptr == arg || *endptr != '\0') {
-    clags_log(config, Clags_Error,
-              "Invalid uint8 value for argument '%s': '%s'!", arg_name, arg);
-    return false;
-  }
-  if (errno == ERANGE || value > UINT8_MAX || clags__has_sign_prefix(arg)) {
-    clags_log(config, Clags_Error,
-              "uint8 value out of range (0 to %" PRIu8
-              ") for argument '%s': '%s'!",
-              UINT8_MAX, arg_name, arg);
+  uint64_t value;
+  if (!clags__parse_unsigned(config, arg_name, arg, "uint8", UINT8_MAX,
+                             &value))
     return false;
-  }
-
   if (pvalue)
     *(uint8_t *)pvalue = (uint8_t)value;
   return true;
@@ -402,23 +992,10 @@ bool clags__verify_uint8(clags_config_t *config, const char *arg_name,
 bool clags__verify_int32(clags_config_t *config, const char *arg_name,
                          const char *arg, void *pvalue,
                          [[maybe_unused]] void *data) {
-  char *endptr;
-  errno = 0;
-  long value = strtol(arg, &endptr, 0);
-
-  if (endptr == arg || *endptr != '\0') {
-    clags_log(config, Clags_Error,
-              "Invalid int32 value for argument '%s': '%s'!", arg_name, arg);
+  int64_t value;
+  if (!clags__parse_signed(config, arg_name, arg, "int32", INT32_MIN,
+                           INT32_MAX, &value))
     return false;
-  }
-  if (errno == ERANGE || value < INT32_MIN || value > INT32_MAX) {
-    clags_log(config, Clags_Error,
-              "int32 value out of range (%" PRId32 " to %" PRId32
-              ") for argument '%s': '%s'!",
-              INT32_MIN, INT32_MAX, arg_name, arg);
-    return false;
-  }
-
   if (pvalue)
     *(int32_t *)pvalue = (int32_t)value;
   return true;
@@ -427,23 +1004,10 @@ bool clags__verify_int32(clags_config_t *config, const char *arg_name,
 bool clags__verify_uint32(clags_config_t *config, const char *arg_name,
                           const char *arg, void *pvalue,
                           [[maybe_unused]] void *data) {
-  char *endptr;
-  errno = 0;
-  unsigned long value = strtoul(arg, &endptr, 0);
-
-  if (endptr == arg || *endptr != '\0') {
-    clags_log(config, Clags_Error,
-              "Invalid uint32 value for argument '%s': '%s'!", arg_name, arg);
-    return false;
-  }
-  if (errno == ERANGE || value > UINT32_MAX || clags__has_sign_prefix(arg)) {
-    clags_log(config, Clags_Error,
-              "uint32 value out of range (0 to %" PRIu32
-              ") for argument '%s': '%s'!",
-              UINT32_MAX, arg_name, arg);
+  uint64_t value;
+  if (!clags__parse_unsigned(config, arg_name, arg, "uint32", UINT32_MAX,
+                             &value))
     return false;
-  }
-
   if (pvalue)
     *(uint32_t *)pvalue = (uint32_t)value;
   return true;
@@ -452,70 +1016,210 @@ bool clags__verify_uint32(clags_config_t *config, const char *arg_name,
 bool clags__verify_int64(clags_config_t *config, const char *arg_name,
                          const char *arg, void *pvalue,
                          [[maybe_unused]] void *data) {
-  char *endptr;
-  errno = 0;
-  long long value = strtoll(arg, &endptr, 0);
-
-  if (endptr == arg || *endptr != '\0') {
-    clags_log(config, Clags_Error,
-              "Invalid int64 value for argument '%s': '%s'!", arg_name, arg);
-    return false;
-  }
-  if (errno == ERANGE || value < INT64_MIN || value > INT64_MAX) {
-    clags_log(config, Clags_Error,
-              "int64 value out of range (%" PRId64 " to %" PRId64
-              ") for argument '%s': '%s'!",
-              INT64_MIN, INT64_MAX, arg_name, arg);
+  int64_t value;
+  if (!clags__parse_signed(config, arg_name, arg, "int64", INT64_MIN,
+                           INT64_MAX, &value))
     return false;
-  }
-
   if (pvalue)
-    *(int64_t *)pvalue = (int64_t)value;
+    *(int64_t *)pvalue = value;
   return true;
 }
 
 bool clags__verify_uint64(clags_config_t *config, const char *arg_name,
                           const char *arg, void *pvalue,
                           [[maybe_unused]] void *data) {
+  uint64_t value;
+  if (!clags__parse_unsigned(config, arg_name, arg, "uint64", UINT64_MAX,
+                             &value))
+    return false;
+  if (pvalue)
+    *(uint64_t *)pvalue = value;
+  return true;
+}
+
+#if CLAGS__STRTOD_L
+static locale_t clags__c_locale_object = (locale_t)0;
+
+static void clags__init_c_locale(void) {
+  clags__c_locale_object = newlocale(LC_NUMERIC_MASK, "C", (locale_t)0);
+}
+
+// the "C" locale, created once on first use; (locale_t)0 if that failed
+[[nodiscard]] static locale_t clags__c_locale() {
+#ifndef __STDC_NO_THREADS__
+  static once_flag once = ONCE_FLAG_INIT;
+  call_once(&once, clags__init_c_locale);
+#else
+  if (clags__c_locale_object == (locale_t)0)
+    clags__init_c_locale();
+#endif // __STDC_NO_THREADS__
+  return clags__c_locale_object;
+}
+#endif // CLAGS__STRTOD_L
+
+// `strtod` in the "C" locale: with `strtod_l` where available, otherwise on a
+// copy that ends in front of the locale's decimal point and has it in place
+// of '.', which reads `localeconv` and is not thread-safe
+[[nodiscard]] static double clags__strtod(const char *arg, const char **end,
+                                          bool *out_of_range) {
   char *endptr;
   errno = 0;
-  unsigned long long value = strtoull(arg, &endptr, 0);
-
-  if (endptr == arg || *endptr != '\0') {
-    clags_log(config, Clags_Error,
-              "Invalid uint64 value for argument '%s': '%s'!", arg_name, arg);
-    return false;
+#if CLAGS__STRTOD_L
+  locale_t c_locale = clags__c_locale();
+  if (c_locale != (locale_t)0) {
+    double value = strtod_l(arg, &endptr, c_locale);
+    *out_of_range = errno == ERANGE;
+    *end = endptr;
+    return value;
   }
-  if (errno == ERANGE || value > UINT64_MAX || clags__has_sign_prefix(arg)) {
-    clags_log(config, Clags_Error,
-              "uint64 value out of range (0 to %" PRIu64
-              ") for argument '%s': '%s'!",
-              UINT64_MAX, arg_name, arg);
-    return false;
+#endif // CLAGS__STRTOD_L
+  const char *point = localeconv()->decimal_point;
+  if (point == nullptr || *point == '\0' || strcmp(point, ".") == 0) {
+    double value = strtod(arg, &endptr);
+    *out_of_range = errno == ERANGE;
+    *end = endptr;
+    return value;
   }
+  const char *cut = strstr(arg, point);
+  size_t length = cut != nullptr ? (size_t)(cut - arg) : strlen(arg);
+  const char *dot = memchr(arg, '.', length);
+  size_t prefix = dot != nullptr ? (size_t)(dot - arg) : length;
+  size_t point_length = dot != nullptr ? strlen(point) : 0;
+  size_t suffix = dot != nullptr ? length - prefix - 1 : 0;
+
+  char buffer[128];
+  size_t size = prefix + point_length + suffix + 1;
+  char *copy = size <= sizeof(buffer) ? buffer : clags__calloc(size, 1);
+  clags_assert(copy != nullptr, "Out of memory!");
+  memcpy(copy, arg, prefix);
+  memcpy(copy + prefix, point, point_length);
+  if (suffix > 0)
+    memcpy(copy + prefix + point_length, dot + 1, suffix);
+  copy[size - 1] = '\0';
+  errno = 0;
+  double value = strtod(copy, &endptr);
+  *out_of_range = errno == ERANGE;
+  size_t consumed = (size_t)(endptr - copy);
+  if (dot != nullptr && consumed > prefix)
+    consumed = consumed < prefix + point_length ? prefix
+                                                : consumed - point_length + 1;
+  *end = arg + consumed;
+  if (copy != buffer)
+    CLAGS_FREE(copy);
+  return value;
+}
 
-  if (pvalue)
-    *(uint64_t *)pvalue = (uint64_t)value;
-  return true;
+/*
+  Scan a floating-point number like `strtod`, independent of the locale.
+  Decimal numbers of at most 19 significant digits whose mantissa and power of
+  ten are exact doubles are computed with a single correctly rounded
+  operation, all others are left to `clags__strtod`. `end` points behind the
+  number, or at `arg` if there is none.
+*/
+[[nodiscard]] static double clags__scan_double(const char *arg,
+                                               const char **end,
+                                               bool *out_of_range) {
+  static const double powers[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                                  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                  1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                                  1e18, 1e19, 1e20, 1e21, 1e22};
+  const char *c = arg;
+  while (clags__is_space(*c))
+    c++;
+  bool negative = *c == '-';
+  if (*c == '+' || *c == '-')
+    c++;
+  // hexadecimal, infinite and NaN values
+  if ((c[0] == '0' && clags__lower(c[1]) == 'x') ||
+      clags__lower(*c) == 'i' || clags__lower(*c) == 'n')
+    return clags__strtod(arg, end, out_of_range);
+
+  uint64_t mantissa = 0;
+  int64_t exponent = 0;
+  size_t digits = 0;
+  size_t significant = 0;
+  for (; *c >= '0' && *c <= '9'; ++c, ++digits) {
+    if (significant < 19) {
+      mantissa = mantissa * 10 + (uint64_t)(*c - '0');
+      significant += mantissa != 0;
+    } else {
+      significant++;
+    }
+  }
+  if (*c == '.') {
+    for (++c; *c >= '0' && *c <= '9'; ++c, ++digits) {
+      if (significant < 19) {
+        mantissa = mantissa * 10 + (uint64_t)(*c - '0');
+        significant += mantissa != 0;
+        exponent--;
+      } else {
+        significant++;
+      }
+    }
+  }
+  if (digits == 0) {
+    *end = arg;
+    *out_of_range = false;
+    return 0.0;
+  }
+  if (clags__lower(*c) == 'e') {
+    const char *e = c + 1;
+    bool negative_exponent = *e == '-';
+    if (*e == '+' || *e == '-')
+      e++;
+    if (*e >= '0' && *e <= '9') {
+      int64_t value = 0;
+      for (; *e >= '0' && *e <= '9'; ++e) {
+        if (value < 100'000)
+          value = value * 10 + (*e - '0');
+      }
+      exponent += negative_exponent ? -value : value;
+      c = e;
+    }
+  }
+  if (significant > 19)
+    return clags__strtod(arg, end, out_of_range);
+
+  // powers beyond 1e22 are exact if the mantissa takes their excess digits
+  double value = 0.0;
+  bool exact = FLT_EVAL_METHOD == 0 && mantissa <= (1ULL << 53);
+  if (mantissa == 0) {
+    value = 0.0;
+  } else if (exact && exponent < 0 && exponent >= -22) {
+    value = (double)mantissa / powers[-exponent];
+  } else if (exact && exponent >= 0 && exponent <= 22) {
+    value = (double)mantissa * powers[exponent];
+  } else if (exact && exponent > 22 && exponent <= 22 + 15 &&
+             !clags__checked_mul_u64(&mantissa, mantissa,
+                                     (uint64_t)powers[exponent - 22]) &&
+             mantissa <= (1ULL << 53)) {
+    value = (double)mantissa * powers[22];
+  } else {
+    return clags__strtod(arg, end, out_of_range);
+  }
+  *end = c;
+  *out_of_range = false;
+  return negative ? -value : value;
 }
 
 bool clags__verify_double(clags_config_t *config, const char *arg_name,
                           const char *arg, void *pvalue,
                           [[maybe_unused]] void *data) {
-  char *endptr;
-  errno = 0;
-  double value = strtod(arg, &endptr);
+  const char *end;
+  bool out_of_range;
+  double value = clags__scan_double(arg, &end, &out_of_range);
 
-  if (endptr == arg || *endptr != '\0') {
-    clags_log(config, Clags_Error,
-              "Invalid double value for argument '%s': '%s'!", arg_name, arg);
+  if (end == arg || *end != '\0') {
+    clags__log(config, Clags_Error,
+               "Invalid double value for argument '%s': '%s'!", arg_name, arg);
     return false;
   }
-  if (errno == ERANGE || !isfinite(value) || value > DBL_MAX ||
+  if (out_of_range || !isfinite(value) || value > DBL_MAX ||
       value < -DBL_MAX) {
-    clags_log(config, Clags_Error,
-              "double value out of range (%lf to %lf) for argument '%s': '%s'!",
-              DBL_MAX, -DBL_MAX, arg_name, arg);
+    clags__log(
+        config, Clags_Error,
+        "double value out of range (%lf to %lf) for argument '%s': '%s'!",
+        DBL_MAX, -DBL_MAX, arg_name, arg);
     return false;
   }
 
@@ -524,229 +1228,326 @@ bool clags__verify_double(clags_config_t *config, const char *arg_name,
   return true;
 }
 
-bool clags__verify_choice(clags_config_t *config, const char *arg_name,
-                          const char *arg, void *pvalue, void *data) {
-  clags_choice_t **pchoice = (clags_choice_t **)pvalue;
-  clags_choices_t *choices = (clags_choices_t *)data;
+[[nodiscard]] static inline bool
+clags__choice_matches(const clags_choices_t *choices,
+                      const clags_choice_t *choice, const char *arg) {
+  return choices->case_insensitive ? strcasecmp(choice->value, arg) == 0
+                                   : strcmp(choice->value, arg) == 0;
+}
+
+void clags_choices_build_index(clags_choices_t *choices) {
+  if (choices == nullptr)
+    return;
+  clags_choices_free_index(choices);
+  size_t capacity = clags__index_capacity(choices->count);
+  size_t *slots = clags__calloc(capacity, sizeof(*slots));
+  clags_assert(slots != nullptr, "Out of memory!");
+
+  size_t mask = capacity - 1;
   for (size_t i = 0; i < choices->count; ++i) {
-    clags_choice_t *choice = choices->items + i;
-    if ((choices->case_insensitive && strcasecmp(choice->value, arg) == 0) ||
-        (!choices->case_insensitive && strcmp(choice->value, arg) == 0)) {
-      if (pchoice)
-        *pchoice = choice;
-      return true;
+    const clags_choice_t *choice = &choices->items[i];
+    size_t slot = (size_t)clags__string_hash(choice->value,
+                                             choices->case_insensitive) &
+                  mask;
+    // keep the first of equal choices, like the linear scan
+    while (slots[slot] != 0 &&
+           !clags__choice_matches(choices, &choices->items[slots[slot] - 1],
+                                  choice->value)) {
+      slot = (slot + 1) & mask;
     }
+    if (slots[slot] == 0)
+      slots[slot] = i + 1;
   }
-  clags_log(config, Clags_Error, "Invalid choice for argument '%s': '%s'!",
-            arg_name, arg);
-  return false;
+  choices->hash_slots = slots;
+  choices->hash_capacity = capacity;
 }
 
-bool clags__verify_path(clags_config_t *config, const char *arg_name,
-                        const char *arg, void *pvalue,
-                        [[maybe_unused]] void *data) {
-  struct stat attr;
-  if (stat(arg, &attr) == -1) {
-    clags_log(config, Clags_Error, "Invalid path for argument '%s': '%s' : %s!",
-              arg_name, arg, strerror(errno));
-    return false;
-  }
-  if (pvalue)
-    *(char **)pvalue = clags_config_duplicate_string(config, arg);
-  return true;
+void clags_choices_free_index(clags_choices_t *choices) {
+  if (choices == nullptr)
+    return;
+  CLAGS_FREE(choices->hash_slots);
+  choices->hash_slots = nullptr;
+  choices->hash_capacity = 0;
 }
 
-bool clags__verify_file(clags_config_t *config, const char *arg_name,
-                        const char *arg, void *pvalue,
-                        [[maybe_unused]] void *data) {
-  struct stat attr;
-  if (stat(arg, &attr) == -1) {
-    clags_log(config, Clags_Error, "Invalid path for argument '%s': '%s' : %s!",
-              arg_name, arg, strerror(errno));
+[[nodiscard]] static clags_choice_t *
+clags__find_choice(clags_choices_t *choices, const char *arg) {
+  if (choices->hash_slots != nullptr) {
+    size_t mask = choices->hash_capacity - 1;
+    size_t slot =
+        (size_t)clags__string_hash(arg, choices->case_insensitive) & mask;
+    for (; choices->hash_slots[slot] != 0; slot = (slot + 1) & mask) {
+      clags_choice_t *choice = &choices->items[choices->hash_slots[slot] - 1];
+      if (clags__choice_matches(choices, choice, arg))
+        return choice;
+    }
+    return nullptr;
+  }
+  for (size_t i = 0; i < choices->count; ++i) {
+    if (clags__choice_matches(choices, &choices->items[i], arg))
+      return &choices->items[i];
+  }
+  return nullptr;
+}
+
+bool clags__verify_choice(clags_config_t *config, const char *arg_name,
+                          const char *arg, void *pvalue, void *data) {
+  clags_choice_t **pchoice = (clags_choice_t **)pvalue;
+  clags_choices_t *choices = (clags_choices_t *)data;
+  clags_choice_t *choice = clags__find_choice(choices, arg);
+  if (choice != nullptr) {
+    if (pchoice)
+      *pchoice = choice;
+    return true;
+  }
+  clags__log(config, Clags_Error, "Invalid choice for argument '%s': '%s'!",
+             arg_name, arg);
+  return false;
+}
+
+// report a failed stat or a mismatching file type of a path value
+[[nodiscard]] static bool clags__check_path(clags_config_t *config,
+                                            const char *arg_name,
+                                            const char *arg,
+                                            clags_value_type_t value_type,
+                                            const struct stat *attr,
+                                            int error) {
+  if (error != 0) {
+    clags__log(config, Clags_Error,
+               "Invalid path for argument '%s': '%s' : %s!", arg_name, arg,
+               strerror(error));
+    return false;
+  }
+  if (value_type == Clags_File && !S_ISREG(attr->st_mode)) {
+    clags__log(config, Clags_Error,
+               "Path for arguments '%s' is not a file: '%s'!", arg_name, arg);
     return false;
   }
-  if (!S_ISREG(attr.st_mode)) {
-    clags_log(config, Clags_Error,
-              "Path for arguments '%s' is not a file: '%s'!", arg_name, arg);
+  if (value_type == Clags_Dir && !S_ISDIR(attr->st_mode)) {
+    clags__log(config, Clags_Error,
+               "Path for arguments '%s' is not a dir: '%s'!", arg_name, arg);
     return false;
   }
+  return true;
+}
+
+[[nodiscard]] static inline bool
+clags__verify_path_type(clags_config_t *config, const char *arg_name,
+                        const char *arg, void *pvalue,
+                        clags_value_type_t value_type) {
+  struct stat attr;
+  int error = stat(arg, &attr) == -1 ? errno : 0;
+  if (!clags__check_path(config, arg_name, arg, value_type, &attr, error))
+    return false;
   if (pvalue)
     *(char **)pvalue = clags_config_duplicate_string(config, arg);
   return true;
 }
 
+bool clags__verify_path(clags_config_t *config, const char *arg_name,
+                        const char *arg, void *pvalue,
+                        [[maybe_unused]] void *data) {
+  return clags__verify_path_type(config, arg_name, arg, pvalue, Clags_Path);
+}
+
+bool clags__verify_file(clags_config_t *config, const char *arg_name,
+                        const char *arg, void *pvalue,
+                        [[maybe_unused]] void *data) {
+  return clags__verify_path_type(config, arg_name, arg, pvalue, Clags_File);
+}
+
 bool clags__verify_dir(clags_config_t *config, const char *arg_name,
                        const char *arg, void *pvalue,
                        [[maybe_unused]] void *data) {
-  struct stat attr;
-  if (stat(arg, &attr) == -1) {
-    clags_log(config, Clags_Error, "Invalid path for argument '%s': '%s' : %s!",
-              arg_name, arg, strerror(errno));
+  return clags__verify_path_type(config, arg_name, arg, pvalue, Clags_Dir);
+}
+
+// decode a size unit, "B" is case-sensitive, all other units are not
+[[nodiscard]] static bool clags__size_factor(const char *unit,
+                                             clags_fsize_t *factor) {
+  clags_fsize_t decimal, binary;
+  switch (clags__lower(unit[0])) {
+  case '\0':
+    *factor = 1;
+    return true;
+  case 'b':
+    *factor = 1;
+    return unit[0] == 'B' && unit[1] == '\0';
+  case 'k':
+    decimal = 1000ULL;
+    binary = 1ULL << 10;
+    break;
+  case 'm':
+    decimal = 1000000ULL;
+    binary = 1ULL << 20;
+    break;
+  case 'g':
+    decimal = 1000000000ULL;
+    binary = 1ULL << 30;
+    break;
+  case 't':
+    decimal = 1000000000000ULL;
+    binary = 1ULL << 40;
+    break;
+  default:
     return false;
   }
-  if (!S_ISDIR(attr.st_mode)) {
-    clags_log(config, Clags_Error,
-              "Path for arguments '%s' is not a dir: '%s'!", arg_name, arg);
+  if (clags__lower(unit[1]) == 'b' && unit[2] == '\0') {
+    *factor = decimal;
+    return true;
+  }
+  if (clags__lower(unit[1]) == 'i' && clags__lower(unit[2]) == 'b' &&
+      unit[3] == '\0') {
+    *factor = binary;
+    return true;
+  }
+  return false;
+}
+
+// decode a case-insensitive time unit into a factor of seconds, or of
+// nanoseconds if `nanoseconds` is set, which also enables "ms", "us" and "ns"
+[[nodiscard]] static bool clags__time_factor(const char *unit, bool nanoseconds,
+                                             clags_time_t *factor) {
+  clags_time_t scale = nanoseconds ? 1000000000ULL : 1;
+  char second = unit[0] != '\0' ? clags__lower(unit[1]) : '\0';
+  switch (clags__lower(unit[0])) {
+  case '\0':
+    *factor = 1;
+    return true;
+  case 's':
+    *factor = scale;
+    return second == '\0';
+  case 'm':
+    if (nanoseconds && second == 's' && unit[2] == '\0') {
+      *factor = 1000000ULL;
+      return true;
+    }
+    *factor = 60 * scale;
+    return second == '\0';
+  case 'h':
+    *factor = 3600 * scale;
+    return second == '\0';
+  case 'd':
+    *factor = 24 * 3600 * scale;
+    return second == '\0';
+  case 'u':
+    *factor = 1000ULL;
+    return nanoseconds && second == 's' && unit[2] == '\0';
+  case 'n':
+    *factor = 1;
+    return nanoseconds && second == 's' && unit[2] == '\0';
+  default:
     return false;
   }
-  if (pvalue)
-    *(char **)pvalue = clags_config_duplicate_string(config, arg);
-  return true;
 }
 
 bool clags__verify_size(clags_config_t *config, const char *arg_name,
                         const char *arg, void *pvalue,
                         [[maybe_unused]] void *data) {
-  char *endptr;
-  errno = 0;
-  unsigned long long value = strtoull(arg, &endptr, 10);
-
-  if (endptr == arg) {
-    clags_log(config, Clags_Error,
-              "No leading number in size argument '%s': '%s'!", arg_name, arg);
+  char sign;
+  uint64_t value;
+  const char *unit;
+  clags__scan_status_t status =
+      clags__scan_integer(arg, 10, &sign, &value, &unit);
+  if (status == Clags__Scan_Invalid) {
+    clags__log(config, Clags_Error,
+               "No leading number in size argument '%s': '%s'!", arg_name, arg);
     return false;
   }
   clags_fsize_t factor;
-  if (*endptr == '\0' || strcmp(endptr, "B") == 0)
-    factor = 1;
-  else if (strcasecmp(endptr, "KiB") == 0)
-    factor = 1ULL << 10;
-  else if (strcasecmp(endptr, "KB") == 0)
-    factor = 1000;
-  else if (strcasecmp(endptr, "MiB") == 0)
-    factor = 1ULL << 20;
-  else if (strcasecmp(endptr, "MB") == 0)
-    factor = 1000000;
-  else if (strcasecmp(endptr, "GiB") == 0)
-    factor = 1ULL << 30;
-  else if (strcasecmp(endptr, "GB") == 0)
-    factor = 1000000000;
-  else if (strcasecmp(endptr, "TiB") == 0)
-    factor = 1ULL << 40;
-  else if (strcasecmp(endptr, "TB") == 0)
-    factor = 1000000000000;
-  else {
-    clags_log(config, Clags_Error, "Invalid size unit for argument '%s': '%s'!",
-              arg_name, endptr);
-    return false;
-  }
-
-  if (errno == ERANGE || value > UINT64_MAX / factor ||
-      clags__has_sign_prefix(arg)) {
-    clags_log(config, Clags_Error,
-              "clags_fsize_t value out of range (0 to %" PRIu64
-              ") for argument '%s': '%s'!",
-              UINT64_MAX, arg_name, arg);
+  if (!clags__size_factor(unit, &factor)) {
+    clags__log(config, Clags_Error,
+               "Invalid size unit for argument '%s': '%s'!", arg_name, unit);
+    return false;
+  }
+  if (status == Clags__Scan_Overflow || sign != '\0' ||
+      clags__checked_mul_u64(&value, value, factor)) {
+    clags__log(config, Clags_Error,
+               "clags_fsize_t value out of range (0 to %" PRIu64
+               ") for argument '%s': '%s'!",
+               UINT64_MAX, arg_name, arg);
     return false;
   }
   if (pvalue)
-    *(clags_fsize_t *)pvalue = (clags_fsize_t)value * factor;
+    *(clags_fsize_t *)pvalue = value;
   return true;
 }
 
-bool clags__verify_time_s(clags_config_t *config, const char *arg_name,
-                          const char *arg, void *pvalue,
-                          [[maybe_unused]] void *data) {
-  char *endptr;
-  errno = 0;
+// the shared core of the time verifiers; whole numbers are scanned exactly,
+// fractional and exponent notations like `1.5ms` as doubles
+[[nodiscard]] static bool clags__parse_time(clags_config_t *config,
+                                            const char *arg_name,
+                                            const char *arg, bool nanoseconds,
+                                            clags_time_t *result) {
+  const char *unit_name = nanoseconds ? "ns" : "s";
+  char sign;
+  uint64_t magnitude;
+  const char *unit;
+  clags__scan_status_t status =
+      clags__scan_integer(arg, 10, &sign, &magnitude, &unit);
+  clags_time_t factor;
+  if (status != Clags__Scan_Invalid &&
+      clags__time_factor(unit, nanoseconds, &factor)) {
+    if (status == Clags__Scan_Overflow || (sign == '-' && magnitude != 0) ||
+        clags__checked_mul_u64(&magnitude, magnitude, factor)) {
+      clags__log(config, Clags_Error,
+                 "clags_time_t value out of range (0%s to %" PRIu64
+                 "%s) for argument '%s': '%s'!",
+                 unit_name, UINT64_MAX, unit_name, arg_name, arg);
+      return false;
+    }
+    *result = magnitude;
+    return true;
+  }
 
-  double value = strtod(arg, &endptr);
+  const char *endptr;
+  bool out_of_range;
+  double value = clags__scan_double(arg, &endptr, &out_of_range);
   if (endptr == arg) {
-    clags_log(config, Clags_Error,
-              "No leading number in time argument '%s': '%s'!", arg_name, arg);
+    clags__log(config, Clags_Error,
+               "No leading number in time argument '%s': '%s'!", arg_name, arg);
     return false;
   }
-  clags_time_t factor;
-  if (*endptr == '\0' || strcasecmp(endptr, "s") == 0)
-    factor = 1;
-  else if (strcasecmp(endptr, "m") == 0)
-    factor = 60;
-  else if (strcasecmp(endptr, "h") == 0)
-    factor = 3600;
-  else if (strcasecmp(endptr, "d") == 0)
-    factor = 24 * 3600;
-  else {
-    clags_log(config, Clags_Error, "Invalid time unit for argument '%s': '%s'!",
-              arg_name, endptr);
-    return false;
-  }
-  if (errno == ERANGE || !isfinite(value) || value < 0) {
-    clags_log(config, Clags_Error,
-              "clags_time_t value out of range (0s to %" PRIu64
-              "s) for argument '%s': '%s'!",
-              UINT64_MAX, arg_name, arg);
+  if (!clags__time_factor(endptr, nanoseconds, &factor)) {
+    clags__log(config, Clags_Error,
+               "Invalid time unit for argument '%s': '%s'!", arg_name, endptr);
     return false;
   }
   long double scaled = (long double)value * (long double)factor;
-  if (!isfinite(scaled) || scaled > (long double)UINT64_MAX) {
-    clags_log(config, Clags_Error,
-              "clags_time_t value out of range (0s to %" PRIu64
-              "s) for argument '%s': '%s'!",
-              UINT64_MAX, arg_name, arg);
+  // nanoseconds are rounded to the closest integer, seconds are truncated
+  if (nanoseconds)
+    scaled += 0.5L;
+  if (out_of_range || !isfinite(value) || value < 0 || !isfinite(scaled) ||
+      scaled > (long double)UINT64_MAX) {
+    clags__log(config, Clags_Error,
+               "clags_time_t value out of range (0%s to %" PRIu64
+               "%s) for argument '%s': '%s'!",
+               unit_name, UINT64_MAX, unit_name, arg_name, arg);
     return false;
   }
+  *result = (clags_time_t)scaled;
+  return true;
+}
+
+bool clags__verify_time_s(clags_config_t *config, const char *arg_name,
+                          const char *arg, void *pvalue,
+                          [[maybe_unused]] void *data) {
+  clags_time_t value;
+  if (!clags__parse_time(config, arg_name, arg, false, &value))
+    return false;
   if (pvalue)
-    *(clags_time_t *)pvalue = (clags_time_t)scaled;
+    *(clags_time_t *)pvalue = value;
   return true;
 }
 
 bool clags__verify_time_ns(clags_config_t *config, const char *arg_name,
                            const char *arg, void *pvalue,
                            [[maybe_unused]] void *data) {
-  char *endptr;
-  errno = 0;
-
-  double value = strtod(arg, &endptr);
-  if (endptr == arg) {
-    clags_log(config, Clags_Error,
-              "No leading number in time argument '%s': '%s'!", arg_name, arg);
-    return false;
-  }
-  clags_time_t factor;
-  if (*endptr == '\0' || strcasecmp(endptr, "ns") == 0)
-    factor = 1;
-  else if (strcasecmp(endptr, "us") == 0)
-    factor = 1000ULL;
-  else if (strcasecmp(endptr, "ms") == 0)
-    factor = 1000000ULL;
-  else if (strcasecmp(endptr, "s") == 0)
-    factor = 1000000000ULL;
-  else if (strcasecmp(endptr, "m") == 0)
-    factor = 60ULL * 1000000000ULL;
-  else if (strcasecmp(endptr, "h") == 0)
-    factor = 3600ULL * 1000000000ULL;
-  else if (strcasecmp(endptr, "d") == 0)
-    factor = 24ULL * 3600ULL * 1000000000ULL;
-  else {
-    clags_log(config, Clags_Error, "Invalid time unit for argument '%s': '%s'!",
-              arg_name, endptr);
-    return false;
-  }
-  if (errno == ERANGE || !isfinite(value) || value < 0) {
-    clags_log(config, Clags_Error,
-              "clags_time_t value out of range (0ns to %" PRIu64
-              "ns) for argument '%s': '%s'!",
-              UINT64_MAX, arg_name, arg);
-    return false;
-  }
-  long double scaled = (long double)value * (long double)factor;
-  if (!isfinite(scaled) || scaled > (long double)UINT64_MAX) {
-    clags_log(config, Clags_Error,
-              "clags_time_t value out of range (0ns to %" PRIu64
-              "ns) for argument '%s': '%s'!",
-              UINT64_MAX, arg_name, arg);
-    return false;
-  }
-  long double rounded = scaled + 0.5L;
-  if (rounded > (long double)UINT64_MAX) {
-    clags_log(config, Clags_Error,
-              "clags_time_t value out of range (0ns to %" PRIu64
-              "ns) for argument '%s': '%s'!",
-              UINT64_MAX, arg_name, arg);
+  clags_time_t value;
+  if (!clags__parse_time(config, arg_name, arg, true, &value))
     return false;
-  }
   if (pvalue)
-    *(clags_time_t *)pvalue = (clags_time_t)rounded;
+    *(clags_time_t *)pvalue = value;
   return true;
 }
 
@@ -761,29 +1562,112 @@ bool clags__verify_subcmd(clags_config_t *config, const char *arg_name,
       return true;
     }
   }
-  clags_log(config, Clags_Error, "unknown subcommand '%s' for argument '%s'!",
-            arg, arg_name);
+  clags__log(config, Clags_Error, "unknown subcommand '%s' for argument '%s'!",
+             arg, arg_name);
   return false;
 }
 
 bool clags__verify_custom(clags_config_t *config, const char *arg_name,
                           const char *arg, void *pvalue, void *data) {
   if (data == nullptr) {
-    clags_log(config, Clags_ConfigError,
-              "Missing custom verifier for argument '%s'!", arg_name);
+    clags__log(config, Clags_ConfigError,
+               "Missing custom verifier for argument '%s'!", arg_name);
     return false;
   }
   clags_custom_verify_func_t custom_verify =
       *(clags_custom_verify_func_t *)data;
   if (custom_verify == nullptr) {
-    clags_log(config, Clags_ConfigError,
-              "Invalid custom verifier for argument '%s'!", arg_name);
+    clags__log(config, Clags_ConfigError,
+               "Invalid custom verifier for argument '%s'!", arg_name);
     return false;
   }
   if (!custom_verify(config, arg_name, arg, pvalue)) {
-    clags_log(config, Clags_Error,
-              "Value for argument '%s' does not match custom criteria: '%s'!",
-              arg_name, arg);
+    clags__log(config, Clags_Error,
+               "Value for argument '%s' does not match custom criteria: '%s'!",
+               arg_name, arg);
+    return false;
+  }
+  return true;
+}
+
+// grow the storage of a list to exactly `new_capacity` items, heap storage
+// stays on the heap, a list without storage is placed in the active arena
+static void clags__list_reserve(clags_config_t *config, clags_list_t *list,
+                                size_t new_capacity) {
+  if (list->capacity >= new_capacity)
+    return;
+  clags_assert(!list->fixed, "Fixed list capacity exceeded!");
+  size_t alloc_size = 0;
+  clags_assert(
+      !clags__checked_mul_size(&alloc_size, new_capacity, list->item_size),
+      "List allocation size overflow!");
+  if (list->items == nullptr)
+    list->arena = clags__arena(config);
+  if (list->arena != nullptr) {
+    list->items =
+        clags__arena_realloc(list->arena, list->items,
+                             list->capacity * list->item_size, alloc_size);
+  } else {
+    list->items = clags__realloc(list->items, alloc_size);
+    clags_assert(list->items != nullptr, "Out of memory!");
+  }
+  list->capacity = new_capacity;
+  clags__stats_add(list_reallocs, 1);
+}
+
+// whether a list over caller storage has no room for another item, logging
+// the overflow, see `clags_fixed_list`
+[[nodiscard]] static inline bool clags__list_full(clags_config_t *config,
+                                                  const clags_list_t *list,
+                                                  const char *arg_name) {
+  if (!list->fixed || list->count < list->capacity)
+    return false;
+  clags__log(config, Clags_Error,
+             "Too many values for argument '%s': its list holds at most %zu!",
+             arg_name, list->capacity);
+  return true;
+}
+
+// append a raw item to a list, growing it like `clags__append_to_list`
+static void clags__list_append_item(clags_config_t *config, clags_list_t *list,
+                                    const void *item) {
+  if (list->count >= list->capacity) {
+    size_t required_capacity = 0;
+    clags_assert(
+        !clags__checked_add_size(&required_capacity, list->count, (size_t)1),
+        "List capacity overflow!");
+    size_t new_capacity = 0;
+    clags_assert(clags__next_capacity(list->capacity, required_capacity,
+                                      &new_capacity),
+                 "List capacity overflow!");
+    clags__list_reserve(config, list, new_capacity);
+  }
+  memcpy((char *)list->items + list->count * list->item_size, item,
+         list->item_size);
+  list->count++;
+}
+
+// check the item size of a list against its value type, a nullptr config
+// checks silently
+[[nodiscard]] static bool
+clags__check_list_item_size(clags_config_t *config,
+                            clags_value_type_t value_type,
+                            const char *arg_name, const clags_list_t *list) {
+  if (list->item_size == 0) {
+    if (config != nullptr)
+      clags__log(config, Clags_Error,
+                 "List item size for argument '%s' may not be 0!", arg_name);
+    return false;
+  }
+  size_t expected_item_size = 0;
+  if (value_type != Clags_Custom &&
+      clags__list_expected_item_size(value_type, &expected_item_size) &&
+      list->item_size != expected_item_size) {
+    if (config != nullptr)
+      clags__log(
+          config, Clags_Error,
+          "List item size mismatch for argument '%s': expected %zu, got %zu!",
+          arg_name, expected_item_size, list->item_size);
     return false;
   }
   return true;
@@ -795,26 +1679,36 @@ static inline bool clags__append_to_list(clags_config_t *config,
                                          void *variable, void *data,
                                          clags_custom_verify_func_t verify) {
   if (!clags__is_valid_value_type(value_type)) {
-    clags_log(config, Clags_Error, "Invalid value type %d for argument '%s'!",
-              (int)value_type, arg_name);
+    clags__log(config, Clags_Error, "Invalid value type %d for argument '%s'!",
+               (int)value_type, arg_name);
     return false;
   }
   clags_list_t *list = (clags_list_t *)variable;
   size_t item_size = list->item_size;
-  if (item_size == 0) {
-    clags_log(config, Clags_Error,
-              "List item size for argument '%s' may not be 0!", arg_name);
+  // the item size is only checked once per list, before its first element
+  if (list->count == 0 && list->streamed == 0 &&
+      !clags__check_list_item_size(config, value_type, arg_name, list))
     return false;
-  }
-  size_t expected_item_size = 0;
-  if (value_type != Clags_Custom &&
-      clags__list_expected_item_size(value_type, &expected_item_size) &&
-      item_size != expected_item_size) {
-    clags_log(
-        config, Clags_Error,
-        "List item size mismatch for argument '%s': expected %zu, got %zu!",
-        arg_name, expected_item_size, item_size);
+  if (clags__list_full(config, list, arg_name))
     return false;
+  void *verify_data = data;
+  clags_custom_verify_func_t custom_verify = verify;
+  if (value_type == Clags_Custom) {
+    verify_data = &custom_verify;
+  }
+  // a streamed list only keeps storage for the element handed over
+  if (list->on_element != nullptr) {
+    clags__list_reserve(config, list, 1);
+    if (!clags__verify(value_type, config, arg_name, arg, list->items,
+                       verify_data))
+      return false;
+    if (!list->on_element(config, list->items, list->element_data)) {
+      clags__log(config, Clags_Error,
+                 "Element '%s' of argument '%s' was rejected!", arg, arg_name);
+      return false;
+    }
+    list->streamed++;
+    return true;
   }
   if (list->count >= list->capacity) {
     size_t required_capacity = 0;
@@ -822,43 +1716,65 @@ static inline bool clags__append_to_list(clags_config_t *config,
         !clags__checked_add_size(&required_capacity, list->count, (size_t)1),
         "List capacity overflow!");
     size_t new_capacity = 0;
-    clags_assert(
-        clags__next_capacity(list->capacity, required_capacity, &new_capacity),
-        "List capacity overflow!");
-    size_t alloc_size = 0;
-    clags_assert(!clags__checked_mul_size(&alloc_size, new_capacity, item_size),
-                 "List allocation size overflow!");
-    list->items = CLAGS_REALLOC(list->items, alloc_size);
-    clags_assert(list->items != nullptr, "Out of memory!");
-    list->capacity = new_capacity;
+    clags_assert(clags__next_capacity(list->capacity, required_capacity,
+                                      &new_capacity),
+                 "List capacity overflow!");
+    clags__list_reserve(config, list, new_capacity);
   }
   size_t offset = 0;
   clags_assert(!clags__checked_mul_size(&offset, item_size, list->count),
                "List offset overflow!");
   char *ptr = (char *)list->items;
-  void *verify_data = data;
-  clags_custom_verify_func_t custom_verify = verify;
-  if (value_type == Clags_Custom) {
-    verify_data = &custom_verify;
-  }
-  if (clags__verify_funcs[value_type](config, arg_name, arg, ptr + offset,
-                                      verify_data)) {
+  if (clags__verify(value_type, config, arg_name, arg, ptr + offset,
+                    verify_data)) {
     list->count++;
     return true;
   }
   return false;
 }
 
+// a path value awaiting its deferred check, see `clags__run_path_checks`
+typedef struct {
+  const char *path;
+  const char *arg_name;
+  clags_value_type_t value_type;
+  clags_config_t *config; // the config the argument belongs to
+  clags_list_t *stats;    // the list receiving the file status, if any
+  struct stat attr;
+  int error;    // the errno of a failed stat, 0 on success
+  size_t index; // the argv index of the path, see `clags_error_record_t`
+} clags__path_check_t;
+
+[[nodiscard]] static inline bool
+clags__is_path_type(clags_value_type_t value_type) {
+  return value_type == Clags_Path || value_type == Clags_File ||
+         value_type == Clags_Dir;
+}
+
+// set a variable or append to a list, path values are stored unchecked and
+// queued on `path_checks` if the config defers them
 static inline bool
-clags__set_arg(clags_config_t *config, clags_value_type_t value_type,
+clags__set_arg(clags_config_t *config, clags_context_t *context,
+               clags_list_t *path_checks, size_t index,
+               clags_value_type_t value_type,
                const char *arg_name, const char *arg, void *variable,
                void *data, clags_custom_verify_func_t verify, bool is_list) {
   if (!clags__is_valid_value_type(value_type)) {
-    clags_log(config, Clags_Error, "Invalid value type %d for argument '%s'!",
-              (int)value_type, arg_name);
-    config->error = Clags_Error_InvalidValue;
+    clags__log(config, Clags_Error, "Invalid value type %d for argument '%s'!",
+               (int)value_type, arg_name);
+    clags__set_error(config, context, Clags_Error_InvalidValue);
     return false;
   }
+  variable = clags__variable(context, variable);
+  clags_value_type_t path_type = value_type;
+  // streamed elements are handed over checked, so their paths are not deferred
+  bool deferred = path_checks != nullptr &&
+                  config->options.defer_path_checks &&
+                  clags__is_path_type(value_type) &&
+                  !(is_list && variable != nullptr &&
+                    ((clags_list_t *)variable)->on_element != nullptr);
+  if (deferred)
+    value_type = Clags_String;
   bool result;
   if (is_list) {
     result = clags__append_to_list(config, value_type, arg_name, arg, variable,
@@ -869,33 +1785,59 @@ clags__set_arg(clags_config_t *config, clags_value_type_t value_type,
     if (value_type == Clags_Custom) {
       verify_data = &custom_verify;
     }
-    result = clags__verify_funcs[value_type](config, arg_name, arg, variable,
-                                             verify_data);
+    result =
+        clags__verify(value_type, config, arg_name, arg, variable, verify_data);
   }
-  if (!result)
-    config->error = Clags_Error_InvalidValue;
-  return result;
+  if (!result) {
+    clags__set_error(config, context, Clags_Error_InvalidValue);
+    return false;
+  }
+  if (deferred) {
+    // queue the stored string, which may be a duplicate of `arg`
+    const char *path = arg;
+    if (variable != nullptr && is_list) {
+      clags_list_t *list = variable;
+      path = ((char **)list->items)[list->count - 1];
+    } else if (variable != nullptr) {
+      path = *(char **)variable;
+    }
+    clags__path_check_t check = {
+        .path = path,
+        .arg_name = arg_name,
+        .value_type = path_type,
+        .config = config,
+        .stats = clags__variable(context, config->options.path_stats),
+        .index = index,
+    };
+    if (path_checks->item_size == 0)
+      path_checks->item_size = sizeof(check);
+    clags__list_push(path_checks, &check);
+  }
+  return true;
 }
 
-static inline void clags__set_flag(clags_config_t *config, clags_flag_t *flag) {
+static inline void clags__set_flag(clags_config_t *config,
+                                   clags_context_t *context,
+                                   clags_flag_t *flag) {
+  void *variable = clags__variable(context, flag->variable);
   switch (flag->type) {
   case Clags_BoolFlag: {
-    if (flag->variable == nullptr)
+    if (variable == nullptr)
       return;
-    *(bool *)flag->variable = true;
+    *(bool *)variable = true;
   } break;
   case Clags_ConfigFlag: {
-    if (flag->variable == nullptr)
+    if (variable == nullptr)
       return;
-    *(clags_config_t **)flag->variable = config;
+    *(clags_config_t **)variable = config;
   } break;
   case Clags_CountFlag: {
-    if (flag->variable == nullptr)
+    if (variable == nullptr)
       return;
-    size_t count = *(size_t *)flag->variable;
+    size_t count = *(size_t *)variable;
     clags_assert(!clags__checked_add_size(&count, count, (size_t)1),
                  "Count flag overflow!");
-    *(size_t *)flag->variable = count;
+    *(size_t *)variable = count;
   } break;
   case Clags_CallbackFlag: {
     if (flag->callback != nullptr)
@@ -910,36 +1852,36 @@ static inline void clags__set_flag(clags_config_t *config, clags_flag_t *flag) {
 bool clags__validate_positional(clags_config_t *config,
                                 clags_positional_t pos) {
   if (!clags__is_valid_value_type(pos.value_type)) {
-    clags_log(config, Clags_ConfigError,
-              "invalid value type for positional argument '%s': %d!",
-              pos.arg_name, (int)pos.value_type);
+    clags__log(config, Clags_ConfigError,
+               "invalid value type for positional argument '%s': %d!",
+               pos.arg_name, (int)pos.value_type);
     return false;
   }
   switch (pos.value_type) {
   case Clags_Subcmd: {
     if (pos.subcmds == nullptr) {
-      clags_log(config, Clags_ConfigError,
-                "incomplete subcommand definition for argument '%s'! Define "
-                "`.subcmds` for subcommand verification!",
-                pos.arg_name);
+      clags__log(config, Clags_ConfigError,
+                 "incomplete subcommand definition for argument '%s'! Define "
+                 "`.subcmds` for subcommand verification!",
+                 pos.arg_name);
       return false;
     }
   } break;
   case Clags_Choice: {
     if (pos.choices == nullptr) {
-      clags_log(config, Clags_ConfigError,
-                "incomplete choice definition for argument '%s'! Define "
-                "`.choices` for choice verification!",
-                pos.arg_name);
+      clags__log(config, Clags_ConfigError,
+                 "incomplete choice definition for argument '%s'! Define "
+                 "`.choices` for choice verification!",
+                 pos.arg_name);
       return false;
     }
   } break;
   case Clags_Custom: {
     if (pos.verify == nullptr) {
-      clags_log(config, Clags_ConfigError,
-                "incomplete custom verifier definition for argument '%s'! "
-                "Define `.verify` for custom verification!",
-                pos.arg_name);
+      clags__log(config, Clags_ConfigError,
+                 "incomplete custom verifier definition for argument '%s'! "
+                 "Define `.verify` for custom verification!",
+                 pos.arg_name);
       return false;
     }
   } break;
@@ -952,11 +1894,11 @@ bool clags__validate_positional(clags_config_t *config,
 bool clags__validate_option(clags_config_t *config, clags_option_t opt) {
   if (!clags__is_valid_value_type(opt.value_type)) {
     char short_flag_name[2] = {(char)opt.short_flag, '\0'};
-    clags_log(config, Clags_ConfigError,
-              "invalid value type for option argument '%s': %d!",
-              opt.long_flag ? opt.long_flag
+    clags__log(config, Clags_ConfigError,
+               "invalid value type for option argument '%s': %d!",
+               opt.long_flag ? opt.long_flag
                             : (opt.short_flag ? short_flag_name : "unknown"),
-              (int)opt.value_type);
+               (int)opt.value_type);
     return false;
   }
   char buf[3] = {'-', '\0', '\0'};
@@ -965,38 +1907,45 @@ bool clags__validate_option(clags_config_t *config, clags_option_t opt) {
           ? opt.long_flag
           : (opt.short_flag ? (buf[1] = opt.short_flag, buf) : "(unnamed)");
   if (opt.short_flag == '\0' && opt.long_flag == nullptr) {
-    clags_log(config, Clags_ConfigWarning,
-              "option argument is unreachable. Define at least one of "
-              "`short_flag` and `long_flag`.");
+    clags__log(config, Clags_ConfigWarning,
+               "option argument is unreachable. Define at least one of "
+               "`short_flag` and `long_flag`.");
   }
   if (opt.long_flag && strncmp(opt.long_flag, "--", 2) == 0) {
-    clags_log(config, Clags_ConfigWarning,
-              "option long flag '%s' should not start with '--'. "
-              "The parser automatically handles leading '--' for long flags, "
-              "so including it in the config may cause incorrect parsing.",
-              opt.long_flag);
+    clags__log(config, Clags_ConfigWarning,
+               "option long flag '%s' should not start with '--'. "
+               "The parser automatically handles leading '--' for long flags, "
+               "so including it in the config may cause incorrect parsing.",
+               opt.long_flag);
+  }
+  if (opt.long_flag && strchr(opt.long_flag, '=') != nullptr) {
+    clags__log(config, Clags_ConfigError,
+               "option long flag '%s' may not contain '=' since it separates "
+               "designated option assignments!",
+               opt.long_flag);
+    return false;
   }
   switch (opt.value_type) {
   case Clags_Subcmd: {
-    clags_log(config, Clags_ConfigError,
-              "option argument '%s' may not be a subcommand!", name);
+    clags__log(config, Clags_ConfigError,
+               "option argument '%s' may not be a subcommand!", name);
     return false;
   } break;
   case Clags_Choice: {
     if (opt.choices == nullptr) {
-      clags_log(config, Clags_ConfigError,
-                "incomplete choice definition for argument '%s'! Define "
-                "`.choices` for choice verification!",
-                name);
+      clags__log(config, Clags_ConfigError,
+                 "incomplete choice definition for argument '%s'! Define "
+                 "`.choices` for choice verification!",
+                 name);
       return false;
     }
   } break;
   case Clags_Custom: {
     if (opt.verify == nullptr) {
-      clags_log(config, Clags_ConfigError,
-                "incomplete custom verifier definition for argument '%s'! "
-                "Define `.verify` for custom verification!",
-                name);
+      clags__log(config, Clags_ConfigError,
+                 "incomplete custom verifier definition for argument '%s'! "
+                 "Define `.verify` for custom verification!",
+                 name);
       return false;
     }
   } break;
@@ -1008,16 +1957,23 @@ bool clags__validate_option(clags_config_t *config, clags_option_t opt) {
 
 bool clags__validate_flag(clags_config_t *config, clags_flag_t flag) {
   if (flag.short_flag == '\0' && flag.long_flag == nullptr) {
-    clags_log(config, Clags_ConfigWarning,
-              "flag argument is unreachable. Define at least one of "
-              "`short_flag` and `long_flag`.");
+    clags__log(config, Clags_ConfigWarning,
+               "flag argument is unreachable. Define at least one of "
+               "`short_flag` and `long_flag`.");
   }
   if (flag.long_flag && strncmp(flag.long_flag, "--", 2) == 0) {
-    clags_log(config, Clags_ConfigWarning,
-              "long flag '%s' should not start with '--'. "
-              "The parser automatically handles leading '--' for long flags, "
-              "so including it in the config may cause incorrect parsing.",
-              flag.long_flag);
+    clags__log(config, Clags_ConfigWarning,
+               "long flag '%s' should not start with '--'. "
+               "The parser automatically handles leading '--' for long flags, "
+               "so including it in the config may cause incorrect parsing.",
+               flag.long_flag);
+  }
+  if (flag.long_flag && strchr(flag.long_flag, '=') != nullptr) {
+    clags__log(config, Clags_ConfigError,
+               "long flag '%s' may not contain '=' since it separates "
+               "designated option assignments!",
+               flag.long_flag);
+    return false;
   }
   switch (flag.type) {
   case Clags_BoolFlag:
@@ -1026,13 +1982,13 @@ bool clags__validate_flag(clags_config_t *config, clags_flag_t flag) {
     break;
   case Clags_CallbackFlag: {
     if (flag.callback == nullptr) {
-      clags_log(config, Clags_ConfigError,
-                "callback flag requires `.callback` to be set.");
+      clags__log(config, Clags_ConfigError,
+                 "callback flag requires `.callback` to be set.");
       return false;
     }
   } break;
   default: {
-    clags_log(config, Clags_ConfigError, "invalid flag type: %d!", flag.type);
+    clags__log(config, Clags_ConfigError, "invalid flag type: %d!", flag.type);
     return false;
   }
   }
@@ -1043,34 +1999,34 @@ bool clags__validate_config(clags_config_t *config) {
   bool result = true;
   // validate options
   if (clags__is_empty_string(config->options.list_terminator)) {
-    clags_log(config, Clags_ConfigError,
-              "'.list_terminator' may not be empty.");
+    clags__log(config, Clags_ConfigError,
+               "'.list_terminator' may not be empty.");
     clags_return_defer(false);
   }
   if (clags__is_empty_string(config->options.ignore_prefix)) {
-    clags_log(config, Clags_ConfigError, "'.ignore_prefix' may not be empty.");
+    clags__log(config, Clags_ConfigError, "'.ignore_prefix' may not be empty.");
     clags_return_defer(false);
   }
   if (config->options.list_terminator &&
       strcmp(config->options.list_terminator, "--") == 0) {
-    clags_log(config, Clags_ConfigError,
-              "'.list_terminator' may not be '--' because '--' is reserved for "
-              "toggling option and flag parsing!");
+    clags__log(config, Clags_ConfigError,
+               "'.list_terminator' may not be '--' because '--' is reserved "
+               "for toggling option and flag parsing!");
     clags_return_defer(false);
   }
   if (config->options.ignore_prefix &&
       strcmp(config->options.ignore_prefix, "--") == 0) {
-    clags_log(config, Clags_ConfigError,
-              "'.ignore_prefix' may not be '--' since this conflicts with the "
-              "long option and flag prefix!");
+    clags__log(config, Clags_ConfigError,
+               "'.ignore_prefix' may not be '--' since this conflicts with the "
+               "long option and flag prefix!");
     clags_return_defer(false);
   }
   if (config->options.list_terminator != nullptr &&
       config->options.ignore_prefix != nullptr &&
       strcmp(config->options.list_terminator, config->options.ignore_prefix) ==
           0) {
-    clags_log(config, Clags_ConfigError,
-              "'.list_terminator' and '.ignore_prefix' may not be identical.");
+    clags__log(config, Clags_ConfigError,
+               "'.list_terminator' and '.ignore_prefix' may not be identical.");
     clags_return_defer(false);
   }
 
@@ -1087,26 +2043,26 @@ bool clags__validate_config(clags_config_t *config) {
       if (!clags__validate_positional(config, pos))
         clags_return_defer(false);
       if (optional_found && !pos.optional) {
-        clags_log(config, Clags_ConfigError,
-                  "invalid positional argument order: required argument '%s' "
-                  "appears after optional argument '%s'",
-                  pos.arg_name, last_pos_name);
+        clags__log(config, Clags_ConfigError,
+                   "invalid positional argument order: required argument '%s' "
+                   "appears after optional argument '%s'",
+                   pos.arg_name, last_pos_name);
         clags_return_defer(false);
       }
       optional_found = pos.optional;
       if (pos.value_type == Clags_Subcmd) {
         subcmd_found = true;
         if (last_pos_name != nullptr) {
-          clags_log(config, Clags_ConfigError,
-                    "subcommand '%s' must be the only positional argument in "
-                    "its config!",
-                    pos.arg_name);
+          clags__log(config, Clags_ConfigError,
+                     "subcommand '%s' must be the only positional argument in "
+                     "its config!",
+                     pos.arg_name);
           clags_return_defer(false);
         }
       } else if (subcmd_found) {
-        clags_log(config, Clags_ConfigError,
-                  "trailing positional argument after subcommand: '%s'!",
-                  pos.arg_name);
+        clags__log(config, Clags_ConfigError,
+                   "trailing positional argument after subcommand: '%s'!",
+                   pos.arg_name);
         clags_return_defer(false);
       }
       if (last_was_list && config->options.list_terminator == nullptr) {
@@ -1140,8 +2096,6 @@ bool clags__validate_config(clags_config_t *config) {
     }
   }
 defer:
-  if (!result)
-    config->error = Clags_Error_InvalidConfig;
   return result;
 }
 
@@ -1167,388 +2121,2376 @@ void clags__sort_args(clags_args_t *args, clags_config_t *config) {
   }
 }
 
-void clags__choice_usage(clags_choices_t *choices, bool is_list) {
+// allocate the sorted argument views and lookup tables of `args`
+static void clags__alloc_args(clags_args_t *args, size_t args_count) {
+  memset(args, 0, sizeof(*args));
+  args->positional = clags__calloc(args_count, sizeof(*args->positional));
+  args->option = clags__calloc(args_count, sizeof(*args->option));
+  args->flags = clags__calloc(args_count, sizeof(*args->flags));
+  args->longs = clags__calloc(args_count, sizeof(*args->longs));
+  clags_assert(args->positional && args->option && args->flags && args->longs,
+               "Out of memory!");
+}
+
+static void clags__free_args(clags_args_t *args) {
+  if (args == nullptr)
+    return;
+  CLAGS_FREE(args->positional);
+  CLAGS_FREE(args->option);
+  CLAGS_FREE(args->flags);
+  CLAGS_FREE(args->longs);
+  CLAGS_FREE(args->subcmd_slots);
+  CLAGS_FREE(args->env_slots);
+  memset(args, 0, sizeof(*args));
+}
+
+static int clags__compare_long_entries(const void *lhs, const void *rhs) {
+  const clags_long_entry_t *a = lhs;
+  const clags_long_entry_t *b = rhs;
+  return strcmp(a->name, b->name);
+}
+
+// compare a length-bounded name against an entry, in the same order as `strcmp`
+[[nodiscard]] static inline int
+clags__compare_long_name(const char *name, size_t length,
+                         const clags_long_entry_t *entry) {
+  size_t common = length < entry->length ? length : entry->length;
+  int cmp = memcmp(name, entry->name, common);
+  if (cmp != 0)
+    return cmp;
+  if (length == entry->length)
+    return 0;
+  return length < entry->length ? -1 : 1;
+}
+
+// fill and sort the long flag table of `args`, rejecting duplicate long flags
+[[nodiscard]] bool clags__index_long_flags(clags_args_t *args,
+                                           clags_config_t *config) {
+  args->long_count = 0;
+  for (size_t i = 0; i < config->args_count; ++i) {
+    clags_arg_t *arg = &config->args[i];
+    const char *long_flag = nullptr;
+    if (arg->type == Clags_Option)
+      long_flag = arg->opt.long_flag;
+    else if (arg->type == Clags_Flag)
+      long_flag = arg->flag.long_flag;
+    if (long_flag == nullptr)
+      continue;
+    args->longs[args->long_count++] = (clags_long_entry_t){
+        .name = long_flag, .length = strlen(long_flag), .index = i};
+  }
+  if (args->long_count > 1)
+    qsort(args->longs, args->long_count, sizeof(*args->longs),
+          clags__compare_long_entries);
+  for (size_t i = 1; i < args->long_count; ++i) {
+    if (strcmp(args->longs[i - 1].name, args->longs[i].name) == 0) {
+      clags__log(config, Clags_ConfigError,
+                 "duplicate long flag '--%s'! Every option and flag must have "
+                 "a unique long flag.",
+                 args->longs[i].name);
+      return false;
+    }
+  }
+  return true;
+}
+
+// fill the short flag dispatch table of `args`, rejecting duplicate short
+// flags; at most 255 distinct characters exist, so a slot always fits a byte
+[[nodiscard]] bool clags__index_short_flags(clags_args_t *args,
+                                            clags_config_t *config) {
+  memset(args->short_slots, 0, sizeof(args->short_slots));
+  uint8_t slot_count = 0;
+  for (size_t i = 0; i < config->args_count; ++i) {
+    clags_arg_t *arg = &config->args[i];
+    char short_flag = '\0';
+    if (arg->type == Clags_Option)
+      short_flag = arg->opt.short_flag;
+    else if (arg->type == Clags_Flag)
+      short_flag = arg->flag.short_flag;
+    if (short_flag == '\0')
+      continue;
+    unsigned char c = (unsigned char)short_flag;
+    if (args->short_slots[c] != 0) {
+      clags__log(config, Clags_ConfigError,
+                 "duplicate short flag '-%c'! Every option and flag must have "
+                 "a unique short flag.",
+                 short_flag);
+      return false;
+    }
+    args->short_slots[c] = ++slot_count;
+    args->shorts[slot_count] = i;
+  }
+  return true;
+}
+
+// the name an option is reported by in error records
+[[nodiscard]] static inline const char *
+clags__option_name(const clags_option_t *opt) {
+  return opt->long_flag != nullptr ? opt->long_flag : opt->arg_name;
+}
+
+// index the options bound to environment variables by variable name,
+// rejecting invalid and duplicate names
+[[nodiscard]] static bool clags__index_env(clags_args_t *args,
+                                           clags_config_t *config) {
+  size_t count = 0;
+  for (size_t i = 0; i < config->args_count; ++i) {
+    if (config->args[i].type == Clags_Option &&
+        config->args[i].opt.env != nullptr)
+      count++;
+  }
+  if (count == 0)
+    return true;
+  size_t capacity = clags__index_capacity(count);
+  size_t *slots = clags__calloc(capacity, sizeof(*slots));
+  clags_assert(slots != nullptr, "Out of memory!");
+  args->env_slots = slots;
+  args->env_capacity = capacity;
+
+  size_t mask = capacity - 1;
+  for (size_t i = 0; i < config->args_count; ++i) {
+    if (config->args[i].type != Clags_Option)
+      continue;
+    const clags_option_t *opt = &config->args[i].opt;
+    if (opt->env == nullptr)
+      continue;
+    if (*opt->env == '\0' || strchr(opt->env, '=') != nullptr) {
+      clags__log(config, Clags_ConfigError,
+                 "invalid environment variable name '%s' for option '%s'!",
+                 opt->env, clags__option_name(opt));
+      return false;
+    }
+    size_t slot = (size_t)clags__string_hash(opt->env, false) & mask;
+    for (; slots[slot] != 0; slot = (slot + 1) & mask) {
+      if (strcmp(config->args[slots[slot] - 1].opt.env, opt->env) == 0) {
+        clags__log(config, Clags_ConfigError,
+                   "duplicate environment variable '%s'! Every variable may "
+                   "be bound to one option only.",
+                   opt->env);
+        return false;
+      }
+    }
+    slots[slot] = i + 1;
+  }
+  return true;
+}
+
+// the subcommand definitions of a config's subcommand positional, if any
+[[nodiscard]] static clags_subcmds_t *
+clags__args_subcmds(const clags_args_t *args) {
+  for (size_t i = 0; i < args->positional_count; ++i) {
+    if (args->positional[i].value_type == Clags_Subcmd)
+      return args->positional[i].subcmds;
+  }
+  return nullptr;
+}
+
+// index the subcommands by name, keeping the first of equal names like the
+// linear scan of `clags__verify_subcmd`
+static void clags__index_subcmds(clags_args_t *args) {
+  clags_subcmds_t *subcmds = clags__args_subcmds(args);
+  if (subcmds == nullptr || subcmds->count == 0)
+    return;
+  size_t capacity = clags__index_capacity(subcmds->count);
+  size_t *slots = clags__calloc(capacity, sizeof(*slots));
+  clags_assert(slots != nullptr, "Out of memory!");
+
+  size_t mask = capacity - 1;
+  for (size_t i = 0; i < subcmds->count; ++i) {
+    const char *name = subcmds->items[i].name;
+    size_t slot = (size_t)clags__string_hash(name, false) & mask;
+    while (slots[slot] != 0 &&
+           strcmp(subcmds->items[slots[slot] - 1].name, name) != 0) {
+      slot = (slot + 1) & mask;
+    }
+    if (slots[slot] == 0)
+      slots[slot] = i + 1;
+  }
+  args->subcmd_slots = slots;
+  args->subcmd_capacity = capacity;
+}
+
+// look up a subcommand through the index of compiled tables
+[[nodiscard]] static clags_subcmd_t *
+clags__find_subcmd(const clags_args_t *args, clags_subcmds_t *subcmds,
+                   const char *arg) {
+  size_t mask = args->subcmd_capacity - 1;
+  size_t slot = (size_t)clags__string_hash(arg, false) & mask;
+  for (; args->subcmd_slots[slot] != 0; slot = (slot + 1) & mask) {
+    clags_subcmd_t *subcmd = &subcmds->items[args->subcmd_slots[slot] - 1];
+    if (strcmp(subcmd->name, arg) == 0)
+      return subcmd;
+  }
+  return nullptr;
+}
+
+// validate a config and build its sorted argument tables. On fatal errors the
+// error is stored on the context, or the config is marked as invalid
+[[nodiscard]] static bool clags__build_args(clags_args_t *args,
+                                            clags_config_t *config,
+                                            clags_context_t *context) {
+  [[maybe_unused]] uint64_t started = clags__stats_clock();
+  bool valid = clags__validate_config(config);
+  [[maybe_unused]] uint64_t validated = clags__stats_clock();
+  clags__stats_add(validations, 1);
+  clags__stats_add(validation_ns, validated - started);
+  if (valid) {
+    clags__alloc_args(args, config->args_count);
+    clags__sort_args(args, config);
+    if (!clags__index_long_flags(args, config) ||
+        !clags__index_short_flags(args, config) ||
+        !clags__index_env(args, config)) {
+      clags__free_args(args);
+      valid = false;
+    }
+    clags__stats_add(sorts, 1);
+    clags__stats_add(sort_ns, clags__stats_clock() - validated);
+  }
+  if (!valid) {
+    clags__set_error(config, context, Clags_Error_InvalidConfig);
+    if (context == nullptr)
+      config->invalid = true;
+  }
+  return valid;
+}
+
+// validate a config and cache its argument tables and subcommand index on it
+[[nodiscard]] static bool clags__compile(clags_config_t *config) {
+  clags_args_t *compiled = clags__calloc(1, sizeof(*compiled));
+  clags_assert(compiled != nullptr, "Out of memory!");
+  if (!clags__build_args(compiled, config, nullptr)) {
+    CLAGS_FREE(compiled);
+    return false;
+  }
+  clags__index_subcmds(compiled);
+  config->compiled = compiled;
+  return true;
+}
+
+// binary search the long flag table for an exact, length-bounded name
+[[nodiscard]] static inline const clags_long_entry_t *
+clags__find_long_flag(const clags_args_t *args, const char *name,
+                      size_t length) {
+  size_t low = 0;
+  size_t high = args->long_count;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    int cmp = clags__compare_long_name(name, length, &args->longs[mid]);
+    if (cmp == 0)
+      return &args->longs[mid];
+    if (cmp < 0)
+      high = mid;
+    else
+      low = mid + 1;
+  }
+  return nullptr;
+}
+
+// the range of the long flag table starting with a name prefix, found by two
+// binary searches since the entries sharing a prefix are adjacent
+static void clags__find_long_prefix(const clags_args_t *args, const char *name,
+                                    size_t length, size_t *first,
+                                    size_t *count) {
+  size_t low = 0;
+  size_t high = args->long_count;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (clags__compare_long_name(name, length, &args->longs[mid]) > 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  *first = low;
+  high = args->long_count;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    const clags_long_entry_t *entry = &args->longs[mid];
+    if (entry->length >= length && memcmp(entry->name, name, length) == 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  *count = low - *first;
+}
+
+// the long flag of a name, or of a unique prefix with
+// `options.abbreviate_long_flags`; `candidates` receives the amount of long
+// flags an ambiguous prefix starts, which follow the first one in the table
+[[nodiscard]] static const clags_long_entry_t *
+clags__resolve_long_flag(const clags_config_t *config,
+                         const clags_args_t *args, const char *name,
+                         size_t length, size_t *candidates) {
+  *candidates = 0;
+  const clags_long_entry_t *entry = clags__find_long_flag(args, name, length);
+  if (entry != nullptr || !config->options.abbreviate_long_flags ||
+      length == 0)
+    return entry;
+  size_t first;
+  clags__find_long_prefix(args, name, length, &first, candidates);
+  if (*candidates != 1)
+    return *candidates == 0 ? nullptr : &args->longs[first];
+  *candidates = 0;
+  return &args->longs[first];
+}
+
+void clags__choice_usage(clags_sb_t *sb, clags_choices_t *choices,
+                         bool is_list) {
   if (!choices->print_no_details || choices->count >= 6) {
-    printf(" (%s%s)\n        Choices%s:\n", clags__type_names[Clags_Choice],
-           is_list ? "[]" : "",
-           choices->case_insensitive ? " (case-insensitive)" : "");
+    clags_sb_appendf(sb, " (%s%s)\n        Choices%s:\n",
+                     clags__type_names[Clags_Choice], is_list ? "[]" : "",
+                     choices->case_insensitive ? " (case-insensitive)" : "");
     for (size_t j = 0; j < choices->count; ++j) {
       clags_choice_t choice = choices->items[j];
-      printf("          - %*s : %s\n", CLAGS__USAGE_PRINTF_ALIGNMENT + 8,
-             choice.value, choice.description);
+      clags_sb_appendf(sb, "          - %*s : %s\n",
+                       CLAGS__USAGE_PRINTF_ALIGNMENT + 8, choice.value,
+                       choice.description);
     }
   } else {
-    printf(" (%s%s:", clags__type_names[Clags_Choice], is_list ? "[]" : "");
+    clags_sb_appendf(sb, " (%s%s:", clags__type_names[Clags_Choice],
+                     is_list ? "[]" : "");
     for (size_t j = 0; j < choices->count; ++j) {
-      printf("%s%s", j > 0 ? " | " : " ", choices->items[j].value);
+      clags_sb_appendf(sb, "%s%s", j > 0 ? " | " : " ",
+                       choices->items[j].value);
     }
-    printf(")");
+    clags__sb_append(sb, ")", 1);
   }
 }
 
-void clags__subcmd_usage(clags_subcmds_t *subcmds) {
-  printf(" (%s)\n      Subcommands:\n", clags__type_names[Clags_Subcmd]);
+void clags__subcmd_usage(clags_sb_t *sb, clags_subcmds_t *subcmds) {
+  clags_sb_appendf(sb, " (%s)\n      Subcommands:\n",
+                   clags__type_names[Clags_Subcmd]);
   for (size_t i = 0; i < subcmds->count; ++i) {
     clags_subcmd_t subcmd = subcmds->items[i];
-    printf("        - %*s : %s\n", CLAGS__USAGE_PRINTF_ALIGNMENT + 6,
-           subcmd.name, subcmd.description);
+    clags_sb_appendf(sb, "        - %*s : %s\n",
+                     CLAGS__USAGE_PRINTF_ALIGNMENT + 6, subcmd.name,
+                     subcmd.description);
   }
 }
 
-void clags__type_usage(clags_value_type_t type, void *data, bool is_list) {
+void clags__type_usage(clags_sb_t *sb, clags_value_type_t type, void *data,
+                       bool is_list) {
   switch (type) {
   case Clags_Choice: {
-    clags__choice_usage((clags_choices_t *)data, is_list);
+    clags__choice_usage(sb, (clags_choices_t *)data, is_list);
   } break;
   case Clags_Subcmd: {
-    clags__subcmd_usage((clags_subcmds_t *)data);
+    clags__subcmd_usage(sb, (clags_subcmds_t *)data);
   } break;
   case Clags_String: {
     if (is_list)
-      printf(" ([])");
+      clags__sb_append_cstr(sb, " ([])");
   } break;
   default: {
-    printf(" (%s%s)", clags__type_names[type], is_list ? "[]" : "");
+    clags_sb_appendf(sb, " (%s%s)", clags__type_names[type],
+                     is_list ? "[]" : "");
   }
   }
-  printf("\n");
+  clags__sb_append(sb, "\n", 1);
 }
 
-void clags__subcommand_path_usage(const char *program_name,
+void clags__subcommand_path_usage(clags_sb_t *sb, const char *program_name,
                                   clags_config_t *config) {
   if (config->parent) {
-    clags__subcommand_path_usage(program_name, config->parent);
-    printf(" %s", config->name ? config->name : "(subcommand)");
+    clags__subcommand_path_usage(sb, program_name, config->parent);
+    clags_sb_appendf(sb, " %s", config->name ? config->name : "(subcommand)");
   } else {
-    printf("Usage: %s", program_name);
+    clags_sb_appendf(sb, "Usage: %s", program_name);
   }
 }
 
-[[nodiscard]] static clags_config_t *
-clags__parse_internal(size_t argc, char **argv, clags_config_t *config,
-                      size_t depth) {
-  if (config == nullptr || config->args == nullptr || config->invalid)
-    return nullptr;
-  if (argv == nullptr || argc == 0) {
-    config->error = Clags_Error_InvalidOption;
-    return config;
-  }
-  if (argv[0] == nullptr) {
-    clags_log(config, Clags_Error, "Missing program name in parser input");
-    config->error = Clags_Error_InvalidOption;
-    return config;
-  }
-  if (depth > CLAGS_MAX_PARSE_DEPTH) {
-    clags_log(
-        config, Clags_Error,
-        "Subcommand nesting too deep: exceeded maximum parser depth of %zu",
-        (size_t)CLAGS_MAX_PARSE_DEPTH);
-    config->error = Clags_Error_InvalidOption;
-    return config;
-  }
-  // validate the configuration, exit and mark config as invalid on fatal error
-  if (!clags__validate_config(config)) {
-    config->invalid = true;
-    return config;
-  }
-
-  config->name = clags_config_duplicate_string(config, argv[0]);
-  config->error = Clags_Error_Ok;
-
-  clags_config_t *result = nullptr;
-
-  // sort arguments by type
-  clags_positional_t *positional =
-      CLAGS_CALLOC(config->args_count, sizeof(*positional));
-  clags_option_t *option = CLAGS_CALLOC(config->args_count, sizeof(*option));
-  clags_flag_t *flags = CLAGS_CALLOC(config->args_count, sizeof(*flags));
-  clags_assert(positional && option && flags, "Out of memory!");
-
-  clags_args_t args = {
-      .positional = positional, .option = option, .flags = flags};
-  clags__sort_args(&args, config);
-
+// count the items every list receives from argv, following the token rules of
+// `clags__parse_internal` without verifying or writing any values; stops at
+// subcommands, exit flags and malformed tokens, which the parse reports itself
+static void clags__count_list_items(size_t argc, char **argv,
+                                    const clags_config_t *config,
+                                    const clags_args_t *args,
+                                    size_t *option_counts,
+                                    size_t *positional_counts) {
   const char *ignore_prefix = config->options.ignore_prefix;
   size_t ignore_prefix_len = ignore_prefix ? strlen(ignore_prefix) : 0;
   const char *list_term = config->options.list_terminator;
+  size_t list_term_len = list_term ? strlen(list_term) : 0;
 
-  // parse arguments
-  bool arguments_ignored = false;
-  bool in_list = false;
-  bool parsing_optionals = false;
   bool accept_options = true;
+  bool in_list = false;
   size_t positional_count = 0;
-  size_t required_count = 0;
-  for (size_t index = 1; index < (size_t)argc; ++index) {
-    char *arg = argv[index];
-    if (arg == nullptr) {
-      clags_log(config, Clags_Error, "Invalid null argument at position %zu!",
-                index);
-      config->error = Clags_Error_InvalidOption;
-      clags_return_defer(config);
-    }
-
-    // toggle option and flag parsing based on '--'
-    if (strcmp(arg, "--") == 0) {
-      if (accept_options || config->options.allow_option_parsing_toggle) {
-        accept_options = !accept_options;
+  for (size_t index = 1; index < argc; ++index) {
+    const char *arg = argv[index];
+    if (arg == nullptr)
+      return;
+    clags__token_t token = clags__scan_token(arg);
+    if (token.kind == Clags__Token_Toggle &&
+        (accept_options || config->options.allow_option_parsing_toggle)) {
+      accept_options = !accept_options;
+      continue;
+    }
+    if (clags__token_starts_with(arg, &token, ignore_prefix,
+                                 ignore_prefix_len))
+      continue;
+    if (clags__token_equals(arg, &token, list_term, list_term_len)) {
+      if (in_list) {
+        in_list = false;
+        positional_count += 1;
+      }
+      continue;
+    }
+
+    size_t option = 0;
+    bool has_option = false;
+    bool takes_next = false;
+    if (accept_options && token.kind == Clags__Token_Long) {
+      size_t candidates;
+      const clags_long_entry_t *entry = clags__resolve_long_flag(
+          config, args, arg + 2, token.assignment - 2, &candidates);
+      if (entry == nullptr || candidates > 0)
+        return;
+      const clags_arg_t *target = &config->args[entry->index];
+      if (target->type == Clags_Flag) {
+        if (target->flag.exit)
+          return;
         continue;
       }
+      option = entry->index;
+      has_option = true;
+      takes_next = token.assignment == token.length;
+    } else if (accept_options && token.kind == Clags__Token_Short) {
+      for (const char *c = arg + 1; *c != '\0'; ++c) {
+        uint8_t slot = args->short_slots[(unsigned char)*c];
+        if (slot == 0)
+          return;
+        const clags_arg_t *target = &config->args[args->shorts[slot]];
+        if (target->type == Clags_Option) {
+          option = args->shorts[slot];
+          has_option = true;
+          takes_next = c[1] == '\0';
+          break;
+        }
+        if (target->flag.exit)
+          return;
+      }
+      if (!has_option)
+        continue;
+    } else {
+      if (positional_count >= args->positional_count)
+        return;
+      const clags_positional_t *pos = &args->positional[positional_count];
+      if (pos->value_type == Clags_Subcmd)
+        return;
+      if (pos->is_list) {
+        in_list = true;
+        positional_counts[positional_count] += 1;
+      } else {
+        positional_count += 1;
+      }
+      continue;
     }
 
-    // ignore arguments prefixed with `ignore_prefix`
-    if (ignore_prefix && strncmp(arg, ignore_prefix, ignore_prefix_len) == 0) {
-      arguments_ignored = true;
+    // skip the value of an option passed as the next not-ignored argument
+    if (takes_next) {
+      do {
+        if (++index >= argc || argv[index] == nullptr)
+          return;
+      } while (ignore_prefix &&
+               strncmp(argv[index], ignore_prefix, ignore_prefix_len) == 0);
+    }
+    if (config->args[option].opt.is_list)
+      option_counts[option] += 1;
+  }
+}
+
+// grow a list to exactly the counted amount of additional items, lists with
+// an invalid item size are left for the parse to report
+static inline void clags__presize_list(clags_config_t *config,
+                                       clags_value_type_t value_type,
+                                       clags_list_t *list, size_t count) {
+  if (count == 0 || list->on_element != nullptr || list->fixed ||
+      !clags__check_list_item_size(nullptr, value_type, nullptr, list))
+    return;
+  size_t capacity = 0;
+  clags_assert(!clags__checked_add_size(&capacity, list->count, count),
+               "List capacity overflow!");
+  clags__list_reserve(config, list, capacity);
+}
+
+// allocate every list of a config once, sized by a pre-scan of argv
+static void clags__presize_lists(size_t argc, char **argv,
+                                 clags_config_t *config,
+                                 const clags_args_t *args,
+                                 clags_context_t *context) {
+  // fixed and streamed lists never grow, so they need no pre-scan
+  bool has_lists = false;
+  for (size_t i = 0; i < config->args_count && !has_lists; ++i) {
+    const clags_arg_t *arg = &config->args[i];
+    const clags_list_t *list = nullptr;
+    if (arg->type == Clags_Option && arg->opt.is_list)
+      list = clags__variable(context, arg->opt.variable);
+    else if (arg->type == Clags_Positional && arg->pos.is_list)
+      list = clags__variable(context, arg->pos.variable);
+    has_lists = list != nullptr && !list->fixed && list->on_element == nullptr;
+  }
+  if (!has_lists)
+    return;
+
+  size_t count = 0;
+  clags_assert(!clags__checked_add_size(&count, config->args_count,
+                                        args->positional_count),
+               "List count overflow!");
+  size_t *option_counts = clags__calloc(count, sizeof(*option_counts));
+  clags_assert(option_counts != nullptr, "Out of memory!");
+  size_t *positional_counts = option_counts + config->args_count;
+  clags__count_list_items(argc, argv, config, args, option_counts,
+                          positional_counts);
+
+  for (size_t i = 0; i < config->args_count; ++i) {
+    const clags_arg_t *arg = &config->args[i];
+    if (arg->type == Clags_Option && arg->opt.is_list)
+      clags__presize_list(config, arg->opt.value_type,
+                          clags__variable(context, arg->opt.variable),
+                          option_counts[i]);
+  }
+  for (size_t i = 0; i < args->positional_count; ++i) {
+    const clags_positional_t *pos = &args->positional[i];
+    if (pos->is_list)
+      clags__presize_list(config, pos->value_type,
+                          clags__variable(context, pos->variable),
+                          positional_counts[i]);
+  }
+  CLAGS_FREE(option_counts);
+}
+
+// the configs entered by a parse, kept in the parser so cycles are detected
+// without touching the configs themselves
+[[nodiscard]] static inline bool
+clags__has_config_cycle(const clags_parser_t *parser,
+                        const clags_config_t *candidate) {
+  for (size_t i = 0; i < parser->depth; ++i) {
+    if (parser->path[i] == candidate) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// a share of the deferred path checks, every `stride`-th from `first` on
+typedef struct {
+  clags__path_check_t *checks;
+  size_t count;
+  size_t first;
+  size_t stride;
+} clags__path_worker_t;
+
+static int clags__path_worker(void *data) {
+  clags__path_worker_t *worker = data;
+  for (size_t i = worker->first; i < worker->count; i += worker->stride) {
+    clags__path_check_t *check = &worker->checks[i];
+    check->error = stat(check->path, &check->attr) == -1 ? errno : 0;
+  }
+  return 0;
+}
+
+// stat all deferred paths, spread over threads for large batches, then
+// report the first failing check in argument order
+[[nodiscard]] static clags_config_t *
+clags__run_path_checks(clags_parser_t *parser) {
+  clags__path_check_t *checks = parser->path_checks.items;
+  size_t count = parser->path_checks.count;
+  if (count == 0)
+    return nullptr;
+  [[maybe_unused]] uint64_t stat_started = clags__stats_clock();
+
+  size_t stride = count / CLAGS_PATH_CHECK_BATCH;
+  if (stride > CLAGS_PATH_CHECK_THREADS)
+    stride = CLAGS_PATH_CHECK_THREADS;
+  if (stride == 0)
+    stride = 1;
+  clags__path_worker_t workers[CLAGS_PATH_CHECK_THREADS];
+  for (size_t i = 0; i < stride; ++i) {
+    workers[i] = (clags__path_worker_t){
+        .checks = checks, .count = count, .first = i, .stride = stride};
+  }
+#ifndef __STDC_NO_THREADS__
+  // shares whose thread fails to start are checked on this thread instead
+  thrd_t threads[CLAGS_PATH_CHECK_THREADS];
+  bool started[CLAGS_PATH_CHECK_THREADS] = {0};
+  for (size_t i = 1; i < stride; ++i) {
+    started[i] = thrd_create(&threads[i], clags__path_worker, &workers[i]) ==
+                 thrd_success;
+  }
+  clags__path_worker(&workers[0]);
+  for (size_t i = 1; i < stride; ++i) {
+    if (started[i])
+      thrd_join(threads[i], nullptr);
+    else
+      clags__path_worker(&workers[i]);
+  }
+#else
+  for (size_t i = 0; i < stride; ++i) {
+    clags__path_worker(&workers[i]);
+  }
+#endif // __STDC_NO_THREADS__
+  clags__stats_add(path_checks, count);
+  clags__stats_add(path_check_ns, clags__stats_clock() - stat_started);
+
+  for (size_t i = 0; i < count; ++i) {
+    clags__path_check_t *check = &checks[i];
+    if (!clags__check_path(check->config, check->arg_name, check->path,
+                           check->value_type, &check->attr, check->error)) {
+      clags__set_error(check->config, parser->context,
+                       Clags_Error_InvalidValue);
+      clags_error_record_t *record =
+          clags__error_record(check->config, parser->context);
+      record->index = check->index;
+      record->arg_name = check->arg_name;
+      record->token = check->path;
+      record->token_length = strlen(check->path);
+      record->expected = check->value_type;
+      return check->config;
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    clags__path_check_t *check = &checks[i];
+    clags_list_t *stats = check->stats;
+    if (stats == nullptr)
       continue;
+    if (stats->item_size != sizeof(clags_path_stat_t)) {
+      clags__log(check->config, Clags_Error,
+                 "List item size mismatch for path stats: expected %zu, got "
+                 "%zu!",
+                 sizeof(clags_path_stat_t), stats->item_size);
+      clags__set_error(check->config, parser->context,
+                       Clags_Error_InvalidValue);
+      return check->config;
     }
+    if (clags__list_full(check->config, stats, "path stats")) {
+      clags__set_error(check->config, parser->context,
+                       Clags_Error_InvalidValue);
+      return check->config;
+    }
+    clags_path_stat_t path_stat = {.path = check->path, .attr = check->attr};
+    clags__list_append_item(check->config, stats, &path_stat);
+  }
+  return nullptr;
+}
 
-    // detect list terminator
-    if (list_term && strcmp(arg, list_term) == 0) {
-      if (in_list) {
-        in_list = false;
-        positional_count += 1;
-        if (!parsing_optionals)
-          required_count += 1;
+static inline void clags__parser_release(clags_parser_t *parser) {
+  if (parser->args == &parser->local_args)
+    clags__free_args(&parser->local_args);
+  parser->args = nullptr;
+  CLAGS_FREE(parser->path_checks.items);
+  parser->path_checks = (clags_list_t){0};
+  CLAGS_FREE(parser->held_lists.items);
+  parser->held_lists = (clags_list_t){0};
+}
+
+// stop the parse after an error in the current (sub)command
+[[nodiscard]] static clags_config_t *
+clags__parser_fail(clags_parser_t *parser) {
+  clags__parser_release(parser);
+  parser->failed = parser->config;
+  return parser->failed;
+}
+
+// describe the error just set on the current (sub)command, `token` being the
+// offending part of the token at `index`
+static inline void clags__parser_describe(clags_parser_t *parser, size_t index,
+                                          const char *arg_name,
+                                          const char *token, size_t length,
+                                          clags_value_type_t expected) {
+  clags_error_record_t *record =
+      clags__error_record(parser->config, parser->context);
+  record->index = index;
+  record->arg_name = arg_name;
+  record->token = token;
+  record->token_length = length;
+  record->expected = expected;
+}
+
+// the token of a value awaiting its conversion, see
+// `clags_options_t.lazy_conversion`
+typedef struct {
+  clags_config_t *config; // the config of the value's argument
+  void *variable;         // the argument's variable, unresolved
+  clags_value_type_t value_type;
+  const char *arg_name; // the flag or name the token was given through
+  const char *name;     // the argument's name in the error record
+  const char *token;
+  void *data;
+  clags_custom_verify_func_t verify;
+  bool is_list;
+  size_t index;   // the argv index of `token`
+  bool converted; // the conversion ran, with `failed` as its result
+  bool failed;
+} clags__lazy_value_t;
+
+// record a value for its conversion on first access instead of converting
+// it, if its config converts lazily. Strings need no conversion and
+// subcommands steer the parse, so both are always set right away
+[[nodiscard]] static inline bool
+clags__parser_defer_value(clags_parser_t *parser,
+                          const clags__lazy_value_t *value) {
+  if (!parser->config->options.lazy_conversion ||
+      value->value_type == Clags_String || value->value_type == Clags_Subcmd ||
+      !clags__is_valid_value_type(value->value_type))
+    return false;
+  clags_list_t *values = parser->lazy_values;
+  if (values->item_size == 0)
+    values->item_size = sizeof(*value);
+  clags__list_push(values, value);
+  return true;
+}
+
+// whether the values of an argument were recorded for their conversion
+[[nodiscard]] static inline bool
+clags__parser_has_lazy_values(const clags_parser_t *parser,
+                              const void *variable) {
+  const clags__lazy_value_t *values = parser->lazy_values->items;
+  for (size_t i = 0; i < parser->lazy_values->count; ++i) {
+    if (values[i].variable == variable)
+      return true;
+  }
+  return false;
+}
+
+// hand a value to an option, `arg_name` being the flag it was given through
+// and `index` the argv index of the value
+[[nodiscard]] static inline clags_config_t *
+clags__parser_set_option(clags_parser_t *parser, const clags_option_t *opt,
+                         const char *arg_name, const char *value,
+                         size_t index) {
+  clags_custom_verify_func_t verify =
+      opt->value_type == Clags_Custom ? opt->verify : nullptr;
+  clags__lazy_value_t lazy = {.config = parser->config,
+                              .variable = opt->variable,
+                              .value_type = opt->value_type,
+                              .arg_name = arg_name,
+                              .name = clags__option_name(opt),
+                              .token = value,
+                              .data = opt->_data,
+                              .verify = verify,
+                              .is_list = opt->is_list,
+                              .index = index};
+  if (clags__parser_defer_value(parser, &lazy))
+    return nullptr;
+  if (!clags__set_arg(parser->config, parser->context, &parser->path_checks,
+                      index, opt->value_type, arg_name, value, opt->variable,
+                      opt->_data, verify, opt->is_list)) {
+    clags__parser_describe(parser, index, clags__option_name(opt), value,
+                           strlen(value), opt->value_type);
+    return clags__parser_fail(parser);
+  }
+  return nullptr;
+}
+
+// a config file or environment value of a list option, see
+// `clags_parser_t.held_lists`
+typedef struct {
+  const clags_option_t *opt;
+  const char *arg_name; // the key or variable name giving the value
+  const char *value;
+  bool from_env; // the value belongs to the environment layer
+  bool applied;  // handed to the list when leaving the (sub)command
+} clags__held_value_t;
+
+// hold back a list value of a lower layer, see `clags_parser_t.held_lists`
+static inline void clags__parser_hold(clags_parser_t *parser,
+                                      const clags_option_t *opt,
+                                      const char *arg_name, const char *value,
+                                      bool from_env) {
+  clags__held_value_t held = {
+      .opt = opt, .arg_name = arg_name, .value = value, .from_env = from_env};
+  if (parser->held_lists.item_size == 0)
+    parser->held_lists.item_size = sizeof(held);
+  clags__list_push(&parser->held_lists, &held);
+}
+
+// a `key = value` line of a config file, see `clags__tokenize_config_file`
+typedef struct {
+  const char *path;    // the path of the config file
+  const char *section; // the name of the enclosing `[name]` header, if any
+  const char *key;
+  const char *value;
+  size_t line;
+} clags__file_entry_t;
+
+// whether a section names the subcommand path the parser is in, the names
+// below the root separated by dots; the root's keys have no section
+[[nodiscard]] static bool
+clags__parser_in_section(const clags_parser_t *parser, const char *section) {
+  if (section == nullptr || parser->depth == 1)
+    return section == nullptr && parser->depth == 1;
+  for (size_t i = 1; i < parser->depth; ++i) {
+    size_t length = strlen(parser->names[i]);
+    if (strncmp(section, parser->names[i], length) != 0)
+      return false;
+    section += length;
+    if (i + 1 < parser->depth && *section++ != '.')
+      return false;
+  }
+  return *section == '\0';
+}
+
+// apply the config file section of the current (sub)command
+[[nodiscard]] static clags_config_t *
+clags__parser_load_file(clags_parser_t *parser) {
+  if (parser->file_entries == nullptr)
+    return nullptr;
+  clags_config_t *config = parser->config;
+  clags_context_t *context = parser->context;
+  const clags__file_entry_t *entries = parser->file_entries->items;
+  for (size_t i = 0; i < parser->file_entries->count; ++i) {
+    const clags__file_entry_t *entry = &entries[i];
+    if (!clags__parser_in_section(parser, entry->section))
+      continue;
+    const clags_long_entry_t *match =
+        clags__find_long_flag(parser->args, entry->key, strlen(entry->key));
+    if (match == nullptr) {
+      clags__log(config, Clags_Error,
+                 "Unknown key '%s' in config file '%s' line %zu!", entry->key,
+                 entry->path, entry->line);
+      clags__set_error(config, context, Clags_Error_InvalidOption);
+      clags__parser_describe(parser, 0, nullptr, entry->key,
+                             strlen(entry->key), Clags_String);
+      return clags__parser_fail(parser);
+    }
+    clags_arg_t *arg = &config->args[match->index];
+    if (arg->type == Clags_Option) {
+      if (arg->opt.is_list && !parser->file_only) {
+        clags__parser_hold(parser, &arg->opt, entry->key, entry->value, false);
+        continue;
       }
+      clags_config_t *failed = clags__parser_set_option(
+          parser, &arg->opt, entry->key, entry->value, 0);
+      if (failed != nullptr)
+        return failed;
       continue;
     }
-    if (accept_options && strncmp(arg, "--", 2) == 0) {
-      // parse long flag or option
-      arg += 2;
-      if (*arg == '\0') {
-        clags_log(config, Clags_Error, "Missing flag or option name: '--%s'!",
-                  arg);
-        config->error = Clags_Error_InvalidOption;
-        clags_return_defer(config);
+    // flags take a boolean, only bool flags are cleared by false
+    bool enabled = false;
+    if (!clags__verify(Clags_Bool, config, entry->key, entry->value, &enabled,
+                       nullptr)) {
+      clags__set_error(config, context, Clags_Error_InvalidValue);
+      clags__parser_describe(parser, 0, entry->key, entry->value,
+                             strlen(entry->value), Clags_Bool);
+      return clags__parser_fail(parser);
+    }
+    bool *variable = clags__variable(context, arg->flag.variable);
+    if (enabled)
+      clags__set_flag(config, context, &arg->flag);
+    else if (arg->flag.type == Clags_BoolFlag && variable != nullptr)
+      *variable = false;
+  }
+  return nullptr;
+}
+
+// hand the environment variables bound to options of the current (sub)command
+// to them in one pass over `environ`, before any value of argv replaces them.
+// The values of list options are held back until the (sub)command is left
+[[nodiscard]] static clags_config_t *
+clags__parser_load_env(clags_parser_t *parser) {
+  const clags_args_t *args = parser->args;
+  if (args->env_capacity == 0 || parser->file_only || environ == nullptr)
+    return nullptr;
+  const clags_arg_t *config_args = parser->config->args;
+  size_t mask = args->env_capacity - 1;
+  for (char **entry = environ; *entry != nullptr; ++entry) {
+    const char *name = *entry;
+    const char *assignment = clags__strchrnull(name, '=');
+    if (*assignment == '\0' || assignment[1] == '\0')
+      continue;
+    size_t length = (size_t)(assignment - name);
+    size_t slot = (size_t)clags__prefix_hash(name, length) & mask;
+    for (; args->env_slots[slot] != 0; slot = (slot + 1) & mask) {
+      const clags_option_t *opt = &config_args[args->env_slots[slot] - 1].opt;
+      if (strncmp(opt->env, name, length) != 0 || opt->env[length] != '\0')
+        continue;
+      if (opt->is_list) {
+        clags__parser_hold(parser, opt, opt->env, assignment + 1, true);
+      } else {
+        clags_config_t *failed =
+            clags__parser_set_option(parser, opt, opt->env, assignment + 1, 0);
+        if (failed != nullptr)
+          return failed;
       }
+      break;
+    }
+  }
+  return nullptr;
+}
 
-      // parse long option
-      for (size_t i = 0; i < args.option_count; ++i) {
-        clags_option_t opt = args.option[i];
-        if (opt.long_flag == nullptr)
-          continue;
-        size_t long_flag_len = strlen(opt.long_flag);
-        if (strncmp(arg, opt.long_flag, long_flag_len) == 0) {
-          char *value = arg + long_flag_len;
-          if (*value == '\0') {
-            // get value from the next not-ignored argument
-            while (true) {
-              if (argc - index <= 1) {
-                clags_log(config, Clags_Error,
-                          "Option flag %s requires argument!", arg);
-                config->error = Clags_Error_InvalidOption;
-                clags_return_defer(config);
-              }
-              value = argv[++index];
-              if (value == nullptr) {
-                clags_log(config, Clags_Error,
-                          "Invalid null argument at position %zu!", index);
-                config->error = Clags_Error_InvalidOption;
-                clags_return_defer(config);
-              }
-              if (!ignore_prefix ||
-                  strncmp(value, ignore_prefix, ignore_prefix_len) != 0)
-                break;
-              arguments_ignored = true;
-            }
-          } else if (*value++ == '=') {
-            if (*value == '\0') {
-              clags_log(config, Clags_Error,
-                        "Designated option assignment may not have an empty "
-                        "value: '%s'!",
-                        arg);
-              config->error = Clags_Error_InvalidOption;
-              clags_return_defer(config);
-            }
-          } else {
-            continue;
-          }
-          clags_custom_verify_func_t verify =
-              opt.value_type == Clags_Custom ? opt.verify : nullptr;
-          if (!clags__set_arg(config, opt.value_type, arg, value, opt.variable,
-                              opt._data, verify, opt.is_list))
-            clags_return_defer(config);
-          goto next;
-        }
+// hand the held back values to the list options of the current (sub)command
+// that argv gave no value, the environment's replacing the config file's
+[[nodiscard]] static clags_config_t *
+clags__parser_apply_held_lists(clags_parser_t *parser) {
+  clags__held_value_t *held = parser->held_lists.items;
+  size_t count = parser->held_lists.count;
+  for (size_t i = 0; i < count; ++i) {
+    const clags_list_t *list =
+        clags__variable(parser->context, held[i].opt->variable);
+    held[i].applied =
+        list == nullptr ||
+        (list->count == 0 && list->streamed == 0 &&
+         !clags__parser_has_lazy_values(parser, held[i].opt->variable));
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (!held[i].applied || !held[i].from_env)
+      continue;
+    for (size_t j = 0; j < count; ++j) {
+      if (!held[j].from_env && held[j].opt == held[i].opt)
+        held[j].applied = false;
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    if (!held[i].applied)
+      continue;
+    clags_config_t *failed = clags__parser_set_option(
+        parser, held[i].opt, held[i].arg_name, held[i].value, 0);
+    if (failed != nullptr)
+      return failed;
+  }
+  parser->held_lists.count = 0;
+  return nullptr;
+}
+
+// stop the parse successfully, ignoring all following tokens, once the
+// deferred path checks passed
+[[nodiscard]] static clags_config_t *
+clags__parser_finish(clags_parser_t *parser) {
+  parser->finished = true;
+  parser->failed = clags__run_path_checks(parser);
+  clags__parser_release(parser);
+  return parser->failed;
+}
+
+// enter a (sub)command config, `name` being the token that selected it.
+// `compile` caches the tables of an uncompiled config on it
+[[nodiscard]] static clags_config_t *
+clags__parser_enter(clags_parser_t *parser, clags_config_t *config,
+                    const char *name, bool compile) {
+  clags_context_t *context = parser->context;
+  parser->config = config;
+  if (config == nullptr || config->args == nullptr || config->invalid)
+    return clags__parser_finish(parser);
+  if (name == nullptr) {
+    clags__log(config, Clags_Error, "Missing program name in parser input");
+    clags__set_error(config, context, Clags_Error_InvalidOption);
+    return clags__parser_fail(parser);
+  }
+  if (parser->depth >= CLAGS_MAX_PARSE_DEPTH) {
+    clags__log(
+        config, Clags_Error,
+        "Subcommand nesting too deep: exceeded maximum parser depth of %zu",
+        (size_t)CLAGS_MAX_PARSE_DEPTH);
+    clags__set_error(config, context, Clags_Error_InvalidOption);
+    return clags__parser_fail(parser);
+  }
+  // use the compiled tables, or validate and build temporary ones
+  parser->args = config->compiled;
+  if (parser->args == nullptr && compile) {
+    if (!clags__compile(config)) {
+      clags__parser_release(parser);
+      parser->failed = config;
+      return config;
+    }
+    config->compiled_lazily = true;
+    parser->args = config->compiled;
+  } else if (parser->args == nullptr) {
+    if (!clags__build_args(&parser->local_args, config, context)) {
+      clags__parser_release(parser);
+      parser->failed = config;
+      return config;
+    }
+    parser->args = &parser->local_args;
+  }
+
+  // a context receives all parse state, leaving the config untouched
+  name = clags_config_duplicate_string(config, name);
+  if (context != nullptr) {
+    context->config = config;
+    context->name = name;
+  } else {
+    config->name = name;
+  }
+  clags__set_error(config, context, Clags_Error_Ok);
+  if (parser->depth == 0) {
+    parser->lazy_values =
+        context != nullptr ? &context->lazy_values : &config->lazy_values;
+    parser->lazy_values->count = 0;
+  }
+  parser->names[parser->depth] = name;
+  parser->path[parser->depth++] = config;
+  if (parser->depth > 1) {
+    clags__stats_add(subcmd_descents, 1);
+    clags__stats_max(max_subcmd_depth, parser->depth - 1);
+  }
+
+  parser->index = 1;
+  parser->pending = nullptr;
+  parser->pending_name = nullptr;
+  parser->ignore_prefix_length = config->options.ignore_prefix
+                                     ? strlen(config->options.ignore_prefix)
+                                     : 0;
+  parser->list_terminator_length =
+      config->options.list_terminator
+          ? strlen(config->options.list_terminator)
+          : 0;
+  parser->arguments_ignored = false;
+  parser->in_list = false;
+  parser->parsing_optionals = false;
+  parser->accept_options = true;
+  parser->positional_count = 0;
+  parser->required_count = 0;
+
+  // the rest of the vector is known when parsing a whole argv at once
+  if (config->options.presize_lists && parser->argv != nullptr)
+    clags__presize_lists(parser->argc - parser->position,
+                         parser->argv + parser->position, config,
+                         parser->args, context);
+  clags_config_t *failed = clags__parser_load_file(parser);
+  if (failed != nullptr)
+    return failed;
+  return clags__parser_load_env(parser);
+}
+
+[[nodiscard]] static clags_config_t *clags__parser_feed(clags_parser_t *parser,
+                                                        const char *arg) {
+  if (parser->failed != nullptr)
+    return parser->failed;
+  if (parser->finished)
+    return nullptr;
+  clags_config_t *config = parser->config;
+  clags_context_t *context = parser->context;
+  const clags_args_t *args = parser->args;
+  size_t index = parser->index++;
+  size_t position = parser->position++;
+
+  const char *ignore_prefix = config->options.ignore_prefix;
+  size_t ignore_prefix_len = parser->ignore_prefix_length;
+  const char *list_term = config->options.list_terminator;
+  size_t list_term_len = parser->list_terminator_length;
+
+  if (arg == nullptr) {
+    clags__log(config, Clags_Error, "Invalid null argument at position %zu!",
+               index);
+    clags__set_error(config, context, Clags_Error_InvalidOption);
+    clags__parser_describe(parser, position, nullptr, nullptr, 0,
+                           Clags_String);
+    return clags__parser_fail(parser);
+  }
+
+  // classify the token once, every rule below dispatches on the result
+  clags__token_t token = clags__scan_token(arg);
+
+  // an option waits for the next not-ignored argument as its value
+  if (parser->pending != nullptr) {
+    if (clags__token_starts_with(arg, &token, ignore_prefix,
+                                 ignore_prefix_len)) {
+      parser->arguments_ignored = true;
+      return nullptr;
+    }
+    const clags_option_t *opt = parser->pending;
+    parser->pending = nullptr;
+    return clags__parser_set_option(parser, opt, parser->pending_name, arg,
+                                    position);
+  }
+
+  // toggle option and flag parsing based on '--'
+  if (token.kind == Clags__Token_Toggle) {
+    if (parser->accept_options || config->options.allow_option_parsing_toggle) {
+      parser->accept_options = !parser->accept_options;
+      return nullptr;
+    }
+  }
+
+  // ignore arguments prefixed with `ignore_prefix`
+  if (clags__token_starts_with(arg, &token, ignore_prefix, ignore_prefix_len)) {
+    parser->arguments_ignored = true;
+    return nullptr;
+  }
+
+  // detect list terminator
+  if (clags__token_equals(arg, &token, list_term, list_term_len)) {
+    if (parser->in_list) {
+      parser->in_list = false;
+      parser->positional_count += 1;
+      if (!parser->parsing_optionals)
+        parser->required_count += 1;
+    }
+    return nullptr;
+  }
+  if (parser->accept_options && token.kind == Clags__Token_Long) {
+    // parse long flag or option
+    arg += 2;
+    if (*arg == '\0') {
+      clags__log(config, Clags_Error, "Missing flag or option name: '--%s'!",
+                 arg);
+      clags__set_error(config, context, Clags_Error_InvalidOption);
+      clags__parser_describe(parser, position, nullptr, arg - 2, 2,
+                             Clags_String);
+      return clags__parser_fail(parser);
+    }
+
+    // look up the name in front of a designated assignment
+    const char *assignment = arg + (token.assignment - 2);
+    size_t name_length = (size_t)(assignment - arg);
+    size_t candidates;
+    const clags_long_entry_t *entry =
+        clags__resolve_long_flag(config, args, arg, name_length, &candidates);
+    if (candidates > 0) {
+      clags_sb_t names = {0};
+      for (size_t i = 0; i < candidates; ++i) {
+        clags_sb_appendf(&names, "%s--%s", i > 0 ? ", " : "", entry[i].name);
       }
-      // parse long flags
-      for (size_t i = 0; i < args.flag_count; ++i) {
-        clags_flag_t flag = args.flags[i];
-        if (flag.long_flag && strcmp(arg, flag.long_flag) == 0) {
-          clags__set_flag(config, &flag);
-          if (flag.exit)
-            clags_return_defer(nullptr);
-          goto next;
-        }
+      clags__log(config, Clags_Error,
+                 "Ambiguous long flag or option '--%.*s', candidates: %.*s!",
+                 (int)name_length, arg, (int)names.count, names.items);
+      clags_sb_free(&names);
+      clags__set_error(config, context, Clags_Error_InvalidOption);
+      clags__parser_describe(parser, position, nullptr, arg, name_length,
+                             Clags_String);
+      return clags__parser_fail(parser);
+    }
+    if (entry != nullptr && config->args[entry->index].type == Clags_Option) {
+      // parse long option
+      const clags_option_t *opt = &config->args[entry->index].opt;
+      const char *value = assignment;
+      if (*value == '\0') {
+        parser->pending = opt;
+        parser->pending_name = arg;
+        parser->pending_index = position;
+        return nullptr;
       }
-      clags_log(config, Clags_Error, "Unknown long flag or option: '--%s'!",
-                arg);
-      config->error = Clags_Error_InvalidOption;
-      clags_return_defer(config);
-    } else if (accept_options && *arg == '-' &&
-               !isdigit((unsigned char)arg[1])) {
-      // parse short flag or option
-      arg += 1;
-      size_t flag_len = strlen(arg);
-      if (flag_len == 0) {
-        clags_log(config, Clags_Error, "Missing flag or option name: '-'!");
-        config->error = Clags_Error_InvalidOption;
-        clags_return_defer(config);
+      if (*++value == '\0') {
+        clags__log(config, Clags_Error,
+                   "Designated option assignment may not have an empty "
+                   "value: '%s'!",
+                   arg);
+        clags__set_error(config, context, Clags_Error_InvalidOption);
+        clags__parser_describe(parser, position, opt->long_flag, arg,
+                               name_length + 1, opt->value_type);
+        return clags__parser_fail(parser);
       }
-      for (char *c = arg; c < arg + flag_len; ++c) {
-        // check for short option
-        for (size_t i = 0; i < args.option_count; ++i) {
-          clags_option_t opt = args.option[i];
-          if (*c == opt.short_flag) {
-            char *value = c + 1;
-            if (*value == '\0') {
-              while (true) {
-                if (argc - index <= 1) {
-                  clags_log(config, Clags_Error,
-                            "Option flag %s requires argument!", arg);
-                  config->error = Clags_Error_InvalidOption;
-                  clags_return_defer(config);
-                }
-                value = argv[++index];
-                if (value == nullptr) {
-                  clags_log(config, Clags_Error,
-                            "Invalid null argument at position %zu!", index);
-                  config->error = Clags_Error_InvalidOption;
-                  clags_return_defer(config);
-                }
-                if (!ignore_prefix ||
-                    strncmp(value, ignore_prefix, ignore_prefix_len) != 0)
-                  break;
-                arguments_ignored = true;
-              }
-            }
-            clags_custom_verify_func_t verify =
-                opt.value_type == Clags_Custom ? opt.verify : nullptr;
-            if (!clags__set_arg(config, opt.value_type, arg, value,
-                                opt.variable, opt._data, verify, opt.is_list))
-              clags_return_defer(config);
-            goto next;
-          }
-        }
-        bool matched = false;
-        for (size_t i = 0; i < args.flag_count; ++i) {
-          clags_flag_t flag = args.flags[i];
-          if (*c == flag.short_flag) {
-            clags__set_flag(config, &flag);
-            if (flag.exit)
-              clags_return_defer(nullptr);
-            matched = true;
-          }
-        }
-        if (!matched) {
-          if (flag_len > 1) {
-            clags_log(config, Clags_Error,
-                      "Unknown short flag '-%c' in combination '-%s'!", *c,
-                      arg);
-          } else {
-            clags_log(config, Clags_Error, "Unknown short flag '-%c'!", *c);
-          }
-          config->error = Clags_Error_InvalidOption;
-          clags_return_defer(config);
+      return clags__parser_set_option(parser, opt, arg, value, position);
+    }
+    // parse long flags, which never take a designated value
+    if (entry != nullptr && *assignment == '\0') {
+      clags_flag_t *flag = &config->args[entry->index].flag;
+      clags__set_flag(config, context, flag);
+      if (flag->exit)
+        return clags__parser_finish(parser);
+      return nullptr;
+    }
+    clags__log(config, Clags_Error, "Unknown long flag or option: '--%s'!",
+               arg);
+    clags__set_error(config, context, Clags_Error_InvalidOption);
+    clags__parser_describe(parser, position, nullptr, arg,
+                           (size_t)(assignment - arg), Clags_String);
+    return clags__parser_fail(parser);
+  } else if (parser->accept_options && token.kind == Clags__Token_Short) {
+    // parse short flag or option
+    arg += 1;
+    size_t flag_len = token.length - 1;
+    if (flag_len == 0) {
+      clags__log(config, Clags_Error, "Missing flag or option name: '-'!");
+      clags__set_error(config, context, Clags_Error_InvalidOption);
+      clags__parser_describe(parser, position, nullptr, arg - 1, 1,
+                             Clags_String);
+      return clags__parser_fail(parser);
+    }
+    for (const char *c = arg; c < arg + flag_len; ++c) {
+      uint8_t slot = args->short_slots[(unsigned char)*c];
+      if (slot == 0) {
+        if (flag_len > 1) {
+          clags__log(config, Clags_Error,
+                     "Unknown short flag '-%c' in combination '-%s'!", *c, arg);
+        } else {
+          clags__log(config, Clags_Error, "Unknown short flag '-%c'!", *c);
         }
+        clags__set_error(config, context, Clags_Error_InvalidOption);
+        clags__parser_describe(parser, position, nullptr, c, 1, Clags_String);
+        return clags__parser_fail(parser);
       }
-    } else {
-      // parse positional argument
-      if (positional_count >= args.positional_count) {
-        clags_log(config, Clags_Error,
-                  "Unknown additional argument (%zu/%zu): '%s'!",
-                  positional_count + 1, args.positional_count, arg);
-        config->error = Clags_Error_TooManyArguments;
-        clags_return_defer(config);
+      clags_arg_t *target = &config->args[args->shorts[slot]];
+      if (target->type == Clags_Option) {
+        // an option consumes the rest of the token or the next argument
+        if (c[1] == '\0') {
+          parser->pending = &target->opt;
+          parser->pending_name = arg;
+          parser->pending_index = position;
+          return nullptr;
+        }
+        return clags__parser_set_option(parser, &target->opt, arg, c + 1,
+                                        position);
       }
+      clags_flag_t *flag = &target->flag;
+      clags__set_flag(config, context, flag);
+      if (flag->exit)
+        return clags__parser_finish(parser);
+    }
+    return nullptr;
+  }
 
-      // verify and write argument
-      clags_positional_t pos = args.positional[positional_count];
+  // parse positional argument
+  if (parser->positional_count >= args->positional_count) {
+    clags__log(config, Clags_Error,
+               "Unknown additional argument (%zu/%zu): '%s'!",
+               parser->positional_count + 1, args->positional_count, arg);
+    clags__set_error(config, context, Clags_Error_TooManyArguments);
+    clags__parser_describe(parser, position, nullptr, arg, token.length,
+                           Clags_String);
+    return clags__parser_fail(parser);
+  }
 
-      // parse subcommands
-      if (pos.value_type == Clags_Subcmd) {
-        clags_subcmd_t **subcmd = pos.variable;
-        if (!clags__verify_funcs[pos.value_type](config, pos.arg_name, arg,
-                                                 subcmd, pos.subcmds))
-          clags_return_defer(config);
-        if (subcmd == nullptr)
-          clags_return_defer(nullptr);
-        clags_config_t *child_config = (*subcmd)->config;
-        if (child_config != nullptr) {
-          if (clags__has_config_cycle(config, child_config)) {
-            clags_log(config, Clags_Error,
-                      "Cycle detected while selecting subcommand '%s'!", arg);
-            config->error = Clags_Error_InvalidOption;
-            clags_return_defer(config);
-          }
-          child_config->parent = config;
-        }
-        clags_return_defer(clags__parse_internal(
-            (size_t)argc - index, argv + index, child_config, depth + 1));
+  // verify and write argument
+  clags_positional_t pos = args->positional[parser->positional_count];
+
+  // parse subcommands
+  if (pos.value_type == Clags_Subcmd) {
+    clags_subcmd_t **subcmd = clags__variable(context, pos.variable);
+    if (args->subcmd_slots != nullptr) {
+      [[maybe_unused]] uint64_t started = clags__stats_clock();
+      clags_subcmd_t *match = clags__find_subcmd(args, pos.subcmds, arg);
+      clags__stats_add(verifier_calls[Clags_Subcmd], 1);
+      clags__stats_add(verifier_ns[Clags_Subcmd],
+                       clags__stats_clock() - started);
+      if (match == nullptr) {
+        clags__log(config, Clags_Error,
+                   "unknown subcommand '%s' for argument '%s'!", arg,
+                   pos.arg_name);
+        clags__set_error(config, context, Clags_Error_InvalidValue);
+        clags__parser_describe(parser, position, pos.arg_name, arg,
+                               strlen(arg), Clags_Subcmd);
+        return clags__parser_fail(parser);
       }
-      if (pos.is_list) {
-        in_list = true;
-      } else {
-        positional_count += 1;
-        if (!pos.optional)
-          required_count += 1;
+      if (subcmd != nullptr)
+        *subcmd = match;
+    } else if (!clags__verify(pos.value_type, config, pos.arg_name, arg,
+                              subcmd, pos.subcmds)) {
+      clags__set_error(config, context, Clags_Error_InvalidValue);
+      clags__parser_describe(parser, position, pos.arg_name, arg, strlen(arg),
+                             Clags_Subcmd);
+      return clags__parser_fail(parser);
+    }
+    if (subcmd == nullptr)
+      return clags__parser_finish(parser);
+    clags_config_t *child_config = (*subcmd)->config;
+    if (child_config != nullptr) {
+      if (clags__has_config_cycle(parser, child_config)) {
+        clags__log(config, Clags_Error,
+                   "Cycle detected while selecting subcommand '%s'!", arg);
+        clags__set_error(config, context, Clags_Error_InvalidOption);
+        clags__parser_describe(parser, position, pos.arg_name, arg,
+                               strlen(arg), Clags_Subcmd);
+        return clags__parser_fail(parser);
       }
-      parsing_optionals = pos.optional;
-      clags_custom_verify_func_t verify =
-          pos.value_type == Clags_Custom ? pos.verify : nullptr;
-      if (!clags__set_arg(config, pos.value_type, pos.arg_name, arg,
-                          pos.variable, pos._data, verify, pos.is_list))
-        clags_return_defer(config);
-    }
-  next:
-    continue;
-  }
-  if (in_list) {
-    positional_count += 1;
-    if (!parsing_optionals)
-      required_count += 1;
-  }
-  if (arguments_ignored)
-    clags_log(config, Clags_Warning,
-              "Arguments were ignored because they were prefixed with '%s'",
-              ignore_prefix);
+      if (context == nullptr)
+        child_config->parent = config;
+    }
+    clags_config_t *failed = clags__parser_apply_held_lists(parser);
+    if (failed != nullptr)
+      return failed;
+    // the subcommand's token becomes the child's program name. Below a
+    // compiled config, only the configs on the selected path get compiled
+    bool compile = context == nullptr && args == config->compiled;
+    if (parser->args == &parser->local_args)
+      clags__free_args(&parser->local_args);
+    parser->args = nullptr;
+    parser->position--;
+    clags_config_t *result =
+        clags__parser_enter(parser, child_config, arg, compile);
+    parser->position++;
+    return result;
+  }
+  if (pos.is_list) {
+    parser->in_list = true;
+  } else {
+    parser->positional_count += 1;
+    if (!pos.optional)
+      parser->required_count += 1;
+  }
+  parser->parsing_optionals = pos.optional;
+  clags_custom_verify_func_t verify =
+      pos.value_type == Clags_Custom ? pos.verify : nullptr;
+  clags__lazy_value_t lazy = {.config = config,
+                              .variable = pos.variable,
+                              .value_type = pos.value_type,
+                              .arg_name = pos.arg_name,
+                              .name = pos.arg_name,
+                              .token = arg,
+                              .data = pos._data,
+                              .verify = verify,
+                              .is_list = pos.is_list,
+                              .index = position};
+  if (clags__parser_defer_value(parser, &lazy))
+    return nullptr;
+  if (!clags__set_arg(config, context, &parser->path_checks, position,
+                      pos.value_type, pos.arg_name, arg, pos.variable,
+                      pos._data, verify, pos.is_list)) {
+    clags__parser_describe(parser, position, pos.arg_name, arg, strlen(arg),
+                           pos.value_type);
+    return clags__parser_fail(parser);
+  }
+  return nullptr;
+}
+
+[[nodiscard]] static clags_config_t *clags__parser_end(clags_parser_t *parser) {
+  if (parser->failed != nullptr)
+    return parser->failed;
+  if (parser->finished)
+    return nullptr;
+  clags_config_t *config = parser->config;
+  clags_context_t *context = parser->context;
+  const clags_args_t *args = parser->args;
+
+  if (parser->pending != nullptr) {
+    clags__log(config, Clags_Error, "Option flag %s requires argument!",
+               parser->pending_name);
+    clags__set_error(config, context, Clags_Error_InvalidOption);
+    clags__parser_describe(parser, parser->pending_index,
+                           clags__option_name(parser->pending), nullptr, 0,
+                           parser->pending->value_type);
+    return clags__parser_fail(parser);
+  }
+  if (parser->in_list) {
+    parser->positional_count += 1;
+    if (!parser->parsing_optionals)
+      parser->required_count += 1;
+  }
+  clags_config_t *failed = clags__parser_apply_held_lists(parser);
+  if (failed != nullptr)
+    return failed;
+  if (parser->arguments_ignored)
+    clags__log(config, Clags_Warning,
+               "Arguments were ignored because they were prefixed with '%s'",
+               config->options.ignore_prefix);
 
   // report missing positional arguments
-  if (required_count < args.required_count) {
-    clags_sb_t sb = {0};
-    clags_sb_appendf(&sb,
-                     "Missing required arguments (%zu/%zu):", required_count,
-                     args.required_count);
-    for (size_t i = positional_count; i < args.required_count; ++i) {
-      clags_sb_appendf(&sb, " <%s>", args.positional[i].arg_name);
+  if (parser->required_count < args->required_count) {
+    if (clags__logs(config, Clags_Error)) {
+      clags_sb_t sb = {0};
+      clags_sb_appendf(&sb, "Missing required arguments (%zu/%zu):",
+                       parser->required_count, args->required_count);
+      for (size_t i = parser->positional_count; i < args->required_count;
+           ++i) {
+        clags_sb_appendf(&sb, " <%s>", args->positional[i].arg_name);
+      }
+      clags_sb_appendf(&sb, "!");
+      clags_log_sb(config, Clags_Error, &sb);
+      clags_sb_free(&sb);
     }
-    clags_sb_appendf(&sb, "!");
-    clags_log_sb(config, Clags_Error, &sb);
-    clags_sb_free(&sb);
 
-    config->error = Clags_Error_TooFewArguments;
-    clags_return_defer(config);
+    clags__set_error(config, context, Clags_Error_TooFewArguments);
+    const char *missing =
+        parser->positional_count < args->positional_count
+            ? args->positional[parser->positional_count].arg_name
+            : nullptr;
+    clags__parser_describe(parser, 0, missing, nullptr, 0, Clags_String);
+    return clags__parser_fail(parser);
+  }
+  return clags__parser_finish(parser);
+}
+
+// parse a whole argument vector, which allows presizing lists, above the
+// config file layer of `file_entries` if given
+[[nodiscard]] static clags_config_t *
+clags__parse_internal(size_t argc, char **argv, clags_config_t *config,
+                      clags_context_t *context,
+                      const clags_list_t *file_entries) {
+  clags_parser_t parser = {.context = context,
+                           .argv = argv,
+                           .argc = argc,
+                           .file_entries = file_entries};
+  clags__stats_add(parses, 1);
+  clags_config_t *result = clags__parser_enter(&parser, config, argv[0], false);
+  parser.position = 1;
+  for (size_t i = 1; i < argc && result == nullptr && !parser.finished; ++i) {
+    result = clags__parser_feed(&parser, argv[i]);
+  }
+  if (result == nullptr)
+    result = clags__parser_end(&parser);
+  return result;
+}
+
+[[nodiscard]] clags_config_t *clags_parser_begin(clags_parser_t *parser,
+                                                 const char *program_name,
+                                                 clags_config_t *config,
+                                                 clags_context_t *context) {
+  *parser = (clags_parser_t){.context = context};
+  if (context != nullptr) {
+    context->config = nullptr;
+    context->name = nullptr;
+  }
+  clags_context_t *previous_context = clags__active_context;
+  clags__active_context = context;
+  clags__stats_add(parses, 1);
+  clags_config_t *result =
+      clags__parser_enter(parser, config, program_name, false);
+  parser->position = 1;
+  clags__active_context = previous_context;
+  return result;
+}
+
+[[nodiscard]] clags_config_t *clags_parser_feed(clags_parser_t *parser,
+                                                const char *token) {
+  clags_context_t *previous_context = clags__active_context;
+  clags__active_context = parser->context;
+  clags_config_t *result = clags__parser_feed(parser, token);
+  clags__active_context = previous_context;
+  return result;
+}
+
+[[nodiscard]] clags_config_t *clags_parser_end(clags_parser_t *parser) {
+  clags_context_t *previous_context = clags__active_context;
+  clags__active_context = parser->context;
+  clags_config_t *result = clags__parser_end(parser);
+  clags__active_context = previous_context;
+  return result;
+}
+
+// a response or config file mapping, see `clags_config_t.mappings`
+typedef struct {
+  void *address;
+  size_t size;
+} clags__mapping_t;
+
+static void clags__unmap_response_files(clags_list_t *mappings) {
+  for (size_t i = 0; i < mappings->count; ++i) {
+    clags__mapping_t *mapping = &((clags__mapping_t *)mappings->items)[i];
+    munmap(mapping->address, mapping->size);
+  }
+  CLAGS_FREE(mappings->items);
+  mappings->items = nullptr;
+  mappings->count = mappings->capacity = 0;
+}
+
+// map a response or config file, as named by `kind`, privately and writable,
+// one byte larger than the file, so that its last token can be terminated in
+// place
+[[nodiscard]] static char *clags__map_file(clags_config_t *config,
+                                           const char *path, const char *kind,
+                                           clags_list_t *mappings,
+                                           size_t *size) {
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    clags__log(config, Clags_Error, "Failed to open %s '%s': %s!", kind, path,
+               strerror(errno));
+    return nullptr;
+  }
+  char *result = nullptr;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    clags__log(config, Clags_Error, "%c%s '%s' is not a regular file!",
+               toupper((unsigned char)kind[0]), kind + 1, path);
+    clags_return_defer(nullptr);
+  }
+  size_t file_size = (size_t)st.st_size;
+  size_t map_size = 0;
+  clags_assert(!clags__checked_add_size(&map_size, file_size, (size_t)1),
+               "File size overflow!");
+
+  // reserve zeroed memory for the terminator, then map the file over it
+  char *data = mmap(nullptr, map_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (data == MAP_FAILED) {
+    clags__log(config, Clags_Error, "Failed to map %s '%s': %s!", kind, path,
+               strerror(errno));
+    clags_return_defer(nullptr);
+  }
+  if (file_size > 0 && mmap(data, file_size, PROT_READ | PROT_WRITE,
+                            MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    clags__log(config, Clags_Error, "Failed to map %s '%s': %s!", kind, path,
+               strerror(errno));
+    munmap(data, map_size);
+    clags_return_defer(nullptr);
   }
 
-  clags_return_defer(nullptr);
+  clags__mapping_t mapping = {.address = data, .size = map_size};
+  if (mappings->item_size == 0)
+    mappings->item_size = sizeof(mapping);
+  clags__list_push(mappings, &mapping);
+  *size = file_size;
+  clags_return_defer(data);
 
 defer:
-  // cleanup memory of sorted args
-  CLAGS_FREE(positional);
-  CLAGS_FREE(option);
-  CLAGS_FREE(flags);
+  close(fd);
+  return result;
+}
+
+[[nodiscard]] static bool clags__expand_response_file(clags_config_t *config,
+                                                      const char *path,
+                                                      size_t depth,
+                                                      clags_list_t *mappings,
+                                                      clags_list_t *expanded);
+
+// split a mapped response file into tokens in place: whitespace separates
+// tokens, single quotes are literal, and backslashes escape the next character
+// outside of them
+[[nodiscard]] static bool clags__tokenize_response_file(
+    clags_config_t *config, const char *path, char *data, size_t size,
+    size_t depth, clags_list_t *mappings, clags_list_t *expanded) {
+  char *read = data;
+  char *end = data + size;
+  while (true) {
+    while (read < end && isspace((unsigned char)*read))
+      read++;
+    if (read >= end)
+      return true;
+
+    // unquoted tokens only shrink, so they are rewritten in place
+    char *token = read;
+    char *write = read;
+    char quote = '\0';
+    while (read < end) {
+      char c = *read;
+      if (quote == '\0' && isspace((unsigned char)c))
+        break;
+      read++;
+      if (quote != '\0' && c == quote) {
+        quote = '\0';
+        continue;
+      }
+      if (quote == '\0' && (c == '"' || c == '\'')) {
+        quote = c;
+        continue;
+      }
+      if (c == '\\' && quote != '\'' && read < end)
+        c = *read++;
+      *write++ = c;
+    }
+    if (quote != '\0') {
+      clags__log(config, Clags_Error,
+                 "Unterminated quote in response file '%s'!", path);
+      return false;
+    }
+    // skip the separator before it is possibly overwritten by the terminator
+    if (read < end)
+      read++;
+    *write = '\0';
+
+    if (token[0] == '@' && token[1] != '\0') {
+      if (!clags__expand_response_file(config, token + 1, depth + 1, mappings,
+                                       expanded))
+        return false;
+    } else {
+      clags__list_push(expanded, &token);
+    }
+  }
+}
+
+[[nodiscard]] static bool clags__expand_response_file(clags_config_t *config,
+                                                      const char *path,
+                                                      size_t depth,
+                                                      clags_list_t *mappings,
+                                                      clags_list_t *expanded) {
+  if (depth > CLAGS_MAX_RESPONSE_DEPTH) {
+    clags__log(config, Clags_Error,
+               "Response files nested too deep: exceeded maximum depth of %zu "
+               "at '%s'!",
+               (size_t)CLAGS_MAX_RESPONSE_DEPTH, path);
+    return false;
+  }
+  size_t size = 0;
+  char *data = clags__map_file(config, path, "response file", mappings, &size);
+  if (data == nullptr)
+    return false;
+  return clags__tokenize_response_file(config, path, data, size, depth,
+                                       mappings, expanded);
+}
+
+// expand '@file' arguments in front of the first "--" into a heap allocated
+// argument vector; returns `argv` itself if there is nothing to expand and
+// nullptr on failure
+[[nodiscard]] static char **
+clags__expand_response_files(size_t *argc, char **argv, clags_config_t *config,
+                             clags_list_t *mappings) {
+  size_t first = 0;
+  for (size_t i = 1; i < *argc && argv[i] != nullptr; ++i) {
+    if (strcmp(argv[i], "--") == 0)
+      break;
+    if (argv[i][0] == '@' && argv[i][1] != '\0') {
+      first = i;
+      break;
+    }
+  }
+  if (first == 0)
+    return argv;
+
+  clags_list_t expanded = {.item_size = sizeof(char *)};
+  for (size_t i = 0; i < first; ++i) {
+    clags__list_push(&expanded, &argv[i]);
+  }
+  bool expanding = true;
+  for (size_t i = first; i < *argc; ++i) {
+    char *arg = argv[i];
+    if (arg != nullptr && strcmp(arg, "--") == 0)
+      expanding = false;
+    if (expanding && arg != nullptr && arg[0] == '@' && arg[1] != '\0') {
+      if (!clags__expand_response_file(config, arg + 1, 1, mappings,
+                                       &expanded)) {
+        CLAGS_FREE(expanded.items);
+        return nullptr;
+      }
+      continue;
+    }
+    clags__list_push(&expanded, &arg);
+  }
+  *argc = expanded.count;
+  return expanded.items;
+}
+
+// parse an argument vector, expanding response files, above the config file
+// layer of `file_entries` if given
+[[nodiscard]] static clags_config_t *
+clags__parse_layers(int argc, char **argv, clags_config_t *config,
+                    const clags_list_t *file_entries) {
+  if (argc <= 0 || config == nullptr || argv == nullptr) {
+    if (config != nullptr) {
+      clags__set_error(config, nullptr, Clags_Error_InvalidOption);
+    }
+    return config;
+  }
+  size_t count = (size_t)argc;
+  char **expanded = argv;
+  if (config->options.response_files) {
+    expanded = clags__expand_response_files(&count, argv, config,
+                                            &config->mappings);
+    if (expanded == nullptr) {
+      clags__set_error(config, nullptr, Clags_Error_InvalidResponseFile);
+      return config;
+    }
+  }
+  clags_config_t *result =
+      clags__parse_internal(count, expanded, config, nullptr, file_entries);
+  if (expanded != argv)
+    CLAGS_FREE(expanded);
   return result;
 }
 
 [[nodiscard]] clags_config_t *clags_parse(int argc, char **argv,
                                           clags_config_t *config) {
+  return clags__parse_layers(argc, argv, config, nullptr);
+}
+
+// trim the whitespace around a range in place, terminating the result
+[[nodiscard]] static char *clags__trim(char *begin, char *end) {
+  while (begin < end && isspace((unsigned char)*begin))
+    begin++;
+  while (end > begin && isspace((unsigned char)end[-1]))
+    end--;
+  *end = '\0';
+  return begin;
+}
+
+// whether a config file section names a subcommand path below `config`, the
+// names separated by dots; names may contain dots themselves
+[[nodiscard]] static bool clags__section_exists(const clags_config_t *config,
+                                                const char *section) {
+  for (size_t i = 0; i < config->args_count; ++i) {
+    const clags_arg_t *arg = &config->args[i];
+    if (arg->type != Clags_Positional || arg->pos.value_type != Clags_Subcmd ||
+        arg->pos.subcmds == nullptr)
+      continue;
+    const clags_subcmds_t *subcmds = arg->pos.subcmds;
+    for (size_t j = 0; j < subcmds->count; ++j) {
+      const clags_subcmd_t *subcmd = &subcmds->items[j];
+      size_t length = subcmd->name ? strlen(subcmd->name) : 0;
+      if (length == 0 || strncmp(section, subcmd->name, length) != 0)
+        continue;
+      if (section[length] == '\0')
+        return true;
+      if (section[length] == '.' && subcmd->config != nullptr &&
+          clags__section_exists(subcmd->config, section + length + 1))
+        return true;
+    }
+  }
+  return false;
+}
+
+// split a mapped config file into its `key = value` lines in place, the keys
+// below a `[remote.build]` header belonging to the subcommand of that path
+[[nodiscard]] static bool
+clags__tokenize_config_file(clags_config_t *config, const char *path,
+                            char *data, size_t size, clags_list_t *entries) {
+  const char *section = nullptr;
+  char *end = data + size;
+  size_t line = 0;
+  for (char *read = data; read < end;) {
+    line++;
+    char *line_end = memchr(read, '\n', (size_t)(end - read));
+    if (line_end == nullptr)
+      line_end = end;
+    char *text = clags__trim(read, line_end);
+    read = line_end < end ? line_end + 1 : end;
+    if (*text == '\0' || *text == '#' || *text == ';')
+      continue;
+
+    size_t length = strlen(text);
+    if (*text == '[') {
+      section = length > 2 && text[length - 1] == ']'
+                    ? clags__trim(text + 1, text + length - 1)
+                    : "";
+      if (*section == '\0') {
+        clags__log(config, Clags_Error,
+                   "Invalid section header in config file '%s' line %zu!", path,
+                   line);
+        return false;
+      }
+      if (!clags__section_exists(config, section)) {
+        clags__log(config, Clags_Error,
+                   "Unknown section '%s' in config file '%s' line %zu!",
+                   section, path, line);
+        return false;
+      }
+      continue;
+    }
+    char *assignment = strchr(text, '=');
+    if (assignment == nullptr) {
+      clags__log(config, Clags_Error,
+                 "Missing '=' in config file '%s' line %zu!", path, line);
+      return false;
+    }
+    char *key = clags__trim(text, assignment);
+    char *value = clags__trim(assignment + 1, text + length);
+    if (*key == '\0' || *value == '\0') {
+      clags__log(config, Clags_Error,
+                 "Missing %s in config file '%s' line %zu!",
+                 *key == '\0' ? "key" : "value", path, line);
+      return false;
+    }
+    // matching quotes around the value are removed, keeping its whitespace
+    length = strlen(value);
+    if (length >= 2 && (*value == '"' || *value == '\'') &&
+        value[length - 1] == *value) {
+      value[length - 1] = '\0';
+      value++;
+    }
+    clags__file_entry_t entry = {
+        .path = path, .section = section, .key = key, .value = value,
+        .line = line};
+    clags__list_push(entries, &entry);
+  }
+  return true;
+}
+
+// map a config file onto `mappings` and split it into `entries`
+[[nodiscard]] static bool clags__load_config_file(clags_config_t *config,
+                                                  const char *path,
+                                                  clags_list_t *mappings,
+                                                  clags_list_t *entries) {
+  *entries = (clags_list_t){.item_size = sizeof(clags__file_entry_t)};
+  size_t size = 0;
+  char *data = clags__map_file(config, path, "config file", mappings, &size);
+  if (data == nullptr)
+    return false;
+  if (!clags__tokenize_config_file(config, path, data, size, entries)) {
+    CLAGS_FREE(entries->items);
+    *entries = (clags_list_t){0};
+    return false;
+  }
+  return true;
+}
+
+[[nodiscard]] clags_config_t *clags_parse_file(const char *path,
+                                               clags_config_t *config) {
+  if (config == nullptr || path == nullptr) {
+    if (config != nullptr)
+      clags__set_error(config, nullptr, Clags_Error_InvalidConfigFile);
+    return config;
+  }
+  clags_list_t entries;
+  if (!clags__load_config_file(config, path, &config->mappings, &entries)) {
+    clags__set_error(config, nullptr, Clags_Error_InvalidConfigFile);
+    return config;
+  }
+  clags_parser_t parser = {.file_entries = &entries, .file_only = true};
+  clags_config_t *result = clags__parser_enter(&parser, config, path, false);
+  if (result == nullptr)
+    result = clags__parser_finish(&parser);
+  CLAGS_FREE(entries.items);
+  return result;
+}
+
+[[nodiscard]] clags_config_t *clags_parse_layered(const char *path, int argc,
+                                                  char **argv,
+                                                  clags_config_t *config) {
+  if (path == nullptr || argc <= 0 || config == nullptr || argv == nullptr)
+    return clags_parse(argc, argv, config);
+  clags_list_t entries;
+  if (!clags__load_config_file(config, path, &config->mappings, &entries)) {
+    clags__set_error(config, nullptr, Clags_Error_InvalidConfigFile);
+    return config;
+  }
+  clags_config_t *result = clags__parse_layers(argc, argv, config, &entries);
+  CLAGS_FREE(entries.items);
+  return result;
+}
+
+[[nodiscard]] clags_config_t *clags_parse_context(int argc, char **argv,
+                                                  clags_config_t *config,
+                                                  clags_context_t *context) {
+  if (context == nullptr)
+    return clags_parse(argc, argv, config);
+  context->config = nullptr;
+  context->name = nullptr;
   if (argc <= 0 || config == nullptr || argv == nullptr) {
-    if (config != nullptr) {
-      config->error = Clags_Error_InvalidOption;
+    clags__set_error(config, context, Clags_Error_InvalidOption);
+    return config;
+  }
+  size_t count = (size_t)argc;
+  char **expanded = argv;
+  if (config->options.response_files) {
+    expanded = clags__expand_response_files(&count, argv, config,
+                                            &context->mappings);
+    if (expanded == nullptr) {
+      clags__set_error(config, context, Clags_Error_InvalidResponseFile);
+      return config;
+    }
+  }
+  clags_context_t *previous_context = clags__active_context;
+  clags__active_context = context;
+  clags_config_t *result =
+      clags__parse_internal(count, expanded, config, context, nullptr);
+  clags__active_context = previous_context;
+  if (expanded != argv)
+    CLAGS_FREE(expanded);
+  return result;
+}
+
+// compile the subcommand configs below a compiled config that are not yet,
+// as if selected by a parse, so that batch parses share their tables; false
+// if one of them is invalid
+[[nodiscard]] static bool clags__compile_subcmds(clags_config_t *config,
+                                                 size_t depth) {
+  clags_subcmds_t *subcmds = clags__args_subcmds(config->compiled);
+  if (subcmds == nullptr || depth >= CLAGS_MAX_PARSE_DEPTH)
+    return true;
+  for (size_t i = 0; i < subcmds->count; ++i) {
+    clags_config_t *child = subcmds->items[i].config;
+    if (child == nullptr || child->args == nullptr)
+      continue;
+    if (child->invalid)
+      return false;
+    if (child->compiled != nullptr)
+      continue;
+    if (!clags__compile(child))
+      return false;
+    child->compiled_lazily = true;
+    if (!clags__compile_subcmds(child, depth + 1))
+      return false;
+  }
+  return true;
+}
+
+// a share of the batch, every `stride`-th vector from `first` on
+typedef struct {
+  clags_config_t *config;
+  const clags_argv_t *vectors;
+  clags_context_t *results;
+  size_t count;
+  size_t first;
+  size_t stride;
+  size_t failed;
+} clags__batch_worker_t;
+
+static int clags__batch_worker(void *data) {
+  clags__batch_worker_t *worker = data;
+  for (size_t i = worker->first; i < worker->count; i += worker->stride) {
+    const clags_argv_t *vector = &worker->vectors[i];
+    if (clags_parse_context(vector->argc, vector->argv, worker->config,
+                            &worker->results[i]) != nullptr)
+      worker->failed++;
+  }
+  return 0;
+}
+
+[[nodiscard]] size_t clags_parse_batch(clags_config_t *config,
+                                       const clags_argv_t *vectors,
+                                       size_t count,
+                                       clags_context_t *results) {
+  if (count == 0 || results == nullptr)
+    return 0;
+  if (config == nullptr || vectors == nullptr) {
+    for (size_t i = 0; i < count; ++i) {
+      results[i].config = nullptr;
+      results[i].name = nullptr;
+      clags__set_error(config, &results[i], Clags_Error_InvalidOption);
+    }
+    return count;
+  }
+  // an invalid config, or subcommand config, fails every vector
+  bool compiled = false;
+  bool valid = config->args != nullptr && !config->invalid;
+  if (valid && config->compiled == nullptr)
+    valid = compiled = clags__compile(config);
+  if (valid)
+    valid = clags__compile_subcmds(config, 1);
+  if (!valid) {
+    if (compiled)
+      clags_config_free_compiled(config);
+    for (size_t i = 0; i < count; ++i) {
+      results[i].config = nullptr;
+      results[i].name = nullptr;
+      clags__set_error(config, &results[i], Clags_Error_InvalidConfig);
+    }
+    return count;
+  }
+
+  // shared variables are written in vector order, on this thread only
+  size_t stride = count / CLAGS_BATCH_SIZE;
+  if (stride > CLAGS_BATCH_THREADS)
+    stride = CLAGS_BATCH_THREADS;
+  for (size_t i = 0; i < count && stride > 1; ++i) {
+    if (results[i].variables == nullptr)
+      stride = 1;
+  }
+  if (stride == 0)
+    stride = 1;
+  clags__batch_worker_t workers[CLAGS_BATCH_THREADS];
+  for (size_t i = 0; i < stride; ++i) {
+    workers[i] = (clags__batch_worker_t){.config = config,
+                                         .vectors = vectors,
+                                         .results = results,
+                                         .count = count,
+                                         .first = i,
+                                         .stride = stride};
+  }
+#ifndef __STDC_NO_THREADS__
+  // shares whose thread fails to start are parsed on this thread instead
+  thrd_t threads[CLAGS_BATCH_THREADS];
+  bool started[CLAGS_BATCH_THREADS] = {0};
+  for (size_t i = 1; i < stride; ++i) {
+    started[i] = thrd_create(&threads[i], clags__batch_worker,
+                             &workers[i]) == thrd_success;
+  }
+  clags__batch_worker(&workers[0]);
+  for (size_t i = 1; i < stride; ++i) {
+    if (started[i])
+      thrd_join(threads[i], nullptr);
+    else
+      clags__batch_worker(&workers[i]);
+  }
+#else
+  for (size_t i = 0; i < stride; ++i) {
+    clags__batch_worker(&workers[i]);
+  }
+#endif // __STDC_NO_THREADS__
+
+  size_t failed = 0;
+  for (size_t i = 0; i < stride; ++i) {
+    failed += workers[i].failed;
+  }
+  if (compiled)
+    clags_config_free_compiled(config);
+  return failed;
+}
+
+// set the error of a recorded value that failed to convert
+static void clags__describe_lazy(const clags__lazy_value_t *value,
+                                 clags_context_t *context) {
+  clags__set_error(value->config, context, Clags_Error_InvalidValue);
+  clags_error_record_t *record = clags__error_record(value->config, context);
+  record->index = value->index;
+  record->arg_name = value->name;
+  record->token = value->token;
+  record->token_length = strlen(value->token);
+  record->expected = value->value_type;
+}
+
+// convert a recorded value on its first access and memoize the result
+[[nodiscard]] static bool clags__convert_lazy(clags__lazy_value_t *value,
+                                              clags_context_t *context) {
+  if (!value->converted) {
+    value->converted = true;
+    value->failed = !clags__set_arg(
+        value->config, context, nullptr, value->index, value->value_type,
+        value->arg_name, value->token, value->variable, value->data,
+        value->verify, value->is_list);
+  }
+  if (value->failed)
+    clags__describe_lazy(value, context);
+  return !value->failed;
+}
+
+// convert the recorded values of one variable, in argument order
+[[nodiscard]] static bool clags__get(clags_list_t *values,
+                                     clags_context_t *context,
+                                     void *variable) {
+  if (variable == nullptr)
+    return true;
+  clags_context_t *previous_context = clags__active_context;
+  clags__active_context = context;
+  clags__lazy_value_t *items = values->items;
+  bool result = true;
+  for (size_t i = 0; i < values->count && result; ++i) {
+    if (clags__variable(context, items[i].variable) == variable)
+      result = clags__convert_lazy(&items[i], context);
+  }
+  clags__active_context = previous_context;
+  return result;
+}
+
+// convert all recorded values, in argument order
+[[nodiscard]] static clags_config_t *
+clags__validate_all(clags_list_t *values, clags_context_t *context) {
+  clags_context_t *previous_context = clags__active_context;
+  clags__active_context = context;
+  clags__lazy_value_t *items = values->items;
+  clags_config_t *failed = nullptr;
+  for (size_t i = 0; i < values->count && failed == nullptr; ++i) {
+    if (!clags__convert_lazy(&items[i], context))
+      failed = items[i].config;
+  }
+  clags__active_context = previous_context;
+  return failed;
+}
+
+[[nodiscard]] bool clags_get(clags_config_t *config, void *variable) {
+  if (config == nullptr)
+    return false;
+  return clags__get(&config->lazy_values, nullptr, variable);
+}
+
+[[nodiscard]] bool clags_get_context(clags_context_t *context,
+                                     void *variable) {
+  if (context == nullptr)
+    return false;
+  return clags__get(&context->lazy_values, context, variable);
+}
+
+[[nodiscard]] clags_config_t *clags_validate_all(clags_config_t *config) {
+  if (config == nullptr)
+    return nullptr;
+  return clags__validate_all(&config->lazy_values, nullptr);
+}
+
+[[nodiscard]] clags_config_t *
+clags_validate_all_context(clags_context_t *context) {
+  if (context == nullptr)
+    return nullptr;
+  return clags__validate_all(&context->lazy_values, context);
+}
+
+void clags_context_free(clags_context_t *context, clags_config_t *config) {
+  if (context == nullptr)
+    return;
+  if (config != nullptr) {
+    for (size_t i = 0; i < config->args_count; ++i) {
+      clags_arg_t arg = config->args[i];
+      if (arg.type == Clags_Positional && arg.pos.is_list) {
+        clags_list_free(clags__variable(context, arg.pos.variable));
+      } else if (arg.type == Clags_Option && arg.opt.is_list) {
+        clags_list_free(clags__variable(context, arg.opt.variable));
+      }
     }
+  }
+  clags_list_t *allocs = &context->allocs;
+  for (size_t i = 0; i < allocs->count; ++i) {
+    CLAGS_FREE(((char **)allocs->items)[i]);
+  }
+  CLAGS_FREE(allocs->items);
+  allocs->items = nullptr;
+  allocs->count = allocs->capacity = 0;
+  clags__intern_free(&context->interned);
+  clags__unmap_response_files(&context->mappings);
+  CLAGS_FREE(context->lazy_values.items);
+  context->lazy_values = (clags_list_t){0};
+  context->config = nullptr;
+  context->name = nullptr;
+}
+
+[[nodiscard]] clags_config_t *clags_parse_compiled(int argc, char **argv,
+                                                   clags_config_t *config) {
+  if (config != nullptr && config->compiled == nullptr) {
+    clags__log(config, Clags_ConfigError,
+               "config must be compiled with `clags_compile` before using "
+               "`clags_parse_compiled`!");
+    clags__set_error(config, nullptr, Clags_Error_InvalidConfig);
     return config;
   }
-  return clags__parse_internal((size_t)argc, argv, config, 1);
+  return clags_parse(argc, argv, config);
+}
+
+[[nodiscard]] bool clags_compile(clags_config_t *config) {
+  if (config == nullptr || config->args == nullptr)
+    return false;
+  clags_config_free_compiled(config);
+  config->compiled_lazily = false;
+  if (!clags__compile(config))
+    return false;
+  config->invalid = false;
+  clags__set_error(config, nullptr, Clags_Error_Ok);
+  return true;
+}
+
+void clags_config_free_compiled(clags_config_t *config) {
+  if (config == nullptr || config->compiled == nullptr)
+    return;
+  clags_args_t *compiled = config->compiled;
+  config->compiled = nullptr;
+  // the subcommand configs compiled on selection go along with their parent
+  clags_subcmds_t *subcmds = clags__args_subcmds(compiled);
+  for (size_t i = 0; subcmds != nullptr && i < subcmds->count; ++i) {
+    clags_config_t *child = subcmds->items[i].config;
+    if (child != nullptr && child->compiled_lazily) {
+      child->compiled_lazily = false;
+      clags_config_free_compiled(child);
+    }
+  }
+  clags__free_args(compiled);
+  CLAGS_FREE(compiled);
+}
+
+// FNV-1a step over a value, and over a string including its terminator
+[[nodiscard]] static inline uint64_t clags__fingerprint_step(uint64_t hash,
+                                                             uint64_t value) {
+  return (hash ^ value) * 0x0000'0100'0000'01B3ULL;
+}
+
+[[nodiscard]] static uint64_t clags__fingerprint_string(uint64_t hash,
+                                                        const char *value) {
+  if (value == nullptr)
+    return clags__fingerprint_step(hash, UINT64_MAX);
+  for (const char *c = value; *c != '\0'; ++c)
+    hash = clags__fingerprint_step(hash, (unsigned char)*c);
+  return clags__fingerprint_step(hash, 0);
+}
+
+// hash everything the lookup tables are derived from
+[[nodiscard]] static uint64_t
+clags__config_fingerprint(const clags_config_t *config) {
+  uint64_t hash = 0xCBF2'9CE4'8422'2325ULL;
+  hash = clags__fingerprint_step(hash, config->args_count);
+  for (size_t i = 0; i < config->args_count; ++i) {
+    const clags_arg_t *arg = &config->args[i];
+    hash = clags__fingerprint_step(hash, arg->type);
+    switch (arg->type) {
+    case Clags_Positional: {
+      hash = clags__fingerprint_step(hash, arg->pos.value_type);
+      hash = clags__fingerprint_step(hash, arg->pos.is_list);
+      hash = clags__fingerprint_step(hash, arg->pos.optional);
+      const clags_subcmds_t *subcmds = arg->pos.subcmds;
+      if (arg->pos.value_type != Clags_Subcmd || subcmds == nullptr)
+        break;
+      hash = clags__fingerprint_step(hash, subcmds->count);
+      for (size_t j = 0; j < subcmds->count; ++j)
+        hash = clags__fingerprint_string(hash, subcmds->items[j].name);
+    } break;
+    case Clags_Option: {
+      hash = clags__fingerprint_step(hash, (unsigned char)arg->opt.short_flag);
+      hash = clags__fingerprint_string(hash, arg->opt.long_flag);
+      hash = clags__fingerprint_step(hash, arg->opt.value_type);
+      hash = clags__fingerprint_step(hash, arg->opt.is_list);
+      hash = clags__fingerprint_string(hash, arg->opt.env);
+    } break;
+    case Clags_Flag: {
+      hash = clags__fingerprint_step(hash, (unsigned char)arg->flag.short_flag);
+      hash = clags__fingerprint_string(hash, arg->flag.long_flag);
+    } break;
+    default: {
+      clags_unreachable("Invalid clags_arg_type_t");
+    }
+    }
+  }
+  return hash;
+}
+
+// write a string as a C string literal
+static void clags__write_string_literal(FILE *out, const char *value) {
+  fputc('"', out);
+  for (const unsigned char *c = (const unsigned char *)value; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\')
+      fprintf(out, "\\%c", *c);
+    else if (*c < 0x20 || *c >= 0x7F)
+      fprintf(out, "\\%03o", *c);
+    else
+      fputc(*c, out);
+  }
+  fputc('"', out);
+}
+
+// validate a config and the subcommand configs below it, as deep as a parse
+// can descend
+[[nodiscard]] static bool clags__validate_tree(clags_config_t *config,
+                                               size_t depth) {
+  clags_args_t args = {0};
+  if (!clags__build_args(&args, config, nullptr))
+    return false;
+  clags_subcmds_t *subcmds = clags__args_subcmds(&args);
+  clags__free_args(&args);
+  if (subcmds == nullptr || depth + 1 >= CLAGS_MAX_PARSE_DEPTH)
+    return true;
+  for (size_t i = 0; i < subcmds->count; ++i) {
+    clags_config_t *child = subcmds->items[i].config;
+    if (child != nullptr && child->args != nullptr &&
+        !clags__validate_tree(child, depth + 1))
+      return false;
+  }
+  return true;
+}
+
+// write the tables of a validated config, preceded by the tables of its
+// subcommand configs, named after it with the subcommand index appended
+static void clags__write_config_tables(FILE *out, const char *name,
+                                       clags_config_t *config, size_t depth) {
+  clags_args_t args = {0};
+  bool valid = clags__build_args(&args, config, nullptr);
+  clags_assert(valid, "The config changed during its validation!");
+  clags__index_subcmds(&args);
+
+  clags_subcmds_t *subcmds = clags__args_subcmds(&args);
+  if (depth + 1 >= CLAGS_MAX_PARSE_DEPTH)
+    subcmds = nullptr;
+  bool linked = false;
+  for (size_t i = 0; subcmds != nullptr && i < subcmds->count; ++i) {
+    clags_config_t *child = subcmds->items[i].config;
+    if (child == nullptr || child->args == nullptr)
+      continue;
+    clags_sb_t child_name = {0};
+    clags_sb_appendf(&child_name, "%s_%zu", name, i);
+    clags_sb_append_null(&child_name);
+    clags__write_config_tables(out, child_name.items, child, depth + 1);
+    clags_sb_free(&child_name);
+    linked = true;
+  }
+
+  fprintf(out, "static const clags_tables_t %s = {\n", name);
+  fprintf(out, "    .fingerprint = 0x%016" PRIX64 "ULL,\n",
+          clags__config_fingerprint(config));
+  fprintf(out, "    .args_count = %zu,\n", config->args_count);
+  if (args.long_count > 0) {
+    fprintf(out, "    .longs = (const clags_long_entry_t[]){\n");
+    for (size_t i = 0; i < args.long_count; ++i) {
+      fprintf(out, "        {");
+      clags__write_string_literal(out, args.longs[i].name);
+      fprintf(out, ", %zu, %zu},\n", args.longs[i].length,
+              args.longs[i].index);
+    }
+    fprintf(out, "    },\n");
+  }
+  fprintf(out, "    .long_count = %zu,\n", args.long_count);
+
+  // slots are numbered from one in the order of the arguments
+  size_t short_count = 0;
+  unsigned char short_flags[256] = {0};
+  for (size_t c = 0; c < 256; ++c) {
+    size_t slot = args.short_slots[c];
+    if (slot == 0)
+      continue;
+    short_flags[slot - 1] = (unsigned char)c;
+    if (slot > short_count)
+      short_count = slot;
+  }
+  if (short_count > 0) {
+    fprintf(out, "    .short_flags = (const unsigned char[]){");
+    for (size_t i = 0; i < short_count; ++i)
+      fprintf(out, "%s%u", i == 0 ? "" : ", ", short_flags[i]);
+    fprintf(out, "},\n    .short_indices = (const size_t[]){");
+    for (size_t i = 0; i < short_count; ++i)
+      fprintf(out, "%s%zu", i == 0 ? "" : ", ", args.shorts[i + 1]);
+    fprintf(out, "},\n");
+  }
+  fprintf(out, "    .short_count = %zu,\n", short_count);
+
+  if (args.subcmd_slots != nullptr) {
+    fprintf(out, "    .subcmd_slots = (const size_t[]){");
+    for (size_t i = 0; i < args.subcmd_capacity; ++i)
+      fprintf(out, "%s%zu", i == 0 ? "" : ", ", args.subcmd_slots[i]);
+    fprintf(out, "},\n");
+  }
+  fprintf(out, "    .subcmd_capacity = %zu,\n", args.subcmd_capacity);
+  if (linked) {
+    fprintf(out, "    .subcmd_tables = (const clags_tables_t *const[]){");
+    for (size_t i = 0; i < subcmds->count; ++i) {
+      clags_config_t *child = subcmds->items[i].config;
+      fprintf(out, "%s", i == 0 ? "" : ", ");
+      if (child == nullptr || child->args == nullptr)
+        fprintf(out, "nullptr");
+      else
+        fprintf(out, "&%s_%zu", name, i);
+    }
+    fprintf(out, "},\n");
+  }
+  fprintf(out, "};\n");
+  clags__free_args(&args);
+}
+
+[[nodiscard]] bool clags_write_tables(FILE *out, const char *name,
+                                      clags_config_t *config) {
+  if (out == nullptr || name == nullptr || config == nullptr ||
+      config->args == nullptr)
+    return false;
+  // the whole tree is validated before anything is written
+  if (!clags__validate_tree(config, 0)) {
+    clags__set_error(config, nullptr, Clags_Error_InvalidConfig);
+    return false;
+  }
+  fprintf(out, "// generated by `clags_write_tables`, do not edit\n");
+  clags__write_config_tables(out, name, config, 0);
+  return ferror(out) == 0;
+}
+
+[[nodiscard]] bool clags_compile_tables(clags_config_t *config,
+                                        const clags_tables_t *tables) {
+  if (config == nullptr || config->args == nullptr || tables == nullptr)
+    return false;
+  clags_config_free_compiled(config);
+  config->compiled_lazily = false;
+  if (tables->args_count != config->args_count ||
+      tables->fingerprint != clags__config_fingerprint(config)) {
+    clags__log(config, Clags_ConfigError,
+               "generated tables do not match the config! Regenerate them "
+               "with `clags_write_tables`.");
+    clags__set_error(config, nullptr, Clags_Error_InvalidConfig);
+    return false;
+  }
+
+  clags_args_t *compiled = clags__calloc(1, sizeof(*compiled));
+  clags_assert(compiled != nullptr, "Out of memory!");
+  clags__alloc_args(compiled, config->args_count);
+  clags__sort_args(compiled, config);
+  if (tables->long_count > 0)
+    memcpy(compiled->longs, tables->longs,
+           tables->long_count * sizeof(*tables->longs));
+  compiled->long_count = tables->long_count;
+  for (size_t i = 0; i < tables->short_count; ++i) {
+    compiled->short_slots[tables->short_flags[i]] = (uint8_t)(i + 1);
+    compiled->shorts[i + 1] = tables->short_indices[i];
+  }
+  if (tables->subcmd_capacity > 0) {
+    compiled->subcmd_slots =
+        clags__calloc(tables->subcmd_capacity, sizeof(*compiled->subcmd_slots));
+    clags_assert(compiled->subcmd_slots != nullptr, "Out of memory!");
+    memcpy(compiled->subcmd_slots, tables->subcmd_slots,
+           tables->subcmd_capacity * sizeof(*tables->subcmd_slots));
+    compiled->subcmd_capacity = tables->subcmd_capacity;
+  }
+  if (!clags__index_env(compiled, config)) {
+    clags__free_args(compiled);
+    CLAGS_FREE(compiled);
+    clags__set_error(config, nullptr, Clags_Error_InvalidConfig);
+    return false;
+  }
+  config->invalid = false;
+  clags__set_error(config, nullptr, Clags_Error_Ok);
+  config->compiled = compiled;
+
+  // the subcommand tables go along with their parent, like lazily compiled
+  // ones, subcommands without tables are still compiled on their selection
+  clags_subcmds_t *subcmds = clags__args_subcmds(compiled);
+  for (size_t i = 0; tables->subcmd_tables != nullptr && subcmds != nullptr &&
+                     i < subcmds->count;
+       ++i) {
+    clags_config_t *child = subcmds->items[i].config;
+    const clags_tables_t *child_tables = tables->subcmd_tables[i];
+    if (child == nullptr || child->args == nullptr || child_tables == nullptr)
+      continue;
+    if (!clags_compile_tables(child, child_tables)) {
+      clags_config_free_compiled(config);
+      clags__set_error(config, nullptr, Clags_Error_InvalidConfig);
+      return false;
+    }
+    child->compiled_lazily = true;
+  }
+  return true;
 }
 
 static void clags__format_lhs(char *buffer, size_t buf_size, char short_flag,
@@ -1637,170 +4579,276 @@ static void clags__format_lhs(char *buffer, size_t buf_size, char short_flag,
     snprintf(buffer, buf_size, "%s%s", prefix, arg_name ? arg_name : "");
   }
 
-  if (lines_cut_off)
-    *lines_cut_off = true;
-}
-
-void clags_usage(const char *program_name, clags_config_t *config) {
-  if (!config || !config->args || config->invalid)
-    return;
-
-  clags_positional_t *positional =
-      CLAGS_CALLOC(config->args_count, sizeof(*positional));
-  clags_option_t *option = CLAGS_CALLOC(config->args_count, sizeof(*option));
-  clags_flag_t *flags = CLAGS_CALLOC(config->args_count, sizeof(*flags));
-  clags_assert(positional && option && flags, "Out of memory!");
-
-  clags_args_t args = {
-      .positional = positional, .option = option, .flags = flags};
-  clags__sort_args(&args, config);
+  if (lines_cut_off)
+    *lines_cut_off = true;
+}
 
-  char *temp_buffer =
-      CLAGS_CALLOC(CLAGS__USAGE_TEMP_BUFFER_SIZE, sizeof(*temp_buffer));
-  clags_assert(temp_buffer, "Out of memory!");
+static void clags__render_usage(const char *program_name,
+                                clags_config_t *config, clags_sb_t *out) {
+  // walk the definitions once per kind, in the order of the sorted tables
+  size_t option_count = 0;
+  size_t flag_count = 0;
+  for (size_t i = 0; i < config->args_count; ++i) {
+    option_count += config->args[i].type == Clags_Option;
+    flag_count += config->args[i].type == Clags_Flag;
+  }
+  size_t positional_count = config->args_count - option_count - flag_count;
 
+  char lhs[CLAGS__USAGE_TEMP_BUFFER_SIZE] = {0};
   bool lines_cut_off = false;
 
-  clags__subcommand_path_usage(program_name, config);
+  clags__subcommand_path_usage(out, program_name, config);
 
-  if (args.option_count)
-    printf(" [OPTIONS]");
-  if (args.flag_count)
-    printf(" [FLAGS]");
+  if (option_count)
+    clags__sb_append_cstr(out, " [OPTIONS]");
+  if (flag_count)
+    clags__sb_append_cstr(out, " [FLAGS]");
 
   bool last_was_list = false;
-  for (size_t i = 0; i < args.positional_count; ++i) {
+  for (size_t i = 0; i < config->args_count; ++i) {
+    if (config->args[i].type != Clags_Positional)
+      continue;
     if (last_was_list) {
       if (config->options.list_terminator) {
-        printf(" %s", config->options.list_terminator);
+        clags_sb_appendf(out, " %s", config->options.list_terminator);
       }
       last_was_list = false;
     }
-    clags_positional_t pos = args.positional[i];
+    clags_positional_t pos = config->args[i].pos;
     const char *pos_arg_name = pos.arg_name ? pos.arg_name : "(unnamed)";
-    printf(" ");
-    printf("%c", pos.optional ? '[' : '<');
-    if (pos.is_list) {
-      printf("%s..", pos_arg_name);
-      last_was_list = true;
-    } else {
-      printf("%s", pos_arg_name);
-    }
-    printf("%c", pos.optional ? ']' : '>');
+    clags_sb_appendf(out, " %c%s%s%c", pos.optional ? '[' : '<', pos_arg_name,
+                     pos.is_list ? ".." : "", pos.optional ? ']' : '>');
+    last_was_list = pos.is_list;
   }
-  printf("\n");
+  clags__sb_append(out, "\n", 1);
 
   if (config->options.description) {
     const char *line = config->options.description;
     while (line && *line) {
       const char *line_end = clags__strchrnull(line, '\n');
-      int len = (int)(line_end - line);
-      printf("%.*s\n", len, line);
+      clags__sb_append(out, line, (size_t)(line_end - line));
+      clags__sb_append(out, "\n", 1);
       if (*line_end == '\0')
         break;
       line = line_end + 1;
     }
-    printf("\n");
+    clags__sb_append(out, "\n", 1);
   }
 
-  if (args.positional_count) {
-    printf("  Arguments:\n");
-    for (size_t i = 0; i < args.positional_count; ++i) {
-      clags_positional_t pos = args.positional[i];
+  if (positional_count) {
+    clags__sb_append_cstr(out, "  Arguments:\n");
+    for (size_t i = 0; i < config->args_count; ++i) {
+      if (config->args[i].type != Clags_Positional)
+        continue;
+      clags_positional_t pos = config->args[i].pos;
       const char *pos_arg_name = pos.arg_name ? pos.arg_name : "(unnamed)";
       const char *pos_description = pos.description ? pos.description : "";
       const char *optional_hint = pos.optional ? " (optional)" : "";
-      printf("    %*s%s : %s", CLAGS__USAGE_PRINTF_ALIGNMENT, pos_arg_name,
-             optional_hint, pos_description);
-      clags__type_usage(pos.value_type, pos._data, pos.is_list);
+      clags_sb_appendf(out, "    %*s%s : %s", CLAGS__USAGE_PRINTF_ALIGNMENT,
+                       pos_arg_name, optional_hint, pos_description);
+      clags__type_usage(out, pos.value_type, pos._data, pos.is_list);
     }
   }
 
-  if (args.option_count) {
-    printf("  Options:\n");
-    for (size_t i = 0; i < args.option_count; ++i) {
-      clags_option_t opt = args.option[i];
+  if (option_count) {
+    clags__sb_append_cstr(out, "  Options:\n");
+    for (size_t i = 0; i < config->args_count; ++i) {
+      if (config->args[i].type != Clags_Option)
+        continue;
+      clags_option_t opt = config->args[i].opt;
       const char *opt_description = opt.description ? opt.description : "";
-      clags__format_lhs(temp_buffer, CLAGS__USAGE_TEMP_BUFFER_SIZE,
-                        opt.short_flag, opt.long_flag, opt.arg_name,
-                        &lines_cut_off);
-      printf("    %*s : %s", CLAGS__USAGE_PRINTF_ALIGNMENT, temp_buffer,
-             opt_description);
-      clags__type_usage(opt.value_type, opt._data, opt.is_list);
+      clags__format_lhs(lhs, sizeof(lhs), opt.short_flag, opt.long_flag,
+                        opt.arg_name, &lines_cut_off);
+      clags_sb_appendf(out, "    %*s : %s", CLAGS__USAGE_PRINTF_ALIGNMENT, lhs,
+                       opt_description);
+      if (opt.env != nullptr)
+        clags_sb_appendf(out, " [env: %s]", opt.env);
+      clags__type_usage(out, opt.value_type, opt._data, opt.is_list);
     }
   }
 
-  if (args.flag_count) {
-    printf("  Flags:\n");
-    for (size_t i = 0; i < args.flag_count; ++i) {
-      clags_flag_t flag = args.flags[i];
+  if (flag_count) {
+    clags__sb_append_cstr(out, "  Flags:\n");
+    for (size_t i = 0; i < config->args_count; ++i) {
+      if (config->args[i].type != Clags_Flag)
+        continue;
+      clags_flag_t flag = config->args[i].flag;
       const char *flag_description = flag.description ? flag.description : "";
-      clags__format_lhs(temp_buffer, CLAGS__USAGE_TEMP_BUFFER_SIZE,
-                        flag.short_flag, flag.long_flag, nullptr,
-                        &lines_cut_off);
-      printf("    %*s : %s%s\n", CLAGS__USAGE_PRINTF_ALIGNMENT, temp_buffer,
-             flag_description, flag.exit ? " and exit" : "");
+      clags__format_lhs(lhs, sizeof(lhs), flag.short_flag, flag.long_flag,
+                        nullptr, &lines_cut_off);
+      clags_sb_appendf(out, "    %*s : %s%s\n", CLAGS__USAGE_PRINTF_ALIGNMENT,
+                       lhs, flag_description, flag.exit ? " and exit" : "");
     }
   }
 
   if (!config->options.print_no_notes &&
       (config->options.list_terminator || config->options.ignore_prefix ||
        config->options.allow_option_parsing_toggle)) {
-    printf("\n  Notes:\n");
+    clags__sb_append_cstr(out, "\n  Notes:\n");
     if (config->options.allow_option_parsing_toggle) {
-      printf("    '--' toggles option and flag parsing and can re-enable "
-             "parsing when provided again.\n");
+      clags__sb_append_cstr(
+          out, "    '--' toggles option and flag parsing and can re-enable "
+               "parsing when provided again.\n");
     }
     if (config->options.list_terminator) {
-      printf("    '%s' terminates a list argument.\n",
-             config->options.list_terminator);
+      clags_sb_appendf(out, "    '%s' terminates a list argument.\n",
+                       config->options.list_terminator);
     }
     if (config->options.ignore_prefix) {
-      printf("    Arguments prefixed with '%s' are ignored.\n",
-             config->options.ignore_prefix);
+      clags_sb_appendf(out, "    Arguments prefixed with '%s' are ignored.\n",
+                       config->options.ignore_prefix);
     }
   }
 
   if (lines_cut_off) {
-    clags_log(config, Clags_ConfigWarning,
-              "Some flag names were too long and were cut off! Increase "
-              "`CLAGS_USAGE_ALIGNMENT` to give them more space.");
+    clags__log(config, Clags_ConfigWarning,
+               "Some flag names were too long and were cut off! Increase "
+               "`CLAGS_USAGE_ALIGNMENT` to give them more space.");
+  }
+}
+
+[[nodiscard]] static uint64_t
+clags__value_usage_key(uint64_t hash, clags_value_type_t type,
+                       const void *data) {
+  if (data == nullptr)
+    return hash;
+  if (type == Clags_Choice) {
+    const clags_choices_t *choices = data;
+    hash = clags__fingerprint_step(hash, choices->count);
+    hash = clags__fingerprint_step(hash, choices->print_no_details);
+    hash = clags__fingerprint_step(hash, choices->case_insensitive);
+    for (size_t i = 0; i < choices->count; ++i) {
+      hash = clags__fingerprint_string(hash, choices->items[i].value);
+      hash = clags__fingerprint_string(hash, choices->items[i].description);
+    }
+  } else if (type == Clags_Subcmd) {
+    const clags_subcmds_t *subcmds = data;
+    for (size_t i = 0; i < subcmds->count; ++i)
+      hash = clags__fingerprint_string(hash, subcmds->items[i].description);
+  }
+  return hash;
+}
+
+// hash everything `clags__render_usage` prints on top of the fingerprint of
+// the tables, which leaves out names, descriptions and choices
+[[nodiscard]] static uint64_t clags__usage_key(const char *program_name,
+                                               const clags_config_t *config) {
+  uint64_t hash = clags__config_fingerprint(config);
+  hash = clags__fingerprint_step(hash, CLAGS_USAGE_ALIGNMENT);
+  hash = clags__fingerprint_string(hash, program_name);
+  for (const clags_config_t *c = config; c->parent != nullptr; c = c->parent)
+    hash = clags__fingerprint_string(hash, c->name);
+
+  const clags_options_t *options = &config->options;
+  hash = clags__fingerprint_string(hash, options->description);
+  hash = clags__fingerprint_string(hash, options->list_terminator);
+  hash = clags__fingerprint_string(hash, options->ignore_prefix);
+  hash = clags__fingerprint_step(hash, options->allow_option_parsing_toggle);
+  hash = clags__fingerprint_step(hash, options->print_no_notes);
+  for (size_t i = 0; i < config->args_count; ++i) {
+    const clags_arg_t *arg = &config->args[i];
+    switch (arg->type) {
+    case Clags_Positional: {
+      hash = clags__fingerprint_string(hash, arg->pos.arg_name);
+      hash = clags__fingerprint_string(hash, arg->pos.description);
+      hash = clags__value_usage_key(hash, arg->pos.value_type, arg->pos._data);
+    } break;
+    case Clags_Option: {
+      hash = clags__fingerprint_string(hash, arg->opt.arg_name);
+      hash = clags__fingerprint_string(hash, arg->opt.description);
+      hash = clags__value_usage_key(hash, arg->opt.value_type, arg->opt._data);
+    } break;
+    case Clags_Flag: {
+      hash = clags__fingerprint_string(hash, arg->flag.description);
+      hash = clags__fingerprint_step(hash, arg->flag.type);
+      hash = clags__fingerprint_step(hash, arg->flag.exit);
+    } break;
+    default: {
+      clags_unreachable("Invalid clags_arg_type_t");
+    }
+    }
+  }
+  return hash;
+}
+
+// the usage cached on the config, rendered again if it is outdated
+[[nodiscard]] static const clags_sb_t *
+clags__cached_usage(const char *program_name, clags_config_t *config) {
+  uint64_t key = clags__usage_key(program_name, config);
+  if (config->usage.count == 0 || config->usage_key != key) {
+    config->usage.count = 0;
+    clags__render_usage(program_name, config, &config->usage);
+    config->usage_key = key;
+  }
+  return &config->usage;
+}
+
+void clags_usage_sb(const char *program_name, clags_config_t *config,
+                    clags_sb_t *out) {
+  if (!config || !config->args || config->invalid || !out)
+    return;
+  if (!config->options.cache_usage) {
+    clags__render_usage(program_name, config, out);
+    return;
   }
+  const clags_sb_t *usage = clags__cached_usage(program_name, config);
+  clags__sb_append(out, usage->items, usage->count);
+}
 
-  CLAGS_FREE(positional);
-  CLAGS_FREE(option);
-  CLAGS_FREE(flags);
-  CLAGS_FREE(temp_buffer);
+void clags_usage(const char *program_name, clags_config_t *config) {
+  if (!config || !config->args || config->invalid)
+    return;
+  if (config->options.cache_usage) {
+    const clags_sb_t *usage = clags__cached_usage(program_name, config);
+    fwrite(usage->items, 1, usage->count, stdout);
+    return;
+  }
+  clags_sb_t sb = {0};
+  clags__render_usage(program_name, config, &sb);
+  if (sb.count > 0)
+    fwrite(sb.items, 1, sb.count, stdout);
+  clags_sb_free(&sb);
 }
 
 [[nodiscard]] int clags_subcmd_index(clags_subcmds_t *subcmds,
                                      clags_subcmd_t *subcmd) {
-  if (!subcmds || !subcmd)
+  if (!subcmds || !subcmd || !subcmds->items)
     return -1;
-  for (size_t i = 0; i < subcmds->count; ++i) {
-    if (&subcmds->items[i] == subcmd)
-      return (int)i;
-  }
-  return -1;
+  // compare addresses as integers, `subcmd` may point outside of the array
+  uintptr_t base = (uintptr_t)subcmds->items;
+  uintptr_t address = (uintptr_t)subcmd;
+  size_t offset = (size_t)(address - base);
+  if (address < base || offset / sizeof(*subcmd) >= subcmds->count ||
+      offset % sizeof(*subcmd) != 0)
+    return -1;
+  return (int)(offset / sizeof(*subcmd));
 }
 
 [[nodiscard]] int clags_choice_index(clags_choices_t *choices,
                                      clags_choice_t *choice) {
-  if (!choices || !choice)
+  if (!choices || !choice || !choices->items)
     return -1;
-  for (size_t i = 0; i < choices->count; ++i) {
-    if (&choices->items[i] == choice)
-      return (int)i;
-  }
-  return -1;
+  // compare addresses as integers, `choice` may point outside of the array
+  uintptr_t base = (uintptr_t)choices->items;
+  uintptr_t address = (uintptr_t)choice;
+  size_t offset = (size_t)(address - base);
+  if (address < base || offset / sizeof(*choice) >= choices->count ||
+      offset % sizeof(*choice) != 0)
+    return -1;
+  return (int)(offset / sizeof(*choice));
 }
 
 void clags_list_free(clags_list_t *list) {
   if (list == nullptr)
     return;
-  CLAGS_FREE(list->items);
+  list->count = list->streamed = 0;
+  if (list->fixed)
+    return;
+  if (list->arena == nullptr)
+    CLAGS_FREE(list->items);
   list->items = nullptr;
-  list->count = list->capacity = 0;
+  list->arena = nullptr;
+  list->capacity = 0;
 }
 
 void clags_config_free_allocs(clags_config_t *config) {
@@ -1813,6 +4861,7 @@ void clags_config_free_allocs(clags_config_t *config) {
   CLAGS_FREE(allocs->items);
   allocs->items = nullptr;
   allocs->count = allocs->capacity = 0;
+  clags__intern_free(&config->interned);
   if (config->options.duplicate_strings) {
     config->name = nullptr;
   }
@@ -1830,6 +4879,11 @@ void clags_config_free(clags_config_t *config) {
     }
   }
   clags_config_free_allocs(config);
+  clags__unmap_response_files(&config->mappings);
+  clags_sb_free(&config->usage);
+  config->usage_key = 0;
+  CLAGS_FREE(config->lazy_values.items);
+  config->lazy_values = (clags_list_t){0};
 }
 
 [[nodiscard]] const char *clags_error_description(clags_error_t error) {
@@ -1842,3 +4896,858 @@ void clags_config_free(clags_config_t *config) {
         default : return "unknown error";
   }
 }
+
+void clags_error_message(const clags_error_record_t *record, clags_sb_t *out) {
+  if (record == nullptr || out == nullptr)
+    return;
+  clags__sb_append_cstr(out, clags_error_description(record->error));
+  if (record->token != nullptr)
+    clags_sb_appendf(out, ": '%.*s'", (int)record->token_length,
+                     record->token);
+  if (record->arg_name != nullptr)
+    clags_sb_appendf(out, " for '%s'", record->arg_name);
+  if (record->error == Clags_Error_InvalidValue &&
+      clags__is_valid_value_type(record->expected))
+    clags_sb_appendf(out, ", expected %s",
+                     clags__type_names[record->expected]);
+  if (record->index > 0)
+    clags_sb_appendf(out, " (argument %zu)", record->index);
+}
+
+// append a candidate made of `lead` and `value` if it starts with the token
+// under the cursor, followed by a tab and its description if it has one
+static void clags__complete_add(clags_sb_t *out, const char *cursor,
+                                const char *lead, size_t lead_length,
+                                const char *value, const char *description,
+                                bool fold_case) {
+  size_t cursor_length = strlen(cursor);
+  size_t common = cursor_length < lead_length ? cursor_length : lead_length;
+  if (memcmp(cursor, lead, common) != 0)
+    return;
+  const char *rest = cursor + common;
+  size_t rest_length = cursor_length - common;
+  if (fold_case ? strncasecmp(value, rest, rest_length) != 0
+                : strncmp(value, rest, rest_length) != 0)
+    return;
+  if (lead_length > 0)
+    clags__sb_append(out, lead, lead_length);
+  clags__sb_append_cstr(out, value);
+  if (description != nullptr && *description != '\0') {
+    clags__sb_append(out, "\t", 1);
+    clags__sb_append_cstr(out, description);
+  }
+  clags__sb_append(out, "\n", 1);
+}
+
+// append the values of a choice or subcommand argument as candidates
+static void clags__complete_values(clags_sb_t *out, const char *cursor,
+                                   const char *lead, size_t lead_length,
+                                   clags_value_type_t value_type, void *data) {
+  if (data == nullptr)
+    return;
+  if (value_type == Clags_Choice) {
+    const clags_choices_t *choices = data;
+    for (size_t i = 0; i < choices->count; ++i) {
+      clags__complete_add(out, cursor, lead, lead_length,
+                          choices->items[i].value,
+                          choices->items[i].description,
+                          choices->case_insensitive);
+    }
+  } else if (value_type == Clags_Subcmd) {
+    const clags_subcmds_t *subcmds = data;
+    for (size_t i = 0; i < subcmds->count; ++i) {
+      clags__complete_add(out, cursor, lead, lead_length,
+                          subcmds->items[i].name,
+                          subcmds->items[i].description, false);
+    }
+  }
+}
+
+// append the long and short flags of all options and flags as candidates
+static void clags__complete_flags(clags_sb_t *out, const char *cursor,
+                                  const clags_config_t *config,
+                                  const clags_args_t *args) {
+  for (size_t i = 0; i < args->long_count; ++i) {
+    const clags_arg_t *arg = &config->args[args->longs[i].index];
+    const char *description = arg->type == Clags_Option
+                                  ? arg->opt.description
+                                  : arg->flag.description;
+    clags__complete_add(out, cursor, "--", 2, args->longs[i].name, description,
+                        false);
+  }
+  for (size_t c = 1; c < 256; ++c) {
+    uint8_t slot = args->short_slots[c];
+    if (slot == 0)
+      continue;
+    const clags_arg_t *arg = &config->args[args->shorts[slot]];
+    const char *description = arg->type == Clags_Option
+                                  ? arg->opt.description
+                                  : arg->flag.description;
+    char name[2] = {(char)c, '\0'};
+    clags__complete_add(out, cursor, "-", 1, name, description, false);
+  }
+}
+
+// the tables of a config, its compiled ones or temporary ones built into
+// `local` without touching the config, nullptr if it is invalid
+[[nodiscard]] static const clags_args_t *
+clags__complete_tables(clags_config_t *config, clags_args_t *local) {
+  if (config->args == nullptr || config->invalid)
+    return nullptr;
+  if (config->compiled != nullptr)
+    return config->compiled;
+  clags_context_t scratch = {0};
+  if (!clags__build_args(local, config, &scratch))
+    return nullptr;
+  return local;
+}
+
+[[nodiscard]] bool clags_complete(int argc, char **argv,
+                                  clags_config_t *config, clags_sb_t *out) {
+  if (argc <= 0 || argv == nullptr || config == nullptr || out == nullptr)
+    return false;
+  size_t cursor_index = argc > 1 ? (size_t)argc - 1 : 1;
+  const char *cursor = argc > 1 ? argv[cursor_index] : "";
+  if (cursor == nullptr)
+    return false;
+
+  clags_args_t local = {0};
+  const clags_args_t *args = clags__complete_tables(config, &local);
+  if (args == nullptr)
+    return false;
+  const clags_option_t *pending = nullptr;
+  bool accept_options = true;
+  size_t positional = 0;
+  bool result = false;
+
+  // walk the tokens in front of the cursor, only following the subcommands
+  for (size_t i = 1; i < cursor_index; ++i) {
+    const char *token = argv[i];
+    if (token == nullptr)
+      clags_return_defer(false);
+    const char *ignore_prefix = config->options.ignore_prefix;
+    const char *list_term = config->options.list_terminator;
+    if (pending != nullptr) {
+      pending = nullptr;
+    } else if (strcmp(token, "--") == 0 &&
+               (accept_options ||
+                config->options.allow_option_parsing_toggle)) {
+      accept_options = !accept_options;
+    } else if (ignore_prefix != nullptr &&
+               strncmp(token, ignore_prefix, strlen(ignore_prefix)) == 0) {
+      continue;
+    } else if (list_term != nullptr && strcmp(token, list_term) == 0) {
+      if (positional < args->positional_count &&
+          args->positional[positional].is_list)
+        positional++;
+    } else if (accept_options && strncmp(token, "--", 2) == 0) {
+      const char *name = token + 2;
+      const char *assignment = clags__strchrnull(name, '=');
+      const clags_long_entry_t *entry =
+          clags__find_long_flag(args, name, (size_t)(assignment - name));
+      if (entry != nullptr && *assignment == '\0' &&
+          config->args[entry->index].type == Clags_Option)
+        pending = &config->args[entry->index].opt;
+    } else if (accept_options && token[0] == '-' && token[1] != '\0' &&
+               !isdigit((unsigned char)token[1])) {
+      for (const char *c = token + 1; *c != '\0'; ++c) {
+        uint8_t slot = args->short_slots[(unsigned char)*c];
+        if (slot == 0)
+          break;
+        const clags_arg_t *target = &config->args[args->shorts[slot]];
+        if (target->type == Clags_Option) {
+          if (c[1] == '\0')
+            pending = &target->opt;
+          break;
+        }
+      }
+    } else if (positional < args->positional_count) {
+      const clags_positional_t *pos = &args->positional[positional];
+      if (pos->value_type != Clags_Subcmd) {
+        if (!pos->is_list)
+          positional++;
+        continue;
+      }
+      clags_subcmd_t *subcmd = nullptr;
+      if (args->subcmd_slots != nullptr) {
+        subcmd = clags__find_subcmd(args, pos->subcmds, token);
+      } else {
+        for (size_t j = 0; j < pos->subcmds->count && subcmd == nullptr; ++j) {
+          if (strcmp(pos->subcmds->items[j].name, token) == 0)
+            subcmd = &pos->subcmds->items[j];
+        }
+      }
+      // nothing follows an unknown subcommand or one without arguments
+      if (subcmd == nullptr || subcmd->config == nullptr)
+        clags_return_defer(true);
+      clags__free_args(&local);
+      config = subcmd->config;
+      args = clags__complete_tables(config, &local);
+      if (args == nullptr)
+        clags_return_defer(false);
+      accept_options = true;
+      positional = 0;
+    }
+  }
+
+  if (pending != nullptr) {
+    clags__complete_values(out, cursor, "", 0, pending->value_type,
+                           pending->_data);
+  } else if (accept_options && strncmp(cursor, "--", 2) == 0 &&
+             strchr(cursor, '=') != nullptr) {
+    // complete the value of a designated assignment
+    const char *name = cursor + 2;
+    size_t length = (size_t)(strchr(name, '=') - name);
+    const clags_long_entry_t *entry = clags__find_long_flag(args, name, length);
+    if (entry != nullptr && config->args[entry->index].type == Clags_Option) {
+      const clags_option_t *opt = &config->args[entry->index].opt;
+      clags__complete_values(out, cursor, cursor, length + 3, opt->value_type,
+                             opt->_data);
+    }
+  } else if (accept_options && cursor[0] == '-') {
+    clags__complete_flags(out, cursor, config, args);
+  } else if (positional < args->positional_count) {
+    const clags_positional_t *pos = &args->positional[positional];
+    clags__complete_values(out, cursor, "", 0, pos->value_type, pos->_data);
+  }
+  clags_return_defer(true);
+
+defer:
+  clags__free_args(&local);
+  return result;
+}
+
+// the completion scripts, with `@NAME@` standing for the program name,
+// `@FUNC@` for it as an identifier, and `@COMPLETE@` for the hidden command
+static const char *const clags__completion_scripts[] = {
+    [Clags_Shell_Bash] =
+        "_clags_complete_@FUNC@() {\n"
+        "  local line=\"${COMP_LINE:0:COMP_POINT}\"\n"
+        "  local -a words\n"
+        "  read -ra words <<< \"$line\"\n"
+        "  [[ \"$line\" =~ [[:space:]]$ ]] && words+=(\"\")\n"
+        "  local word=\"${words[${#words[@]}-1]}\"\n"
+        "  local cur=\"${COMP_WORDS[COMP_CWORD]}\"\n"
+        "  local prefix=\"${word%\"$cur\"}\"\n"
+        "  local IFS=$'\\n' candidate\n"
+        "  COMPREPLY=()\n"
+        "  for candidate in $(\"${words[0]}\" @COMPLETE@ \"${words[@]:1}\" "
+        "2>/dev/null); do\n"
+        "    candidate=\"${candidate%%$'\\t'*}\"\n"
+        "    COMPREPLY+=(\"${candidate#\"$prefix\"}\")\n"
+        "  done\n"
+        "  if ((${#COMPREPLY[@]} == 0)); then\n"
+        "    COMPREPLY=($(compgen -f -- \"$cur\"))\n"
+        "  fi\n"
+        "}\n"
+        "complete -F _clags_complete_@FUNC@ @NAME@\n",
+    [Clags_Shell_Zsh] =
+        "#compdef @NAME@\n"
+        "_clags_complete_@FUNC@() {\n"
+        "  local IFS=$'\\n' candidate\n"
+        "  local -a candidates described\n"
+        "  candidates=($(\"${words[1]}\" @COMPLETE@ \"${(@)words[2,CURRENT]}\" "
+        "2>/dev/null))\n"
+        "  if (( ${#candidates} == 0 )); then\n"
+        "    _files\n"
+        "    return\n"
+        "  fi\n"
+        "  for candidate in \"${candidates[@]}\"; do\n"
+        "    if [[ \"$candidate\" == *$'\\t'* ]]; then\n"
+        "      described+=(\"${${candidate%%$'\\t'*}//:/\\\\:}:"
+        "${candidate#*$'\\t'}\")\n"
+        "    else\n"
+        "      described+=(\"${candidate//:/\\\\:}\")\n"
+        "    fi\n"
+        "  done\n"
+        "  _describe 'values' described\n"
+        "}\n"
+        "compdef _clags_complete_@FUNC@ @NAME@\n",
+    [Clags_Shell_Fish] =
+        "function __clags_complete_@FUNC@\n"
+        "    set -l tokens (commandline -opc) (commandline -ct)\n"
+        "    set -l candidates ($tokens[1] @COMPLETE@ $tokens[2..-1] "
+        "2>/dev/null)\n"
+        "    if test (count $candidates) -eq 0\n"
+        "        __fish_complete_path (commandline -ct)\n"
+        "    else\n"
+        "        printf '%s\\n' $candidates\n"
+        "    end\n"
+        "end\n"
+        "complete -c @NAME@ -f -a '(__clags_complete_@FUNC@)'\n",
+};
+
+void clags_completion_script(clags_shell_t shell, const char *program_name,
+                             clags_sb_t *out) {
+  if (out == nullptr || program_name == nullptr ||
+      (size_t)shell >= clags_arr_len(clags__completion_scripts))
+    return;
+  const char *slash = strrchr(program_name, '/');
+  const char *name = slash != nullptr ? slash + 1 : program_name;
+  for (const char *c = clags__completion_scripts[shell]; *c != '\0'; ++c) {
+    if (strncmp(c, "@NAME@", 6) == 0) {
+      clags__sb_append_cstr(out, name);
+      c += 5;
+    } else if (strncmp(c, "@FUNC@", 6) == 0) {
+      for (const char *n = name; *n != '\0'; ++n) {
+        char ident = isalnum((unsigned char)*n) ? *n : '_';
+        clags__sb_append(out, &ident, 1);
+      }
+      c += 5;
+    } else if (strncmp(c, "@COMPLETE@", 10) == 0) {
+      clags__sb_append_cstr(out, CLAGS_COMPLETE_COMMAND);
+      c += 9;
+    } else {
+      clags__sb_append(out, c, 1);
+    }
+  }
+}
+
+[[nodiscard]] bool clags_handle_completion(int argc, char **argv,
+                                           clags_config_t *config) {
+  if (argc < 2 || argv == nullptr || argv[1] == nullptr)
+    return false;
+  clags_sb_t out = {0};
+  if (strcmp(argv[1], CLAGS_COMPLETE_COMMAND) == 0) {
+    // the hidden command stands in for the program name
+    if (!clags_complete(argc - 1, argv + 1, config, &out))
+      out.count = 0;
+  } else if (strcmp(argv[1], CLAGS_COMPLETION_SCRIPT_COMMAND) == 0) {
+    static const char *const shells[] = {
+        [Clags_Shell_Bash] = "bash",
+        [Clags_Shell_Zsh] = "zsh",
+        [Clags_Shell_Fish] = "fish",
+    };
+    for (size_t i = 0; argc > 2 && i < clags_arr_len(shells); ++i) {
+      if (argv[2] != nullptr && strcmp(argv[2], shells[i]) == 0)
+        clags_completion_script((clags_shell_t)i, argv[0], &out);
+    }
+    if (out.count == 0)
+      fprintf(stderr, "Usage: %s %s <bash|zsh|fish>\n", argv[0],
+              CLAGS_COMPLETION_SCRIPT_COMMAND);
+  } else {
+    return false;
+  }
+  fwrite(out.items, 1, out.count, stdout);
+  clags_sb_free(&out);
+  return true;
+}
+
+// the start of a snapshot: the selected subcommand indices follow, then the
+// records of every config on that path, and the string pool last
+typedef struct {
+  uint32_t magic;     // `CLAGS__SNAPSHOT_MAGIC`
+  uint32_t word_size; // the size of a pointer on the writing platform
+  uint64_t size;      // the size of the whole snapshot
+  uint64_t pool;      // the offset of the string pool
+  uint64_t depth;     // the number of configs on the subcommand path
+} clags__snapshot_header_t;
+
+#define CLAGS__SNAPSHOT_MAGIC 0x5347'4C43U
+#define CLAGS__SNAPSHOT_NONE UINT64_MAX
+
+// the configs on the subcommand path of a parse and the selected indices
+typedef struct {
+  clags_config_t *configs[CLAGS_MAX_PARSE_DEPTH];
+  size_t indices[CLAGS_MAX_PARSE_DEPTH];
+  size_t depth;
+} clags__snapshot_path_t;
+
+typedef struct {
+  clags_sb_t *out;
+  clags_sb_t pool;
+  clags__snapshot_path_t path;
+  clags_context_t *context;
+} clags__snapshot_writer_t;
+
+typedef struct {
+  char *base;
+  size_t position;
+  size_t pool;
+  size_t size;
+  clags__snapshot_path_t path;
+  clags_context_t *context;
+  bool apply; // write the values, after a pass only validating them
+} clags__snapshot_reader_t;
+
+// the subcommand positional of a config, if any
+[[nodiscard]] static clags_positional_t *
+clags__snapshot_subcmd(clags_config_t *config) {
+  for (size_t i = 0; i < config->args_count; ++i) {
+    clags_arg_t *arg = &config->args[i];
+    if (arg->type == Clags_Positional && !arg->pos.is_list &&
+        arg->pos.value_type == Clags_Subcmd && arg->pos.subcmds != nullptr)
+      return &arg->pos;
+  }
+  return nullptr;
+}
+
+// raw bytes, or zeros if `data` is nullptr, padded with zeros to whole words
+static void clags__snapshot_bytes(clags_sb_t *out, const void *data,
+                                  size_t size) {
+  static const char zeros[sizeof(uint64_t)] = {0};
+  if (size > 0 && data == nullptr) {
+    size_t count = 0;
+    clags_assert(!clags__checked_add_size(&count, out->count, size),
+                 "String builder length overflow!");
+    clags__sb_reserve(out, count);
+    memset(out->items + out->count, 0, size);
+    out->count = count;
+  } else if (size > 0) {
+    clags__sb_append(out, data, size);
+  }
+  size_t padding = (sizeof(uint64_t) - size % sizeof(uint64_t)) %
+                   sizeof(uint64_t);
+  clags__sb_append(out, zeros, padding);
+}
+
+static inline void clags__snapshot_word(clags_sb_t *out, uint64_t word) {
+  clags__snapshot_bytes(out, &word, sizeof(word));
+}
+
+// the pool offset of a string, `CLAGS__SNAPSHOT_NONE` for nullptr
+[[nodiscard]] static uint64_t
+clags__snapshot_string(clags__snapshot_writer_t *writer, const char *value) {
+  if (value == nullptr)
+    return CLAGS__SNAPSHOT_NONE;
+  uint64_t offset = writer->pool.count;
+  clags__sb_append(&writer->pool, value, strlen(value) + 1);
+  return offset;
+}
+
+// the index of a choice, `CLAGS__SNAPSHOT_NONE` for nullptr
+[[nodiscard]] static uint64_t
+clags__snapshot_choice(const clags_choices_t *choices,
+                       const clags_choice_t *choice) {
+  if (choice == nullptr || choices == nullptr || choice < choices->items ||
+      choice >= choices->items + choices->count)
+    return CLAGS__SNAPSHOT_NONE;
+  return (uint64_t)(choice - choices->items);
+}
+
+// the word standing for one pointer element, or false for a raw value
+[[nodiscard]] static bool
+clags__snapshot_pointer(clags__snapshot_writer_t *writer,
+                        clags_value_type_t value_type,
+                        const clags_choices_t *choices, const void *item,
+                        uint64_t *word) {
+  switch (value_type) {
+  case Clags_String:
+  case Clags_Path:
+  case Clags_File:
+  case Clags_Dir:
+    *word = clags__snapshot_string(writer, *(char *const *)item);
+    return true;
+  case Clags_Choice:
+    *word = clags__snapshot_choice(choices, *(clags_choice_t *const *)item);
+    return true;
+  default:
+    return false;
+  }
+}
+
+// write the value of one positional or option
+[[nodiscard]] static bool
+clags__snapshot_write_value(clags__snapshot_writer_t *writer,
+                            clags_config_t *config, const char *arg_name,
+                            clags_value_type_t value_type, bool is_list,
+                            const clags_choices_t *choices, void *variable) {
+  size_t item_size = 0;
+  if (value_type == Clags_Subcmd ||
+      !clags__list_expected_item_size(value_type, &item_size)) {
+    clags__log(config, Clags_ConfigError,
+               "Argument '%s' of type '%s' cannot be snapshotted!", arg_name,
+               clags__is_valid_value_type(value_type)
+                   ? clags__type_names[value_type]
+                   : "invalid");
+    return false;
+  }
+  uint64_t word = 0;
+  if (!is_list) {
+    if (clags__snapshot_pointer(writer, value_type, choices, variable, &word))
+      clags__snapshot_word(writer->out, word);
+    else
+      clags__snapshot_bytes(writer->out, variable, item_size);
+    return true;
+  }
+  clags_list_t *list = variable;
+  if (list->on_element != nullptr) {
+    clags__snapshot_word(writer->out, 0);
+    return true;
+  }
+  if (list->item_size != item_size) {
+    clags__log(config, Clags_ConfigError,
+               "The list of argument '%s' does not hold '%s' items!", arg_name,
+               clags__type_names[value_type]);
+    return false;
+  }
+  clags__snapshot_word(writer->out, list->count);
+  if (list->count == 0)
+    return true;
+  if (!clags__snapshot_pointer(writer, value_type, choices, list->items,
+                               &word)) {
+    clags__snapshot_bytes(writer->out, list->items, list->count * item_size);
+    return true;
+  }
+  // room for the pointers, which loading derives from the words after them
+  clags__snapshot_bytes(writer->out, nullptr, list->count * item_size);
+  for (size_t i = 0; i < list->count; ++i) {
+    const char *item = (const char *)list->items + i * item_size;
+    if (!clags__snapshot_pointer(writer, value_type, choices, item, &word))
+      clags_unreachable("Pointer type without pointer items");
+    clags__snapshot_word(writer->out, word);
+  }
+  return true;
+}
+
+// write the records of one config on the path, in argument order
+[[nodiscard]] static bool
+clags__snapshot_write_config(clags__snapshot_writer_t *writer,
+                             clags_config_t *config) {
+  clags__snapshot_word(writer->out, clags__config_fingerprint(config));
+  for (size_t i = 0; i < config->args_count; ++i) {
+    clags_arg_t *arg = &config->args[i];
+    switch (arg->type) {
+    case Clags_Positional: {
+      void *variable = clags__variable(writer->context, arg->pos.variable);
+      if (variable == nullptr || arg->pos.value_type == Clags_Subcmd)
+        break;
+      if (!clags__snapshot_write_value(writer, config, arg->pos.arg_name,
+                                       arg->pos.value_type, arg->pos.is_list,
+                                       arg->pos.choices, variable))
+        return false;
+    } break;
+    case Clags_Option: {
+      void *variable = clags__variable(writer->context, arg->opt.variable);
+      const char *name = arg->opt.long_flag != nullptr ? arg->opt.long_flag
+                                                       : arg->opt.arg_name;
+      if (variable != nullptr &&
+          !clags__snapshot_write_value(writer, config, name,
+                                       arg->opt.value_type, arg->opt.is_list,
+                                       arg->opt.choices, variable))
+        return false;
+    } break;
+    case Clags_Flag: {
+      void *variable = clags__variable(writer->context, arg->flag.variable);
+      if (variable == nullptr)
+        break;
+      if (arg->flag.type == Clags_BoolFlag) {
+        clags__snapshot_bytes(writer->out, variable, sizeof(bool));
+      } else if (arg->flag.type == Clags_CountFlag) {
+        clags__snapshot_bytes(writer->out, variable, sizeof(size_t));
+      } else if (arg->flag.type == Clags_ConfigFlag) {
+        // the config the flag was set in, by its depth on the path
+        clags_config_t *target = *(clags_config_t **)variable;
+        uint64_t depth = CLAGS__SNAPSHOT_NONE;
+        for (size_t j = 0; target != nullptr && j < writer->path.depth; ++j) {
+          if (writer->path.configs[j] == target)
+            depth = j;
+        }
+        clags__snapshot_word(writer->out, depth);
+      }
+    } break;
+    default: {
+      clags_unreachable("Invalid clags_arg_type_t");
+    }
+    }
+  }
+  return true;
+}
+
+[[nodiscard]] bool clags_snapshot(clags_config_t *config,
+                                  clags_context_t *context, clags_sb_t *out) {
+  if (config == nullptr || out == nullptr)
+    return false;
+  clags__snapshot_writer_t writer = {.out = out, .context = context};
+  out->count = 0;
+
+  // follow the selected subcommands down from the root
+  clags__snapshot_path_t *path = &writer.path;
+  for (clags_config_t *current = config; current != nullptr;) {
+    if (path->depth >= CLAGS_MAX_PARSE_DEPTH) {
+      clags__log(config, Clags_ConfigError,
+                 "Subcommand nesting too deep to snapshot!");
+      clags__set_error(config, context, Clags_Error_InvalidConfig);
+      return false;
+    }
+    path->configs[path->depth] = current;
+    clags_positional_t *pos = clags__snapshot_subcmd(current);
+    void *variable =
+        pos == nullptr ? nullptr : clags__variable(context, pos->variable);
+    clags_subcmd_t *subcmd =
+        variable == nullptr ? nullptr : *(clags_subcmd_t **)variable;
+    current = nullptr;
+    if (subcmd != nullptr && subcmd >= pos->subcmds->items &&
+        subcmd < pos->subcmds->items + pos->subcmds->count) {
+      path->indices[path->depth] = (size_t)(subcmd - pos->subcmds->items);
+      current = subcmd->config;
+    }
+    path->depth++;
+  }
+
+  clags__snapshot_header_t header = {
+      .magic = CLAGS__SNAPSHOT_MAGIC, .word_size = sizeof(void *)};
+  clags__snapshot_bytes(out, &header, sizeof(header));
+  for (size_t i = 0; i + 1 < path->depth; ++i)
+    clags__snapshot_word(out, path->indices[i]);
+  for (size_t i = 0; i < path->depth; ++i) {
+    if (!clags__snapshot_write_config(&writer, path->configs[i])) {
+      clags_sb_free(&writer.pool);
+      out->count = 0;
+      clags__set_error(config, context, Clags_Error_InvalidConfig);
+      return false;
+    }
+  }
+  header.pool = out->count;
+  clags__sb_append(out, writer.pool.items, writer.pool.count);
+  header.size = out->count;
+  header.depth = path->depth;
+  memcpy(out->items, &header, sizeof(header));
+  clags_sb_free(&writer.pool);
+  return true;
+}
+
+// the next `size` bytes of records, padded to whole words, nullptr past them
+[[nodiscard]] static char *
+clags__snapshot_take(clags__snapshot_reader_t *reader, size_t size) {
+  size_t words = size / sizeof(uint64_t) + (size % sizeof(uint64_t) != 0);
+  if (words > (reader->pool - reader->position) / sizeof(uint64_t))
+    return nullptr;
+  char *data = reader->base + reader->position;
+  reader->position += words * sizeof(uint64_t);
+  return data;
+}
+
+[[nodiscard]] static bool clags__snapshot_read(clags__snapshot_reader_t *reader,
+                                               uint64_t *word) {
+  char *data = clags__snapshot_take(reader, sizeof(*word));
+  if (data != nullptr)
+    memcpy(word, data, sizeof(*word));
+  return data != nullptr;
+}
+
+// resolve the word of a pointer element
+[[nodiscard]] static bool
+clags__snapshot_resolve(const clags__snapshot_reader_t *reader,
+                        clags_value_type_t value_type,
+                        const clags_choices_t *choices, uint64_t word,
+                        void **pointer) {
+  if (word == CLAGS__SNAPSHOT_NONE) {
+    *pointer = nullptr;
+    return true;
+  }
+  if (value_type == Clags_Choice) {
+    if (choices == nullptr || word >= choices->count)
+      return false;
+    *pointer = &choices->items[word];
+    return true;
+  }
+  if (word >= reader->size - reader->pool)
+    return false;
+  *pointer = reader->base + reader->pool + word;
+  return true;
+}
+
+// read the value of one positional or option
+[[nodiscard]] static bool
+clags__snapshot_read_value(clags__snapshot_reader_t *reader,
+                           clags_value_type_t value_type, bool is_list,
+                           clags_choices_t *choices, void *variable) {
+  size_t item_size = 0;
+  if (value_type == Clags_Subcmd ||
+      !clags__list_expected_item_size(value_type, &item_size))
+    return false;
+  bool pointers = value_type == Clags_String || value_type == Clags_Path ||
+                  value_type == Clags_File || value_type == Clags_Dir ||
+                  value_type == Clags_Choice;
+  uint64_t word = 0;
+  void *pointer = nullptr;
+  if (!is_list) {
+    if (!pointers) {
+      char *data = clags__snapshot_take(reader, item_size);
+      if (data != nullptr && reader->apply)
+        memcpy(variable, data, item_size);
+      return data != nullptr;
+    }
+    if (!clags__snapshot_read(reader, &word) ||
+        !clags__snapshot_resolve(reader, value_type, choices, word, &pointer))
+      return false;
+    if (reader->apply)
+      memcpy(variable, &pointer, sizeof(pointer));
+    return true;
+  }
+
+  clags_list_t *list = variable;
+  uint64_t count = 0;
+  if (!clags__snapshot_read(reader, &count))
+    return false;
+  if (list->on_element != nullptr)
+    return count == 0;
+  if (list->item_size != item_size ||
+      count > (reader->pool - reader->position) / item_size)
+    return false;
+  char *items = clags__snapshot_take(reader, (size_t)count * item_size);
+  uint64_t *words = nullptr;
+  if (pointers && count > 0) {
+    words = (uint64_t *)clags__snapshot_take(reader, (size_t)count *
+                                                         sizeof(uint64_t));
+    if (words == nullptr)
+      return false;
+  }
+  if (items == nullptr)
+    return false;
+  // fix the pointers up in place, so that the buffer may move between loads
+  for (size_t i = 0; pointers && i < count; ++i) {
+    if (!clags__snapshot_resolve(reader, value_type, choices, words[i],
+                                 &pointer))
+      return false;
+    if (reader->apply)
+      memcpy(items + i * item_size, &pointer, sizeof(pointer));
+  }
+  if (!reader->apply)
+    return true;
+  // the storage of fixed lists belongs to the caller, which keeps it
+  if (!list->fixed)
+    clags_list_free(list);
+  *list = (clags_list_t)clags_fixed_list(items, (size_t)count);
+  list->item_size = item_size;
+  list->count = (size_t)count;
+  return true;
+}
+
+// read the records of one config on the path, in argument order
+[[nodiscard]] static bool
+clags__snapshot_read_config(clags__snapshot_reader_t *reader, size_t depth) {
+  clags_config_t *config = reader->path.configs[depth];
+  uint64_t fingerprint = 0;
+  if (!clags__snapshot_read(reader, &fingerprint) ||
+      fingerprint != clags__config_fingerprint(config))
+    return false;
+  for (size_t i = 0; i < config->args_count; ++i) {
+    clags_arg_t *arg = &config->args[i];
+    switch (arg->type) {
+    case Clags_Positional: {
+      void *variable = clags__variable(reader->context, arg->pos.variable);
+      if (variable == nullptr)
+        break;
+      if (arg->pos.value_type == Clags_Subcmd) {
+        clags_subcmd_t *subcmd = nullptr;
+        if (depth + 1 < reader->path.depth &&
+            &arg->pos == clags__snapshot_subcmd(config))
+          subcmd = &arg->pos.subcmds->items[reader->path.indices[depth]];
+        if (reader->apply)
+          memcpy(variable, &subcmd, sizeof(subcmd));
+        break;
+      }
+      if (!clags__snapshot_read_value(reader, arg->pos.value_type,
+                                      arg->pos.is_list, arg->pos.choices,
+                                      variable))
+        return false;
+    } break;
+    case Clags_Option: {
+      void *variable = clags__variable(reader->context, arg->opt.variable);
+      if (variable != nullptr &&
+          !clags__snapshot_read_value(reader, arg->opt.value_type,
+                                      arg->opt.is_list, arg->opt.choices,
+                                      variable))
+        return false;
+    } break;
+    case Clags_Flag: {
+      void *variable = clags__variable(reader->context, arg->flag.variable);
+      if (variable == nullptr)
+        break;
+      if (arg->flag.type == Clags_BoolFlag ||
+          arg->flag.type == Clags_CountFlag) {
+        size_t size =
+            arg->flag.type == Clags_BoolFlag ? sizeof(bool) : sizeof(size_t);
+        char *data = clags__snapshot_take(reader, size);
+        if (data == nullptr)
+          return false;
+        if (reader->apply)
+          memcpy(variable, data, size);
+      } else if (arg->flag.type == Clags_ConfigFlag) {
+        uint64_t word = 0;
+        if (!clags__snapshot_read(reader, &word) ||
+            (word != CLAGS__SNAPSHOT_NONE && word >= reader->path.depth))
+          return false;
+        clags_config_t *target = word == CLAGS__SNAPSHOT_NONE
+                                     ? nullptr
+                                     : reader->path.configs[word];
+        if (reader->apply)
+          memcpy(variable, &target, sizeof(target));
+      }
+    } break;
+    default: {
+      clags_unreachable("Invalid clags_arg_type_t");
+    }
+    }
+  }
+  return true;
+}
+
+// check the header and the subcommand path of a snapshot
+[[nodiscard]] static bool
+clags__snapshot_open(clags__snapshot_reader_t *reader, clags_config_t *config) {
+  clags__snapshot_header_t header;
+  if (reader->size < sizeof(header) ||
+      (uintptr_t)reader->base % alignof(uint64_t) != 0)
+    return false;
+  memcpy(&header, reader->base, sizeof(header));
+  if (header.magic != CLAGS__SNAPSHOT_MAGIC ||
+      header.word_size != sizeof(void *) || header.size != reader->size ||
+      header.pool < sizeof(header) || header.pool > header.size ||
+      header.pool % sizeof(uint64_t) != 0 || header.depth == 0 ||
+      header.depth > CLAGS_MAX_PARSE_DEPTH)
+    return false;
+  // the last pooled string must be terminated
+  if (header.pool < header.size && reader->base[header.size - 1] != '\0')
+    return false;
+  reader->pool = (size_t)header.pool;
+  reader->position = sizeof(header);
+
+  clags__snapshot_path_t *path = &reader->path;
+  path->configs[0] = config;
+  path->depth = (size_t)header.depth;
+  for (size_t i = 0; i + 1 < path->depth; ++i) {
+    uint64_t index = 0;
+    clags_positional_t *pos = clags__snapshot_subcmd(path->configs[i]);
+    if (!clags__snapshot_read(reader, &index) || pos == nullptr ||
+        index >= pos->subcmds->count ||
+        pos->subcmds->items[index].config == nullptr)
+      return false;
+    path->indices[i] = (size_t)index;
+    path->configs[i + 1] = pos->subcmds->items[index].config;
+  }
+  return true;
+}
+
+[[nodiscard]] bool clags_snapshot_load(clags_config_t *config,
+                                       clags_context_t *context, void *buffer,
+                                       size_t size) {
+  if (config == nullptr)
+    return false;
+  clags__snapshot_reader_t reader = {
+      .base = buffer, .size = size, .context = context};
+  bool valid = buffer != nullptr && clags__snapshot_open(&reader, config);
+  // validate every record before writing any variable
+  size_t records = reader.position;
+  for (size_t i = 0; valid && i < reader.path.depth; ++i)
+    valid = clags__snapshot_read_config(&reader, i);
+  if (!valid) {
+    clags__log(config, Clags_Error, "Snapshot does not match the config!");
+    clags__set_error(config, context, Clags_Error_InvalidSnapshot);
+    return false;
+  }
+  reader.apply = true;
+  reader.position = records;
+  for (size_t i = 0; i < reader.path.depth; ++i) {
+    if (!clags__snapshot_read_config(&reader, i))
+      clags_unreachable("Snapshot changed while loading");
+  }
+  if (context != nullptr) {
+    context->config = reader.path.configs[reader.path.depth - 1];
+    context->name = nullptr;
+  }
+  clags__set_error(config, context, Clags_Error_Ok);
+  return true;
+}
@@ -0,0 +1,163 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "clags/clags.h"
+
+// compares the sorted long flag index used by `clags_parse` and
+// `clags_parse_compiled` with the linear option and flag scan it replaced, for
+// configs of 10, 100 and 1000 options
+
+enum {
+  CLAGS_BENCH_TOKENS = 4'096,
+  CLAGS_BENCH_ROUNDS = 64,
+  CLAGS_BENCH_NAME_SIZE = 32,
+};
+
+static uint64_t clags_bench_now_ns() {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1'000'000'000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// the lookup `clags__parse_internal` performed before the long flag index
+static const void *clags_bench_linear_lookup(clags_option_t *options,
+                                             size_t option_count,
+                                             clags_flag_t *flags,
+                                             size_t flag_count,
+                                             const char *arg) {
+  for (size_t i = 0; i < option_count; ++i) {
+    if (options[i].long_flag == nullptr)
+      continue;
+    size_t long_flag_len = strlen(options[i].long_flag);
+    if (strncmp(arg, options[i].long_flag, long_flag_len) == 0) {
+      const char *value = arg + long_flag_len;
+      if (*value == '\0' || *value == '=')
+        return &options[i];
+    }
+  }
+  for (size_t i = 0; i < flag_count; ++i) {
+    if (flags[i].long_flag && strcmp(arg, flags[i].long_flag) == 0)
+      return &flags[i];
+  }
+  return nullptr;
+}
+
+static void clags_bench_run(size_t option_count) {
+  size_t flag_count = option_count / 10 + 1;
+  size_t args_count = option_count + flag_count;
+
+  char(*names)[CLAGS_BENCH_NAME_SIZE] = calloc(args_count, sizeof(*names));
+  char(*tokens)[CLAGS_BENCH_NAME_SIZE + 8] =
+      calloc(CLAGS_BENCH_TOKENS, sizeof(*tokens));
+  char **values = calloc(option_count, sizeof(*values));
+  bool *switches = calloc(flag_count, sizeof(*switches));
+  clags_arg_t *args = calloc(args_count, sizeof(*args));
+  clags_option_t *options = calloc(option_count, sizeof(*options));
+  clags_flag_t *flags = calloc(flag_count, sizeof(*flags));
+  char **argv = calloc(CLAGS_BENCH_TOKENS + 1, sizeof(*argv));
+  if (!names || !tokens || !values || !switches || !args || !options ||
+      !flags || !argv) {
+    fprintf(stderr, "Out of memory!\n");
+    exit(1);
+  }
+
+  for (size_t i = 0; i < option_count; ++i) {
+    snprintf(names[i], sizeof(names[i]), "option-%zu", i);
+    options[i] =
+        (clags_option_t){.long_flag = names[i], .variable = &values[i]};
+    args[i] = (clags_arg_t){.type = Clags_Option, .opt = options[i]};
+  }
+  for (size_t i = 0; i < flag_count; ++i) {
+    char *name = names[option_count + i];
+    snprintf(name, CLAGS_BENCH_NAME_SIZE, "flag-%zu", i);
+    flags[i] = (clags_flag_t){.long_flag = name, .variable = &switches[i]};
+    args[option_count + i] =
+        (clags_arg_t){.type = Clags_Flag, .flag = flags[i]};
+  }
+
+  // a deterministic mix of designated options and flags
+  uint64_t seed = 0x9E37'79B9'7F4A'7C15ULL;
+  argv[0] = "bench";
+  for (size_t i = 0; i < CLAGS_BENCH_TOKENS; ++i) {
+    seed = seed * 6'364'136'223'846'793'005ULL + 1'442'695'040'888'963'407ULL;
+    size_t pick = (size_t)(seed >> 33);
+    if (pick % 8 == 0)
+      snprintf(tokens[i], sizeof(tokens[i]), "--flag-%zu", pick % flag_count);
+    else
+      snprintf(tokens[i], sizeof(tokens[i]), "--option-%zu=v",
+               pick % option_count);
+    argv[i + 1] = tokens[i];
+  }
+
+  volatile size_t found = 0;
+  uint64_t start = clags_bench_now_ns();
+  for (size_t round = 0; round < CLAGS_BENCH_ROUNDS; ++round) {
+    for (size_t i = 0; i < CLAGS_BENCH_TOKENS; ++i) {
+      found += clags_bench_linear_lookup(options, option_count, flags,
+                                         flag_count, tokens[i] + 2) != nullptr;
+    }
+  }
+  uint64_t linear_ns = clags_bench_now_ns() - start;
+
+  clags_config_t config = {
+      .args = args,
+      .args_count = args_count,
+      .options = {.min_log_level = Clags_NoLogs},
+  };
+  start = clags_bench_now_ns();
+  for (size_t round = 0; round < CLAGS_BENCH_ROUNDS; ++round) {
+    if (clags_parse(CLAGS_BENCH_TOKENS + 1, argv, &config) != nullptr) {
+      fprintf(stderr, "Benchmark parse failed: %s\n",
+              clags_error_description(config.error));
+      exit(1);
+    }
+  }
+  uint64_t parse_ns = clags_bench_now_ns() - start;
+
+  if (!clags_compile(&config)) {
+    fprintf(stderr, "Benchmark config failed to compile!\n");
+    exit(1);
+  }
+  start = clags_bench_now_ns();
+  for (size_t round = 0; round < CLAGS_BENCH_ROUNDS; ++round) {
+    if (clags_parse_compiled(CLAGS_BENCH_TOKENS + 1, argv, &config) !=
+        nullptr) {
+      fprintf(stderr, "Benchmark parse failed: %s\n",
+              clags_error_description(config.error));
+      exit(1);
+    }
+  }
+  uint64_t compiled_ns = clags_bench_now_ns() - start;
+
+  double total_tokens = (double)CLAGS_BENCH_TOKENS * CLAGS_BENCH_ROUNDS;
+  printf("%6zu options: linear lookup %9.1f ns/token, clags_parse %9.1f "
+         "ns/token, clags_parse_compiled %9.1f ns/token\n",
+         option_count, (double)linear_ns / total_tokens,
+         (double)parse_ns / total_tokens, (double)compiled_ns / total_tokens);
+  if (found != total_tokens) {
+    fprintf(stderr, "Linear lookup missed tokens!\n");
+    exit(1);
+  }
+
+  clags_config_free(&config);
+  clags_config_free_compiled(&config);
+  free(names);
+  free(tokens);
+  free(values);
+  free(switches);
+  free(args);
+  free(options);
+  free(flags);
+  free(argv);
+}
+
+int main() {
+  const size_t option_counts[] = {10, 100, 1'000};
+  for (size_t i = 0; i < clags_arr_len(option_counts); ++i) {
+    clags_bench_run(option_counts[i]);
+  }
+  return 0;
+}
@@ -0,0 +1,524 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "clags/clags.h"
+#include "fuzz_harness.h"
+
+// measures the parse loop on synthetic configs: many options, long
+// `--key=value` tokens, large choice sets, deep subcommand trees, long and
+// streamed lists and numeric values, reporting the time per token and, with
+// `CLAGS_STATS` enabled, the heap allocations per parse; any files passed as
+// arguments are replayed as fuzzing corpus inputs
+
+enum {
+  CLAGS_BENCH_TOKENS = 4'096,
+  CLAGS_BENCH_ROUNDS = 64,
+  CLAGS_BENCH_NAME_SIZE = 32,
+  CLAGS_BENCH_CHOICES = 1'024,
+  CLAGS_BENCH_SUBCMD_DEPTH = 48,
+  CLAGS_BENCH_SUBCMD_WIDTH = 8,
+  CLAGS_BENCH_SUBCMD_ROUNDS = 4'096,
+  CLAGS_BENCH_LIST_ITEMS = 100'000,
+  CLAGS_BENCH_LIST_ROUNDS = 16,
+  CLAGS_BENCH_LIST_TAGS = 256,
+  CLAGS_BENCH_REPLAY_ROUNDS = 1'024,
+  CLAGS_BENCH_ASSIGNMENTS = 32'768,
+  CLAGS_BENCH_ASSIGNMENT_OPTIONS = 64,
+  CLAGS_BENCH_ASSIGNMENT_SIZE = 96,
+  CLAGS_BENCH_ASSIGNMENT_ROUNDS = 16,
+};
+
+typedef char clags_bench_name_t[CLAGS_BENCH_NAME_SIZE];
+
+static uint64_t clags_bench_now_ns() {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return (uint64_t)ts.tv_sec * 1'000'000'000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void *clags_bench_calloc(size_t count, size_t size) {
+  void *ptr = calloc(count, size);
+  if (ptr == nullptr) {
+    fprintf(stderr, "Out of memory!\n");
+    exit(1);
+  }
+  return ptr;
+}
+
+// a deterministic pseudo random number generator
+static size_t clags_bench_next(uint64_t *seed) {
+  *seed = *seed * 6'364'136'223'846'793'005ULL + 1'442'695'040'888'963'407ULL;
+  return (size_t)(*seed >> 33);
+}
+
+static void clags_bench_report(const char *scenario, size_t tokens,
+                               size_t rounds, uint64_t ns,
+                               const clags_parse_stats_t *stats) {
+  double total_tokens = (double)tokens * (double)rounds;
+  printf("%-36s %9.1f ns/token", scenario, (double)ns / total_tokens);
+#if CLAGS_STATS
+  printf(" %11.1f allocations/parse",
+         (double)stats->allocations / (double)stats->parses);
+  if (stats->strings_interned > 0) {
+    printf(" %5.1f%% interned", 100.0 * (double)stats->strings_interned /
+                                    (double)stats->strings_duplicated);
+  }
+#else
+  (void)stats;
+  printf("     (allocations need CLAGS_STATS=1)");
+#endif // CLAGS_STATS
+  printf("\n");
+}
+
+// parse the same argv repeatedly, freeing the parsed lists after each round;
+// the allocations are counted in one more round, keeping the stats clock out
+// of the timed ones
+static void clags_bench_parse(const char *scenario, clags_config_t *config,
+                              size_t argc, char **argv, size_t rounds,
+                              bool compiled) {
+  if (compiled && !clags_compile(config)) {
+    fprintf(stderr, "Benchmark config '%s' failed to compile!\n", scenario);
+    exit(1);
+  }
+  clags_parse_stats_t stats = {0};
+  uint64_t ns = 0;
+  for (size_t round = 0; round <= rounds; ++round) {
+    if (round == rounds)
+      clags_stats_attach(&stats);
+    uint64_t start = clags_bench_now_ns();
+    clags_config_t *failed = compiled
+                                 ? clags_parse_compiled(argc, argv, config)
+                                 : clags_parse(argc, argv, config);
+    if (round < rounds)
+      ns += clags_bench_now_ns() - start;
+    clags_stats_attach(nullptr);
+    if (failed != nullptr) {
+      fprintf(stderr, "Benchmark '%s' failed to parse: %s\n", scenario,
+              clags_error_description(failed->error));
+      exit(1);
+    }
+    clags_config_free(config);
+  }
+  clags_config_free_compiled(config);
+  clags_bench_report(scenario, argc - 1, rounds, ns, &stats);
+}
+
+static void clags_bench_options(size_t option_count) {
+  clags_bench_name_t *names = clags_bench_calloc(option_count, sizeof(*names));
+  clags_bench_name_t *tokens =
+      clags_bench_calloc(CLAGS_BENCH_TOKENS, sizeof(*tokens));
+  char **values = clags_bench_calloc(option_count, sizeof(*values));
+  clags_arg_t *args = clags_bench_calloc(option_count, sizeof(*args));
+  char **argv = clags_bench_calloc(CLAGS_BENCH_TOKENS + 1, sizeof(*argv));
+
+  for (size_t i = 0; i < option_count; ++i) {
+    snprintf(names[i], sizeof(names[i]), "option-%zu", i);
+    args[i] = (clags_arg_t){
+        .type = Clags_Option,
+        .opt = {.long_flag = names[i], .variable = &values[i]},
+    };
+  }
+  uint64_t seed = 0x9E37'79B9'7F4A'7C15ULL;
+  argv[0] = "bench";
+  for (size_t i = 0; i < CLAGS_BENCH_TOKENS; ++i) {
+    snprintf(tokens[i], sizeof(tokens[i]), "--option-%zu=v",
+             clags_bench_next(&seed) % option_count);
+    argv[i + 1] = tokens[i];
+  }
+
+  clags_config_t config = {
+      .args = args,
+      .args_count = option_count,
+      .options = {.min_log_level = Clags_NoLogs},
+  };
+  char scenario[64];
+  snprintf(scenario, sizeof(scenario), "%zu options", option_count);
+  clags_bench_parse(scenario, &config, CLAGS_BENCH_TOKENS + 1, argv,
+                    CLAGS_BENCH_ROUNDS, false);
+  snprintf(scenario, sizeof(scenario), "%zu options, compiled", option_count);
+  clags_bench_parse(scenario, &config, CLAGS_BENCH_TOKENS + 1, argv,
+                    CLAGS_BENCH_ROUNDS, true);
+
+  free(names);
+  free(tokens);
+  free(values);
+  free(args);
+  free(argv);
+}
+
+// tens of thousands of long `--key=value` tokens, with an ignore prefix and a
+// list terminator configured so every token is classified in full
+static void clags_bench_assignments() {
+  typedef char clags_bench_token_t[CLAGS_BENCH_ASSIGNMENT_SIZE];
+  clags_bench_name_t *names =
+      clags_bench_calloc(CLAGS_BENCH_ASSIGNMENT_OPTIONS, sizeof(*names));
+  clags_bench_token_t *tokens =
+      clags_bench_calloc(CLAGS_BENCH_ASSIGNMENTS, sizeof(*tokens));
+  char **values =
+      clags_bench_calloc(CLAGS_BENCH_ASSIGNMENT_OPTIONS, sizeof(*values));
+  clags_arg_t *args =
+      clags_bench_calloc(CLAGS_BENCH_ASSIGNMENT_OPTIONS, sizeof(*args));
+  char **argv = clags_bench_calloc(CLAGS_BENCH_ASSIGNMENTS + 1, sizeof(*argv));
+
+  for (size_t i = 0; i < CLAGS_BENCH_ASSIGNMENT_OPTIONS; ++i) {
+    snprintf(names[i], sizeof(names[i]), "setting-with-long-name-%zu", i);
+    args[i] = (clags_arg_t){
+        .type = Clags_Option,
+        .opt = {.long_flag = names[i], .variable = &values[i]},
+    };
+  }
+  uint64_t seed = 0x9E37'79B9'7F4A'7C15ULL;
+  argv[0] = "bench";
+  for (size_t i = 0; i < CLAGS_BENCH_ASSIGNMENTS; ++i) {
+    size_t pick = clags_bench_next(&seed);
+    snprintf(tokens[i], sizeof(tokens[i]),
+             "--setting-with-long-name-%zu=value/%016zx/%016zx",
+             pick % CLAGS_BENCH_ASSIGNMENT_OPTIONS, pick, ~pick);
+    argv[i + 1] = tokens[i];
+  }
+
+  clags_config_t config = {
+      .args = args,
+      .args_count = CLAGS_BENCH_ASSIGNMENT_OPTIONS,
+      .options = {.min_log_level = Clags_NoLogs,
+                  .ignore_prefix = "#",
+                  .list_terminator = "::"},
+  };
+  clags_bench_parse("32768 long assignments, compiled", &config,
+                    CLAGS_BENCH_ASSIGNMENTS + 1, argv,
+                    CLAGS_BENCH_ASSIGNMENT_ROUNDS, true);
+
+  free(names);
+  free(tokens);
+  free(values);
+  free(args);
+  free(argv);
+}
+
+static void clags_bench_choices() {
+  clags_bench_name_t *names =
+      clags_bench_calloc(CLAGS_BENCH_CHOICES, sizeof(*names));
+  clags_bench_name_t *tokens =
+      clags_bench_calloc(CLAGS_BENCH_TOKENS, sizeof(*tokens));
+  clags_choice_t *items =
+      clags_bench_calloc(CLAGS_BENCH_CHOICES, sizeof(*items));
+  char **argv = clags_bench_calloc(CLAGS_BENCH_TOKENS + 1, sizeof(*argv));
+
+  for (size_t i = 0; i < CLAGS_BENCH_CHOICES; ++i) {
+    snprintf(names[i], sizeof(names[i]), "choice-%zu", i);
+    items[i] = (clags_choice_t){.value = names[i], .description = ""};
+  }
+  uint64_t seed = 0x2545'F491'4F6C'DD1DULL;
+  argv[0] = "bench";
+  for (size_t i = 0; i < CLAGS_BENCH_TOKENS; ++i) {
+    snprintf(tokens[i], sizeof(tokens[i]), "--mode=choice-%zu",
+             clags_bench_next(&seed) % CLAGS_BENCH_CHOICES);
+    argv[i + 1] = tokens[i];
+  }
+
+  clags_choices_t choices = {.items = items, .count = CLAGS_BENCH_CHOICES};
+  clags_choice_t *mode = nullptr;
+  clags_config_t config = {
+      .args = (clags_arg_t[]){{.type = Clags_Option,
+                               .opt = {.long_flag = "mode",
+                                       .value_type = Clags_Choice,
+                                       .choices = &choices,
+                                       .variable = &mode}}},
+      .args_count = 1,
+      .options = {.min_log_level = Clags_NoLogs},
+  };
+  clags_bench_parse("1024 choices, linear", &config, CLAGS_BENCH_TOKENS + 1,
+                    argv, CLAGS_BENCH_ROUNDS, false);
+  clags_choices_build_index(&choices);
+  clags_bench_parse("1024 choices, indexed", &config, CLAGS_BENCH_TOKENS + 1,
+                    argv, CLAGS_BENCH_ROUNDS, false);
+  clags_choices_free_index(&choices);
+
+  free(names);
+  free(tokens);
+  free(items);
+  free(argv);
+}
+
+static void clags_bench_subcmds() {
+  clags_bench_name_t *names = clags_bench_calloc(
+      CLAGS_BENCH_SUBCMD_DEPTH * CLAGS_BENCH_SUBCMD_WIDTH, sizeof(*names));
+  clags_subcmd_t *items = clags_bench_calloc(
+      CLAGS_BENCH_SUBCMD_DEPTH * CLAGS_BENCH_SUBCMD_WIDTH, sizeof(*items));
+  clags_subcmds_t *subcmds =
+      clags_bench_calloc(CLAGS_BENCH_SUBCMD_DEPTH, sizeof(*subcmds));
+  clags_subcmd_t **selected =
+      clags_bench_calloc(CLAGS_BENCH_SUBCMD_DEPTH, sizeof(*selected));
+  clags_arg_t *args =
+      clags_bench_calloc(CLAGS_BENCH_SUBCMD_DEPTH, sizeof(*args));
+  clags_config_t *configs =
+      clags_bench_calloc(CLAGS_BENCH_SUBCMD_DEPTH + 1, sizeof(*configs));
+  char **argv = clags_bench_calloc(CLAGS_BENCH_SUBCMD_DEPTH + 2, sizeof(*argv));
+
+  // every level selects among siblings sharing the config of the next level,
+  // the last level takes a single flag
+  bool verbose = false;
+  configs[CLAGS_BENCH_SUBCMD_DEPTH] = (clags_config_t){
+      .args = (clags_arg_t[]){{.type = Clags_Flag,
+                               .flag = {.short_flag = 'v',
+                                        .variable = &verbose}}},
+      .args_count = 1,
+      .options = {.min_log_level = Clags_NoLogs},
+  };
+  uint64_t seed = 0xD1B5'4A32'D192'ED03ULL;
+  argv[0] = "bench";
+  for (size_t level = 0; level < CLAGS_BENCH_SUBCMD_DEPTH; ++level) {
+    clags_subcmd_t *level_items = &items[level * CLAGS_BENCH_SUBCMD_WIDTH];
+    for (size_t i = 0; i < CLAGS_BENCH_SUBCMD_WIDTH; ++i) {
+      char *name = names[level * CLAGS_BENCH_SUBCMD_WIDTH + i];
+      snprintf(name, CLAGS_BENCH_NAME_SIZE, "level%zu-cmd%zu", level, i);
+      level_items[i] = (clags_subcmd_t){.name = name,
+                                        .description = "",
+                                        .config = &configs[level + 1]};
+    }
+    subcmds[level] = (clags_subcmds_t){.items = level_items,
+                                       .count = CLAGS_BENCH_SUBCMD_WIDTH};
+    args[level] = (clags_arg_t){
+        .type = Clags_Positional,
+        .pos = {.arg_name = "command",
+                .value_type = Clags_Subcmd,
+                .subcmds = &subcmds[level],
+                .variable = &selected[level]},
+    };
+    configs[level] = (clags_config_t){
+        .args = &args[level],
+        .args_count = 1,
+        .options = {.min_log_level = Clags_NoLogs},
+    };
+    size_t pick = clags_bench_next(&seed) % CLAGS_BENCH_SUBCMD_WIDTH;
+    argv[level + 1] = (char *)level_items[pick].name;
+  }
+  argv[CLAGS_BENCH_SUBCMD_DEPTH + 1] = "-v";
+
+  clags_bench_parse("48 nested subcommands", &configs[0],
+                    CLAGS_BENCH_SUBCMD_DEPTH + 2, argv,
+                    CLAGS_BENCH_SUBCMD_ROUNDS, false);
+  clags_bench_parse("48 nested subcommands, compiled", &configs[0],
+                    CLAGS_BENCH_SUBCMD_DEPTH + 2, argv,
+                    CLAGS_BENCH_SUBCMD_ROUNDS, true);
+
+  free(names);
+  free(items);
+  free(subcmds);
+  free(selected);
+  free(args);
+  free(configs);
+  free(argv);
+}
+
+// consumes the elements of a streamed list
+static bool clags_bench_sum(clags_config_t *config, const void *element,
+                            void *data) {
+  (void)config;
+  *(uint64_t *)data += *(const uint64_t *)element;
+  return true;
+}
+
+static void clags_bench_lists() {
+  clags_bench_name_t *tokens =
+      clags_bench_calloc(CLAGS_BENCH_LIST_ITEMS, sizeof(*tokens));
+  char **argv = clags_bench_calloc(CLAGS_BENCH_LIST_ITEMS + 1, sizeof(*argv));
+  argv[0] = "bench";
+  for (size_t i = 0; i < CLAGS_BENCH_LIST_ITEMS; ++i) {
+    snprintf(tokens[i], sizeof(tokens[i]), "%zu", i);
+    argv[i + 1] = tokens[i];
+  }
+
+  clags_list_t strings = clags_string_list();
+  clags_config_t string_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Positional,
+                               .pos = {.arg_name = "items",
+                                       .variable = &strings,
+                                       .is_list = true}}},
+      .args_count = 1,
+      .options = {.min_log_level = Clags_NoLogs},
+  };
+  clags_bench_parse("100000 element string list", &string_config,
+                    CLAGS_BENCH_LIST_ITEMS + 1, argv, CLAGS_BENCH_LIST_ROUNDS,
+                    false);
+
+  // a few hundred tags repeated over the whole list
+  char **tag_argv = clags_bench_calloc(CLAGS_BENCH_LIST_ITEMS + 1,
+                                       sizeof(*tag_argv));
+  tag_argv[0] = "bench";
+  for (size_t i = 0; i < CLAGS_BENCH_LIST_ITEMS; ++i) {
+    tag_argv[i + 1] = tokens[i % CLAGS_BENCH_LIST_TAGS];
+  }
+  string_config.options.duplicate_strings = true;
+  clags_bench_parse("100000 element tag list, duplicated", &string_config,
+                    CLAGS_BENCH_LIST_ITEMS + 1, tag_argv,
+                    CLAGS_BENCH_LIST_ROUNDS, false);
+  string_config.options.intern_strings = true;
+  clags_bench_parse("100000 element tag list, interned", &string_config,
+                    CLAGS_BENCH_LIST_ITEMS + 1, tag_argv,
+                    CLAGS_BENCH_LIST_ROUNDS, false);
+  free(tag_argv);
+
+  clags_list_t numbers = clags_uint64_list();
+  clags_config_t number_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Positional,
+                               .pos = {.arg_name = "items",
+                                       .value_type = Clags_UInt64,
+                                       .variable = &numbers,
+                                       .is_list = true}}},
+      .args_count = 1,
+      .options = {.min_log_level = Clags_NoLogs},
+  };
+  clags_bench_parse("100000 element uint64 list", &number_config,
+                    CLAGS_BENCH_LIST_ITEMS + 1, argv, CLAGS_BENCH_LIST_ROUNDS,
+                    false);
+
+  // decimal fractions, as written by hand or by `%g`
+  clags_bench_name_t *fractions =
+      clags_bench_calloc(CLAGS_BENCH_LIST_ITEMS, sizeof(*fractions));
+  char **fraction_argv =
+      clags_bench_calloc(CLAGS_BENCH_LIST_ITEMS + 1, sizeof(*fraction_argv));
+  fraction_argv[0] = "bench";
+  for (size_t i = 0; i < CLAGS_BENCH_LIST_ITEMS; ++i) {
+    snprintf(fractions[i], sizeof(fractions[i]), "%g", (double)i / 64.0);
+    fraction_argv[i + 1] = fractions[i];
+  }
+  clags_list_t doubles = clags_double_list();
+  clags_config_t double_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Positional,
+                               .pos = {.arg_name = "items",
+                                       .value_type = Clags_Double,
+                                       .variable = &doubles,
+                                       .is_list = true}}},
+      .args_count = 1,
+      .options = {.min_log_level = Clags_NoLogs},
+  };
+  clags_bench_parse("100000 element double list", &double_config,
+                    CLAGS_BENCH_LIST_ITEMS + 1, fraction_argv,
+                    CLAGS_BENCH_LIST_ROUNDS, false);
+  free(fractions);
+  free(fraction_argv);
+
+  uint64_t sum = 0;
+  clags_list_t streamed =
+      clags_streamed_list(sizeof(uint64_t), clags_bench_sum, &sum);
+  number_config.args[0].pos.variable = &streamed;
+  clags_bench_parse("100000 element uint64 list, streamed", &number_config,
+                    CLAGS_BENCH_LIST_ITEMS + 1, argv, CLAGS_BENCH_LIST_ROUNDS,
+                    false);
+
+  free(tokens);
+  free(argv);
+}
+
+static void clags_bench_numbers() {
+  static const char *const formats[] = {
+      "--int=-%zu",           "--uint=%zu",      "--double=%zu.25",
+      "--size=%zuKiB",        "--time=%zuus",
+  };
+  clags_bench_name_t *tokens =
+      clags_bench_calloc(CLAGS_BENCH_TOKENS, sizeof(*tokens));
+  char **argv = clags_bench_calloc(CLAGS_BENCH_TOKENS + 1, sizeof(*argv));
+  uint64_t seed = 0x94D0'49BB'1331'11EBULL;
+  argv[0] = "bench";
+  for (size_t i = 0; i < CLAGS_BENCH_TOKENS; ++i) {
+    size_t pick = clags_bench_next(&seed);
+    snprintf(tokens[i], sizeof(tokens[i]), formats[i % clags_arr_len(formats)],
+             pick % 100'000);
+    argv[i + 1] = tokens[i];
+  }
+
+  int32_t int_value = 0;
+  uint64_t uint_value = 0;
+  double double_value = 0;
+  size_t size_value = 0;
+  clags_time_t time_value = 0;
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "int",
+                       .value_type = Clags_Int32,
+                       .variable = &int_value}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "uint",
+                       .value_type = Clags_UInt64,
+                       .variable = &uint_value}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "double",
+                       .value_type = Clags_Double,
+                       .variable = &double_value}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "size",
+                       .value_type = Clags_Size,
+                       .variable = &size_value}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "time",
+                       .value_type = Clags_TimeNS,
+                       .variable = &time_value}},
+          },
+      .args_count = 5,
+      .options = {.min_log_level = Clags_NoLogs},
+  };
+  clags_bench_parse("numeric options", &config, CLAGS_BENCH_TOKENS + 1, argv,
+                    CLAGS_BENCH_ROUNDS, false);
+
+  free(tokens);
+  free(argv);
+}
+
+// replay fuzzing corpus files with the config and argv splitting of the
+// fuzzing harness
+static void clags_bench_replay(int count, char **paths) {
+  for (int i = 0; i < count; ++i) {
+    FILE *file = fopen(paths[i], "rb");
+    if (file == nullptr) {
+      fprintf(stderr, "Failed to open corpus input '%s'!\n", paths[i]);
+      exit(1);
+    }
+    uint8_t data[CLAGS_FUZZ_MAX_INPUT];
+    size_t size = fread(data, 1, sizeof(data), file);
+    fclose(file);
+
+    char *argv[CLAGS_FUZZ_MAX_ARGV] = {0};
+    int argc = 0;
+    char *buffer = clags_fuzz_split_argv(data, size, argv, &argc);
+    if (buffer == nullptr) {
+      fprintf(stderr, "Out of memory!\n");
+      exit(1);
+    }
+    uint64_t start = clags_bench_now_ns();
+    for (size_t round = 0; round < CLAGS_BENCH_REPLAY_ROUNDS; ++round) {
+      clags_fuzz_parse_argv(argc, argv);
+    }
+    uint64_t ns = clags_bench_now_ns() - start;
+    clags_parse_stats_t stats = {0};
+    clags_stats_attach(&stats);
+    clags_fuzz_parse_argv(argc, argv);
+    clags_stats_attach(nullptr);
+    clags_bench_report(paths[i], argc > 1 ? (size_t)argc - 1 : 1,
+                       CLAGS_BENCH_REPLAY_ROUNDS, ns, &stats);
+    free(buffer);
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1) {
+    clags_bench_replay(argc - 1, argv + 1);
+    return 0;
+  }
+
+  const size_t option_counts[] = {10, 100, 1'000};
+  for (size_t i = 0; i < clags_arr_len(option_counts); ++i) {
+    clags_bench_options(option_counts[i]);
+  }
+  clags_bench_assignments();
+  clags_bench_choices();
+  clags_bench_subcmds();
+  clags_bench_lists();
+  clags_bench_numbers();
+  return 0;
+}
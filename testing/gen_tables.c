@@ -0,0 +1,29 @@
+#include <stdio.h>
+
+#include "clags/clags.h"
+#include "tables_config.h"
+
+// validates the config of tables_config.h with its subcommand configs and
+// writes their generated lookup tables to the given path, failing the build
+// on invalid configs
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: %s <output_header>\n", argc > 0 ? argv[0] : "");
+    return 1;
+  }
+  FILE *out = fopen(argv[1], "w");
+  if (out == nullptr) {
+    perror(argv[1]);
+    return 1;
+  }
+  bool written =
+      clags_write_tables(out, "tables_config_tables", &tables_config);
+  if (fclose(out) != 0 || !written) {
+    fprintf(stderr, "Failed to generate the tables of '%s': %s\n", argv[1],
+            clags_error_description(tables_config.error));
+    remove(argv[1]);
+    return 1;
+  }
+  return 0;
+}
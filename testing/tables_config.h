@@ -0,0 +1,52 @@
+#ifndef CLAGS_TABLES_CONFIG_H
+#define CLAGS_TABLES_CONFIG_H
+
+#include "clags/clags.h"
+
+// a config shared by testing/gen_tables.c, which generates its lookup tables
+// into tables_generated.h at build time, and the tests compiling it from them
+
+static int32_t tables_jobs = 0;
+static const char *tables_output = nullptr;
+static bool tables_verbose = false;
+static bool tables_release = false;
+static clags_subcmd_t *tables_command = nullptr;
+
+static clags_arg_t tables_build_args[] = {
+    {.type = Clags_Flag,
+     .flag = {.short_flag = 'r',
+              .long_flag = "release",
+              .variable = &tables_release,
+              .description = "build in release mode"}},
+};
+static clags_config_t tables_build_config = {
+    .args = tables_build_args,
+    .args_count = clags_arr_len(tables_build_args),
+};
+
+static clags_subcmd_t tables_subcmd_items[] = {
+    {.name = "build", .description = "build", .config = &tables_build_config},
+    {.name = "clean", .description = "remove build outputs"},
+    {.name = "test", .description = "run the tests"},
+};
+static clags_subcmds_t tables_subcmds = clags_subcmds(tables_subcmd_items);
+
+static clags_arg_t tables_args[] = {
+    clags_option('j', "jobs", &tables_jobs, "N", "parallel jobs",
+                 .value_type = Clags_Int32),
+    clags_option('o', "output", &tables_output, "DIR", "output directory",
+                 .value_type = Clags_String),
+    {.type = Clags_Flag,
+     .flag = {.short_flag = 'v',
+              .long_flag = "verbose",
+              .variable = &tables_verbose,
+              .description = "verbose output"}},
+    clags_positional(&tables_command, "command", "the command to run",
+                     .value_type = Clags_Subcmd, .subcmds = &tables_subcmds),
+};
+static clags_config_t tables_config = {
+    .args = tables_args,
+    .args_count = clags_arr_len(tables_args),
+};
+
+#endif // CLAGS_TABLES_CONFIG_H
@@ -1,9 +1,21 @@
+// `setenv` is not part of strict ISO C modes
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif // _DEFAULT_SOURCE
+
 #include <assert.h>
+#include <errno.h>
+#include <locale.h>
 #include <math.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "clags/clags.h"
+#include "tables_config.h"
+#include "tables_generated.h"
 
 clags_options_t global_options = {
     .min_log_level = Clags_NoLogs,
@@ -406,6 +418,2271 @@ void test_duplicate_string_cleanup_clears_name() {
   assert(config.name == nullptr);
 }
 
+// 17. Long options are matched exactly, also when names share a prefix
+void test_long_option_shared_prefix() {
+  char *out = nullptr;
+  char *output = nullptr;
+  bool outline = false;
+
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "output", .variable = &output}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "out", .variable = &out}},
+              {.type = Clags_Flag,
+               .flag = {.long_flag = "outline", .variable = &outline}},
+          },
+      .args_count = 3,
+      .options = global_options,
+  };
+
+  char *argv[] = {"prog", "--output=a", "--out", "b", "--outline"};
+  int argc = 5;
+
+  clags_config_t *parse_result = clags_parse(argc, argv, &config);
+  assert(parse_result == nullptr);
+  assert(output && strcmp(output, "a") == 0);
+  assert(out && strcmp(out, "b") == 0);
+  assert(outline == true);
+
+  char *flag_argv[] = {"prog", "--outline=yes"};
+  parse_result = clags_parse(2, flag_argv, &config);
+  assert(parse_result == &config);
+  assert(config.error == Clags_Error_InvalidOption);
+}
+
+// 18. Duplicate long flags are rejected as invalid config
+void test_duplicate_long_flag_rejected() {
+  char *name = nullptr;
+  bool verbose = false;
+
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "name", .variable = &name}},
+              {.type = Clags_Flag,
+               .flag = {.long_flag = "name", .variable = &verbose}},
+          },
+      .args_count = 2,
+      .options = global_options,
+  };
+
+  char *argv[] = {"prog", "--name", "value"};
+  int argc = 3;
+
+  clags_config_t *parse_result = clags_parse(argc, argv, &config);
+  assert(parse_result == &config);
+  assert(config.error == Clags_Error_InvalidConfig);
+  assert(name == nullptr);
+}
+
+// 19. Combined short flags dispatch to count flags and a trailing option
+void test_combined_short_flags() {
+  size_t verbosity = 0;
+  bool force = false;
+  char *file = nullptr;
+
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v',
+                        .type = Clags_CountFlag,
+                        .variable = &verbosity}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'x', .variable = &force}},
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'f', .variable = &file}},
+          },
+      .args_count = 3,
+      .options = global_options,
+  };
+
+  char *argv[] = {"prog", "-xvvvfout.txt", "-v"};
+  int argc = 3;
+
+  clags_config_t *parse_result = clags_parse(argc, argv, &config);
+  assert(parse_result == nullptr);
+  assert(verbosity == 4);
+  assert(force == true);
+  assert(file && strcmp(file, "out.txt") == 0);
+}
+
+// 20. Duplicate short flags are rejected as invalid config
+void test_duplicate_short_flag_rejected() {
+  bool verbose = false;
+  bool version = false;
+
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v', .variable = &verbose}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v', .variable = &version}},
+          },
+      .args_count = 2,
+      .options = global_options,
+  };
+
+  char *argv[] = {"prog", "-v"};
+  int argc = 2;
+
+  clags_config_t *parse_result = clags_parse(argc, argv, &config);
+  assert(parse_result == &config);
+  assert(config.error == Clags_Error_InvalidConfig);
+  assert(verbose == false && version == false);
+}
+
+// 21. Compiled configs are reused across parses
+void test_compiled_config_reuse() {
+  int32_t num = 0;
+  bool verbose = false;
+
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'n',
+                       .long_flag = "num",
+                       .value_type = Clags_Int32,
+                       .variable = &num}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v', .variable = &verbose}},
+          },
+      .args_count = 2,
+      .options = global_options,
+  };
+
+  char *argv[] = {"prog", "--num=1"};
+  clags_config_t *parse_result = clags_parse_compiled(2, argv, &config);
+  assert(parse_result == &config);
+  assert(config.error == Clags_Error_InvalidConfig);
+
+  assert(clags_compile(&config));
+  assert(config.compiled != nullptr);
+  parse_result = clags_parse_compiled(2, argv, &config);
+  assert(parse_result == nullptr);
+  assert(num == 1);
+
+  char *short_argv[] = {"prog", "-vn", "7"};
+  parse_result = clags_parse_compiled(3, short_argv, &config);
+  assert(parse_result == nullptr);
+  assert(num == 7 && verbose == true);
+
+  clags_config_free(&config);
+  assert(config.compiled != nullptr);
+  clags_config_free_compiled(&config);
+  assert(config.compiled == nullptr);
+}
+
+// 22. Compiling an invalid config fails
+void test_compile_invalid_config() {
+  char *value = nullptr;
+
+  clags_config_t config = {
+      .args = (clags_arg_t[]){{.type = Clags_Option,
+                               .opt = {.long_flag = "a=b",
+                                       .variable = &value}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+
+  assert(!clags_compile(&config));
+  assert(config.compiled == nullptr);
+  assert(config.error == Clags_Error_InvalidConfig);
+}
+
+// 23. Context parses write struct fields and leave the config untouched
+typedef struct {
+  int32_t jobs;
+  bool verbose;
+  char *target;
+  clags_list_t files;
+  clags_subcmd_t *command;
+} context_result_t;
+
+void test_context_parse_offsets() {
+  clags_config_t run_config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'j',
+                       .value_type = Clags_Int32,
+                       .variable = clags_field(context_result_t, jobs)}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v',
+                        .variable = clags_field(context_result_t, verbose)}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "target",
+                       .variable = clags_field(context_result_t, target)}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "files",
+                       .variable = clags_field(context_result_t, files),
+                       .is_list = true,
+                       .optional = true}},
+          },
+      .args_count = 4,
+      .options = {.duplicate_strings = true, .min_log_level = Clags_NoLogs},
+  };
+  clags_subcmd_t subcmds[] = {{.name = "run", .config = &run_config}};
+  clags_subcmds_t subcmd_list = {.items = subcmds, .count = 1};
+  clags_config_t config = {
+      .args = (clags_arg_t[]){{.type = Clags_Positional,
+                               .pos = {.arg_name = "command",
+                                       .value_type = Clags_Subcmd,
+                                       .subcmds = &subcmd_list,
+                                       .variable = clags_field(
+                                           context_result_t, command)}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+  assert(clags_compile(&config));
+  assert(clags_compile(&run_config));
+
+  context_result_t first = {.files = clags_string_list()};
+  context_result_t second = {.files = clags_string_list()};
+  clags_context_t first_context = clags_context(&first);
+  clags_context_t second_context = clags_context(&second);
+
+  char *first_argv[] = {"prog", "run", "-vj", "4", "all", "a.c", "b.c"};
+  char *second_argv[] = {"prog", "run", "lib"};
+  assert(clags_parse_context(7, first_argv, &config, &first_context) ==
+         nullptr);
+  assert(clags_parse_context(3, second_argv, &config, &second_context) ==
+         nullptr);
+
+  assert(first.command == &subcmds[0] && second.command == &subcmds[0]);
+  assert(first.jobs == 4 && first.verbose == true);
+  assert(strcmp(first.target, "all") == 0 && first.target != first_argv[4]);
+  assert(first.files.count == 2);
+  assert(strcmp(clags_list_element(first.files, char *, 1), "b.c") == 0);
+  assert(second.jobs == 0 && second.verbose == false);
+  assert(strcmp(second.target, "lib") == 0 && second.files.count == 0);
+  assert(first_context.config == &run_config);
+  assert(first_context.error == Clags_Error_Ok);
+
+  assert(config.name == nullptr && run_config.name == nullptr);
+  assert(run_config.parent == nullptr && run_config.allocs.count == 0);
+
+  char *bad_argv[] = {"prog", "run", "-j", "x", "all"};
+  assert(clags_parse_context(5, bad_argv, &config, &second_context) ==
+         &run_config);
+  assert(second_context.error == Clags_Error_InvalidValue);
+  assert(run_config.error == Clags_Error_Ok);
+
+  clags_context_free(&first_context, &run_config);
+  clags_context_free(&second_context, &run_config);
+  assert(first.files.items == nullptr && first_context.allocs.count == 0);
+  clags_config_free_compiled(&config);
+  clags_config_free_compiled(&run_config);
+}
+
+// 24. Arena-backed string duplication and list storage
+void test_arena_allocation() {
+  const char *target = nullptr;
+  clags_list_t numbers = clags_int32_list();
+  clags_arena_t arena = {.block_size = 16};
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "target", .variable = &target}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "numbers",
+                       .value_type = Clags_Int32,
+                       .variable = &numbers,
+                       .is_list = true}},
+          },
+      .args_count = 2,
+      .options = {.duplicate_strings = true,
+                  .min_log_level = Clags_NoLogs,
+                  .arena = &arena},
+  };
+
+  char *argv[] = {"prog", "out", "1", "2", "3", "4", "5", "6"};
+  for (int round = 0; round < 2; ++round) {
+    assert(clags_parse(8, argv, &config) == nullptr);
+    assert(strcmp(target, "out") == 0 && target != argv[1]);
+    assert(config.allocs.count == 0);
+    assert(numbers.arena == &arena && numbers.count == 6);
+    for (size_t i = 0; i < numbers.count; ++i) {
+      assert(clags_list_element(numbers, int32_t, i) == (int32_t)i + 1);
+    }
+    clags_config_free(&config);
+    assert(numbers.items == nullptr && numbers.arena == nullptr);
+    clags_arena_reset(&arena);
+    assert(arena.blocks != nullptr);
+  }
+
+  clags_arena_free(&arena);
+  assert(arena.blocks == nullptr);
+}
+
+// 25. Presized lists are allocated once at their exact size
+void test_presize_lists() {
+  clags_list_t includes = clags_string_list();
+  clags_list_t inputs = clags_string_list();
+  clags_list_t numbers = clags_uint32_list();
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'I',
+                       .long_flag = "include",
+                       .variable = &includes,
+                       .is_list = true}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "inputs",
+                       .variable = &inputs,
+                       .is_list = true}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "numbers",
+                       .value_type = Clags_UInt32,
+                       .variable = &numbers,
+                       .is_list = true}},
+          },
+      .args_count = 3,
+      .options = {.presize_lists = true,
+                  .allow_option_parsing_toggle = true,
+                  .min_log_level = Clags_NoLogs,
+                  .ignore_prefix = "!",
+                  .list_terminator = "::"},
+  };
+
+  char *argv[] = {"prog", "a",  "-Iinc", "b", "!skipped", "--include",
+                  "!x",   "lib", "--",   "-c", "--",      "::",
+                  "1",    "2",   "3",    "--include=src"};
+  assert(clags_parse(clags_arr_len(argv), argv, &config) == nullptr);
+  assert(includes.count == 3 && includes.capacity == 3);
+  assert(strcmp(clags_list_element(includes, char *, 1), "lib") == 0);
+  assert(inputs.count == 3 && inputs.capacity == 3);
+  assert(strcmp(clags_list_element(inputs, char *, 2), "-c") == 0);
+  assert(numbers.count == 3 && numbers.capacity == 3);
+  assert(clags_list_element(numbers, uint32_t, 2) == 3);
+
+  clags_config_free(&config);
+}
+
+// 26. Response files expand in place, nest and report cycles
+void test_response_files() {
+  FILE *file = fopen("clags_test_outer.rsp", "w");
+  assert(file != nullptr);
+  fputs("--name 'two words' @clags_test_inner.rsp\n\"a\\\"b\" c\\ d", file);
+  fclose(file);
+  file = fopen("clags_test_inner.rsp", "w");
+  assert(file != nullptr);
+  fputs("-v\n", file);
+  fclose(file);
+  file = fopen("clags_test_cycle.rsp", "w");
+  assert(file != nullptr);
+  fputs("@clags_test_cycle.rsp", file);
+  fclose(file);
+
+  const char *name = nullptr;
+  bool verbose = false;
+  clags_list_t rest = clags_string_list();
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "name", .variable = &name}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v', .variable = &verbose}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "rest", .variable = &rest, .is_list = true}},
+          },
+      .args_count = 3,
+      .options = {.response_files = true, .min_log_level = Clags_NoLogs},
+  };
+
+  char *argv[] = {"prog", "first", "@clags_test_outer.rsp", "--",
+                  "@literal"};
+  assert(clags_parse(5, argv, &config) == nullptr);
+  assert(strcmp(name, "two words") == 0 && verbose);
+  assert(rest.count == 4);
+  assert(strcmp(clags_list_element(rest, char *, 0), "first") == 0);
+  assert(strcmp(clags_list_element(rest, char *, 1), "a\"b") == 0);
+  assert(strcmp(clags_list_element(rest, char *, 2), "c d") == 0);
+  assert(strcmp(clags_list_element(rest, char *, 3), "@literal") == 0);
+  assert(config.mappings.count == 2);
+  clags_config_free(&config);
+  assert(config.mappings.count == 0 && rest.count == 0);
+
+  char *cycle_argv[] = {"prog", "@clags_test_cycle.rsp"};
+  assert(clags_parse(2, cycle_argv, &config) == &config);
+  assert(config.error == Clags_Error_InvalidResponseFile);
+  char *missing_argv[] = {"prog", "@clags_test_missing.rsp"};
+  assert(clags_parse(2, missing_argv, &config) == &config);
+  assert(config.error == Clags_Error_InvalidResponseFile);
+  clags_config_free(&config);
+  assert(config.mappings.count == 0);
+
+  remove("clags_test_outer.rsp");
+  remove("clags_test_inner.rsp");
+  remove("clags_test_cycle.rsp");
+}
+
+// 27. Incremental parsing accepts one token at a time
+void test_incremental_parser() {
+  int32_t level = 0;
+  const char *output = nullptr;
+  bool force = false;
+  clags_config_t child = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'l',
+                       .value_type = Clags_Int32,
+                       .variable = &level}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'f', .variable = &force}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "output", .variable = &output}},
+          },
+      .args_count = 3,
+      .options = global_options,
+  };
+  clags_subcmd_t *selected = nullptr;
+  clags_subcmd_t subcmds[] = {{.name = "build", .config = &child}};
+  clags_subcmds_t subcmd_list = {.items = subcmds, .count = 1};
+  clags_config_t config = {
+      .args = (clags_arg_t[]){{.type = Clags_Positional,
+                               .pos = {.arg_name = "command",
+                                       .value_type = Clags_Subcmd,
+                                       .subcmds = &subcmd_list,
+                                       .variable = &selected}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+
+  clags_parser_t parser;
+  const char *tokens[] = {"build", "-fl", "3", "out"};
+  assert(clags_parser_begin(&parser, "prog", &config, nullptr) == nullptr);
+  for (size_t i = 0; i < clags_arr_len(tokens); ++i) {
+    assert(clags_parser_feed(&parser, tokens[i]) == nullptr);
+  }
+  assert(clags_parser_end(&parser) == nullptr);
+  assert(selected == &subcmds[0] && child.parent == &config);
+  assert(level == 3 && force && strcmp(output, "out") == 0);
+  assert(strcmp(child.name, "build") == 0);
+
+  // the first offending token is rejected, the rest is ignored
+  assert(clags_parser_begin(&parser, "prog", &config, nullptr) == nullptr);
+  assert(clags_parser_feed(&parser, "build") == nullptr);
+  assert(clags_parser_feed(&parser, "-l") == nullptr);
+  assert(clags_parser_feed(&parser, "high") == &child);
+  assert(child.error == Clags_Error_InvalidValue);
+  assert(clags_parser_feed(&parser, "out") == &child);
+  assert(clags_parser_end(&parser) == &child);
+
+  // an option still waiting for its value fails at the end
+  assert(clags_parser_begin(&parser, "prog", &config, nullptr) == nullptr);
+  assert(clags_parser_feed(&parser, "build") == nullptr);
+  assert(clags_parser_feed(&parser, "out") == nullptr);
+  assert(clags_parser_feed(&parser, "-l") == nullptr);
+  assert(clags_parser_end(&parser) == &child);
+  assert(child.error == Clags_Error_InvalidOption);
+}
+
+// 28. Integer, size and time parsing handles bases, limits and units
+void test_numeric_parsing_edge_cases() {
+  clags_config_t config = {.options = global_options};
+  int8_t i8 = 0;
+  int64_t i64 = 0;
+  uint32_t u32 = 0;
+  uint64_t u64 = 0;
+  clags_fsize_t size = 0;
+  clags_time_t time = 0;
+
+  assert(clags__verify_int8(&config, "n", "-128", &i8, nullptr) && i8 == -128);
+  assert(!clags__verify_int8(&config, "n", "128", &i8, nullptr));
+  assert(clags__verify_int8(&config, "n", " 0x7f", &i8, nullptr) && i8 == 127);
+  assert(clags__verify_int8(&config, "n", "-010", &i8, nullptr) && i8 == -8);
+  assert(!clags__verify_int8(&config, "n", "08", &i8, nullptr));
+  assert(!clags__verify_int8(&config, "n", "0x", &i8, nullptr));
+  assert(clags__verify_int64(&config, "n", "-9223372036854775808", &i64,
+                             nullptr) &&
+         i64 == INT64_MIN);
+  assert(!clags__verify_int64(&config, "n", "9223372036854775808", &i64,
+                              nullptr));
+  assert(clags__verify_uint64(&config, "n", "18446744073709551615", &u64,
+                              nullptr) &&
+         u64 == UINT64_MAX);
+  assert(!clags__verify_uint64(&config, "n", "18446744073709551616", &u64,
+                               nullptr));
+  assert(!clags__verify_uint32(&config, "n", "+1", &u32, nullptr));
+  assert(!clags__verify_uint32(&config, "n", "4294967296", &u32, nullptr));
+  assert(!clags__verify_uint32(&config, "n", "12a", &u32, nullptr));
+
+  assert(clags__verify_size(&config, "s", "4KiB", &size, nullptr) &&
+         size == 4096);
+  assert(clags__verify_size(&config, "s", "3gb", &size, nullptr) &&
+         size == 3000000000ULL);
+  assert(clags__verify_size(&config, "s", "7B", &size, nullptr) && size == 7);
+  assert(!clags__verify_size(&config, "s", "7b", &size, nullptr));
+  assert(!clags__verify_size(&config, "s", "1KiBs", &size, nullptr));
+  assert(!clags__verify_size(&config, "s", "17179869184GiB", &size, nullptr));
+  assert(!clags__verify_size(&config, "s", "-1", &size, nullptr));
+
+  assert(clags__verify_time_s(&config, "t", "2H", &time, nullptr) &&
+         time == 7200);
+  assert(clags__verify_time_s(&config, "t", "1.5m", &time, nullptr) &&
+         time == 90);
+  assert(!clags__verify_time_s(&config, "t", "5ms", &time, nullptr));
+  assert(clags__verify_time_ns(&config, "t", "5ms", &time, nullptr) &&
+         time == 5000000);
+  assert(clags__verify_time_ns(&config, "t", "3us", &time, nullptr) &&
+         time == 3000);
+  assert(clags__verify_time_ns(&config, "t", "1d", &time, nullptr) &&
+         time == 86400000000000ULL);
+  assert(!clags__verify_time_ns(&config, "t", "-2s", &time, nullptr));
+  assert(!clags__verify_time_ns(&config, "t", "1000000d", &time, nullptr));
+}
+
+// 29. Hash indexed choices match like the linear scan
+void test_choice_hash_index() {
+  enum { CHOICE_COUNT = 600 };
+  static char names[CHOICE_COUNT][16];
+  static clags_choice_t values[CHOICE_COUNT + 1];
+  for (size_t i = 0; i < CHOICE_COUNT; ++i) {
+    snprintf(names[i], sizeof(names[i]), "Codec-%zu", i);
+    values[i] = (clags_choice_t){.value = names[i]};
+  }
+  values[CHOICE_COUNT] = (clags_choice_t){.value = "codec-7"};
+
+  for (int mode = 0; mode < 2; ++mode) {
+    clags_choices_t choices = {.items = values,
+                               .count = CHOICE_COUNT + 1,
+                               .case_insensitive = mode == 1};
+    clags_choices_build_index(&choices);
+    assert(choices.hash_slots != nullptr);
+    clags_choice_t *choice = nullptr;
+    clags_list_t selected = clags_choice_list();
+    clags_config_t config = {
+        .args = (clags_arg_t[]){{.type = Clags_Option,
+                                 .opt = {.long_flag = "codec",
+                                         .value_type = Clags_Choice,
+                                         .choices = &choices,
+                                         .variable = &selected,
+                                         .is_list = true}}},
+        .args_count = 1,
+        .options = global_options,
+    };
+    char *argv[] = {"prog", "--codec=Codec-599", "--codec", "codec-7"};
+    assert(clags_parse(4, argv, &config) == nullptr);
+    choice = clags_list_element(selected, clags_choice_t *, 0);
+    assert(clags_choice_index(&choices, choice) == 599);
+    choice = clags_list_element(selected, clags_choice_t *, 1);
+    assert(clags_choice_index(&choices, choice) ==
+           (mode == 1 ? 7 : CHOICE_COUNT));
+
+    char *bad_argv[] = {"prog", "--codec", mode == 1 ? "codec-600" : "CODEC-1"};
+    assert(clags_parse(3, bad_argv, &config) == &config);
+    assert(config.error == Clags_Error_InvalidValue);
+    clags_config_free(&config);
+    clags_choices_free_index(&choices);
+    assert(choices.hash_slots == nullptr);
+  }
+
+  clags_choices_t choices = {.items = values, .count = CHOICE_COUNT};
+  clags_choice_t outside = {0};
+  assert(clags_choice_index(&choices, &values[CHOICE_COUNT]) == -1);
+  assert(clags_choice_index(&choices, &outside) == -1);
+}
+
+// 30. Deferred path checks run batched and report the first failure
+static char deferred_path_error[256];
+
+void record_first_error(clags_log_level_t level, const char *format,
+                        va_list args) {
+  if (level == Clags_Error && deferred_path_error[0] == '\0')
+    vsnprintf(deferred_path_error, sizeof(deferred_path_error), format, args);
+}
+
+void test_deferred_path_checks() {
+  enum { PATH_COUNT = 200 };
+  const char *dir = nullptr;
+  clags_list_t files = clags_file_list();
+  clags_list_t stats = clags_path_stat_list();
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "dir",
+                       .value_type = Clags_Dir,
+                       .variable = &dir}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "files",
+                       .value_type = Clags_File,
+                       .variable = &files,
+                       .is_list = true}},
+          },
+      .args_count = 2,
+      .options = {.defer_path_checks = true,
+                  .path_stats = &stats,
+                  .min_log_level = Clags_NoLogs},
+  };
+
+  char *argv[PATH_COUNT + 3] = {"prog", "--dir", "testing"};
+  for (size_t i = 0; i < PATH_COUNT; ++i) {
+    argv[i + 3] = i % 2 ? "testing/tests.c" : "include/clags/clags.h";
+  }
+  assert(clags_parse(PATH_COUNT + 3, argv, &config) == nullptr);
+  assert(strcmp(dir, "testing") == 0 && files.count == PATH_COUNT);
+  assert(stats.count == PATH_COUNT + 1);
+  clags_path_stat_t *first = &clags_list_element(stats, clags_path_stat_t, 0);
+  clags_path_stat_t *last =
+      &clags_list_element(stats, clags_path_stat_t, PATH_COUNT);
+  assert(strcmp(first->path, "testing") == 0 && S_ISDIR(first->attr.st_mode));
+  assert(strcmp(last->path, "testing/tests.c") == 0 &&
+         S_ISREG(last->attr.st_mode));
+  clags_config_free(&config);
+  clags_list_free(&stats);
+
+  // a missing file fails before a later non-file value
+  argv[120] = "testing/missing.c";
+  argv[150] = "testing";
+  config.options.min_log_level = Clags_Error;
+  config.options.log_handler = record_first_error;
+  assert(clags_parse(PATH_COUNT + 3, argv, &config) == &config);
+  assert(config.error == Clags_Error_InvalidValue);
+  assert(strstr(deferred_path_error, "testing/missing.c") != nullptr);
+  assert(stats.count == 0);
+  clags_config_free(&config);
+}
+
+// 31. Subcommand dispatch index and lazy compilation of the selected path
+void test_subcmd_dispatch_index() {
+  const char *file = nullptr;
+  bool force = false;
+  clags_subcmd_t *tool = nullptr;
+  clags_subcmd_t *action = nullptr;
+
+  clags_config_t add_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Positional,
+                               .pos = {.arg_name = "file", .variable = &file}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+  clags_config_t rm_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Flag,
+                               .flag = {.short_flag = 'f',
+                                        .long_flag = "force",
+                                        .variable = &force}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+  clags_subcmd_t git_items[] = {
+      {.name = "add", .config = &add_config},
+      {.name = "rm", .config = &rm_config},
+  };
+  clags_subcmds_t git_subcmds = clags_subcmds(git_items);
+  clags_config_t git_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Positional,
+                               .pos = {.arg_name = "action",
+                                       .value_type = Clags_Subcmd,
+                                       .subcmds = &git_subcmds,
+                                       .variable = &action}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+
+  // many siblings, one of which a broken config that is never selected
+  clags_config_t broken_config = {
+      .args = (clags_arg_t[]){
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'x', .variable = &force}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'x', .variable = &force}},
+          },
+      .args_count = 2,
+      .options = global_options,
+  };
+  char names[64][8] = {0};
+  clags_subcmd_t tool_items[65] = {0};
+  for (size_t i = 0; i < 64; ++i) {
+    snprintf(names[i], sizeof(names[i]), "tool%zu", i);
+    tool_items[i] =
+        (clags_subcmd_t){.name = names[i], .config = &broken_config};
+  }
+  tool_items[64] = (clags_subcmd_t){.name = "git", .config = &git_config};
+  clags_subcmds_t tool_subcmds = clags_subcmds(tool_items);
+  clags_config_t config = {
+      .args = (clags_arg_t[]){{.type = Clags_Positional,
+                               .pos = {.arg_name = "tool",
+                                       .value_type = Clags_Subcmd,
+                                       .subcmds = &tool_subcmds,
+                                       .variable = &tool}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+  assert(clags_compile(&config));
+  assert(config.compiled->subcmd_slots != nullptr);
+  assert(git_config.compiled == nullptr);
+
+  char *argv[] = {"prog", "git", "add", "a.txt"};
+  assert(clags_parse(4, argv, &config) == nullptr);
+  assert(tool == &tool_items[64] && action == &git_items[0]);
+  assert(strcmp(file, "a.txt") == 0);
+  assert(clags_subcmd_index(&tool_subcmds, tool) == 64);
+  assert(clags_subcmd_index(&git_subcmds, &git_items[1] + 1) == -1);
+
+  // only the selected path is compiled, siblings stay untouched
+  assert(git_config.compiled_lazily && git_config.compiled != nullptr);
+  assert(add_config.compiled_lazily && add_config.compiled != nullptr);
+  assert(rm_config.compiled == nullptr);
+  assert(broken_config.compiled == nullptr && !broken_config.invalid);
+
+  char *rm_argv[] = {"prog", "git", "rm", "-f"};
+  assert(clags_parse(4, rm_argv, &config) == nullptr);
+  assert(action == &git_items[1] && force);
+  assert(rm_config.compiled != nullptr);
+
+  char *unknown_argv[] = {"prog", "git", "mv"};
+  assert(clags_parse(3, unknown_argv, &config) == &git_config);
+  assert(git_config.error == Clags_Error_InvalidValue);
+
+  // freeing a config frees the tables compiled below it, and a context parse
+  // leaves uncompiled configs untouched
+  clags_config_free_compiled(&git_config);
+  assert(add_config.compiled == nullptr && rm_config.compiled == nullptr);
+  clags_context_t context = clags_context(nullptr);
+  assert(clags_parse_context(4, argv, &config, &context) == nullptr);
+  assert(context.config == &add_config && git_config.compiled == nullptr);
+  clags_context_free(&context, &add_config);
+
+  char *broken_argv[] = {"prog", "tool7"};
+  assert(clags_parse(2, broken_argv, &config) == &broken_config);
+  assert(broken_config.error == Clags_Error_InvalidConfig);
+  assert(broken_config.compiled == nullptr);
+
+  assert(clags_parse(4, argv, &config) == nullptr);
+  assert(add_config.compiled != nullptr);
+  clags_config_free_compiled(&config);
+  assert(git_config.compiled == nullptr && add_config.compiled == nullptr);
+  assert(!git_config.compiled_lazily && !add_config.compiled_lazily);
+}
+
+// 32. Tables generated at build time by testing/gen_tables.c
+void test_generated_tables() {
+  tables_config.options = global_options;
+  tables_build_config.options = global_options;
+  assert(clags_compile_tables(&tables_config, &tables_config_tables));
+  assert(tables_config.compiled->long_count == 3);
+  assert(tables_config.compiled->subcmd_slots != nullptr);
+  // the subcommand configs are compiled from their tables up front
+  assert(tables_build_config.compiled != nullptr);
+  assert(tables_build_config.compiled->long_count == 1);
+
+  char *argv[] = {"prog", "-vj", "4", "--output=out", "build", "--release"};
+  assert(clags_parse(6, argv, &tables_config) == nullptr);
+  assert(tables_jobs == 4 && tables_verbose && tables_release);
+  assert(strcmp(tables_output, "out") == 0);
+  assert(tables_command == &tables_subcmd_items[0]);
+  assert(tables_build_config.compiled_lazily);
+  clags_config_free_compiled(&tables_config);
+  assert(tables_build_config.compiled == nullptr);
+
+  // the generator writes the tables compiled into the tests
+  char text[4096] = {0};
+  FILE *out = tmpfile();
+  assert(out != nullptr);
+  assert(clags_write_tables(out, "tables_config_tables", &tables_config));
+  rewind(out);
+  assert(fread(text, 1, sizeof(text) - 1, out) > 0);
+  assert(fclose(out) == 0);
+  assert(strstr(text, "static const clags_tables_t tables_config_tables"));
+  assert(strstr(text, "{\"verbose\", 7, 2},"));
+  assert(strstr(text, "static const clags_tables_t tables_config_tables_0"));
+  assert(strstr(text, "{&tables_config_tables_0, nullptr, nullptr}"));
+
+  // stale tables are rejected
+  clags_tables_t stale = tables_config_tables;
+  stale.fingerprint ^= 1;
+  assert(!clags_compile_tables(&tables_config, &stale));
+  assert(tables_config.compiled == nullptr);
+  assert(tables_config.error == Clags_Error_InvalidConfig);
+  tables_args[1].opt.short_flag = 'O';
+  assert(!clags_compile_tables(&tables_config, &tables_config_tables));
+
+  // config errors fail the generation before anything is written
+  tables_args[1].opt.short_flag = 'j';
+  out = tmpfile();
+  assert(out != nullptr);
+  assert(!clags_write_tables(out, "tables_config_tables", &tables_config));
+  assert(tables_config.error == Clags_Error_InvalidConfig);
+  assert(ftell(out) == 0);
+  assert(fclose(out) == 0);
+  tables_args[1].opt.short_flag = 'o';
+  tables_config.invalid = false;
+
+  // so do errors in subcommand configs
+  tables_build_args[0].flag.short_flag = 'v';
+  tables_build_args[0].flag.long_flag = "verbose";
+  clags_arg_t duplicated[] = {tables_build_args[0], tables_build_args[0]};
+  clags_config_t child = {
+      .args = duplicated,
+      .args_count = 2,
+      .options = global_options,
+  };
+  tables_subcmd_items[1].config = &child;
+  tables_build_args[0].flag.short_flag = 'r';
+  tables_build_args[0].flag.long_flag = "release";
+  out = tmpfile();
+  assert(out != nullptr);
+  assert(!clags_write_tables(out, "tables_config_tables", &tables_config));
+  assert(tables_config.error == Clags_Error_InvalidConfig && child.invalid);
+  assert(ftell(out) == 0);
+  assert(fclose(out) == 0);
+  tables_subcmd_items[1].config = nullptr;
+}
+
+// 33. Usage rendered into a string builder
+void test_usage_sb() {
+  int jobs = 0;
+  bool verbose = false;
+  const char *target = nullptr;
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "target",
+                       .description = "what to build",
+                       .variable = &target}},
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'j',
+                       .long_flag = "jobs",
+                       .arg_name = "N",
+                       .description = "parallel jobs",
+                       .value_type = Clags_Int32,
+                       .variable = &jobs}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v',
+                        .long_flag = "verbose",
+                        .description = "verbose output",
+                        .variable = &verbose}},
+          },
+      .args_count = 3,
+      .options = global_options,
+  };
+  const char *expected =
+      "Usage: prog [OPTIONS] [FLAGS] <target>\n"
+      "  Arguments:\n"
+      "    target                           : what to build\n"
+      "  Options:\n"
+      "    -j, --jobs(=)N                   : parallel jobs (int32)\n"
+      "  Flags:\n"
+      "    -v, --verbose                    : verbose output\n";
+
+  clags_sb_t sb = {0};
+  clags_usage_sb("prog", &config, &sb);
+  assert(sb.count == strlen(expected));
+  assert(memcmp(sb.items, expected, sb.count) == 0);
+
+  // the usage is appended, and the compiled tables render the same text
+  assert(clags_compile(&config));
+  clags_usage_sb("prog", &config, &sb);
+  clags_sb_append_null(&sb);
+  assert(sb.count == 2 * strlen(expected) + 1);
+  assert(strcmp(sb.items + strlen(expected), expected) == 0);
+  clags_config_free_compiled(&config);
+
+  config.invalid = true;
+  size_t count = sb.count;
+  clags_usage_sb("prog", &config, &sb);
+  assert(sb.count == count);
+  clags_sb_free(&sb);
+}
+
+// 34. Cached usage, rendered again when its key changes
+void test_cached_usage() {
+  bool verbose = false;
+  clags_choice_t *level = nullptr;
+  clags_choice_t levels[] = {{.value = "low"}, {.value = "high"}};
+  clags_choices_t choices = {.items = levels, .count = 2};
+  clags_config_t config = {
+      .args = (clags_arg_t[]){{.type = Clags_Flag,
+                               .flag = {.short_flag = 'v',
+                                        .long_flag = "verbose",
+                                        .variable = &verbose}},
+                              {.type = Clags_Option,
+                               .opt = {.long_flag = "level",
+                                       .arg_name = "LEVEL",
+                                       .variable = &level,
+                                       .value_type = Clags_Choice,
+                                       .choices = &choices}}},
+      .args_count = 2,
+      .options = global_options,
+  };
+  config.options.cache_usage = true;
+
+  clags_sb_t first = {0};
+  clags_usage_sb("prog", &config, &first);
+  assert(config.usage.count == first.count && config.usage_key != 0);
+  char *cached = config.usage.items;
+
+  // the same key reuses the cached text
+  clags_sb_t second = {0};
+  clags_usage_sb("prog", &config, &second);
+  assert(config.usage.items == cached);
+  assert(second.count == first.count);
+  assert(memcmp(first.items, second.items, first.count) == 0);
+
+  // a different program name or changed flags render it again
+  uint64_t key = config.usage_key;
+  clags_sb_t renamed = {0};
+  clags_usage_sb("other", &config, &renamed);
+  assert(config.usage_key != key);
+  assert(memcmp(renamed.items, "Usage: other", 12) == 0);
+  config.args[0].flag.long_flag = "loud";
+  clags_sb_t changed = {0};
+  clags_usage_sb("other", &config, &changed);
+  clags_sb_append_null(&changed);
+  assert(strstr(changed.items, "-v, --loud ") != nullptr);
+
+  // so do argument names, descriptions and choices
+  config.args[1].opt.arg_name = "TIER";
+  config.args[0].flag.description = "be loud";
+  levels[1].value = "max";
+  clags_sb_t edited = {0};
+  clags_usage_sb("other", &config, &edited);
+  clags_sb_append_null(&edited);
+  assert(strstr(edited.items, "TIER") != nullptr);
+  assert(strstr(edited.items, "be loud") != nullptr);
+  assert(strstr(edited.items, "max") != nullptr);
+
+  clags_config_free(&config);
+  assert(config.usage.items == nullptr && config.usage.count == 0);
+  clags_sb_free(&first);
+  clags_sb_free(&second);
+  clags_sb_free(&renamed);
+  clags_sb_free(&changed);
+  clags_sb_free(&edited);
+}
+
+void expect_error_record(clags_config_t *config, int argc, char **argv,
+                         clags_error_t error, size_t index,
+                         const char *arg_name, const char *token) {
+  assert(clags_parse(argc, argv, config) == config);
+  clags_error_record_t record = config->error_record;
+  assert(record.error == error && config->error == error);
+  assert(record.index == index);
+  assert(arg_name ? strcmp(record.arg_name, arg_name) == 0
+                  : record.arg_name == nullptr);
+  assert(token ? record.token_length == strlen(token) &&
+                     strncmp(record.token, token, record.token_length) == 0
+               : record.token == nullptr);
+}
+
+// 35. Structured error records, formatted on demand
+void test_error_records() {
+  int jobs = 0;
+  bool verbose = false;
+  const char *target = nullptr;
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'j',
+                       .long_flag = "jobs",
+                       .value_type = Clags_Int32,
+                       .variable = &jobs}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v', .variable = &verbose}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "target", .variable = &target}},
+          },
+      .args_count = 3,
+      .options = global_options,
+  };
+
+  expect_error_record(&config, 3, (char *[]){"prog", "x", "--jobs=4x"},
+                      Clags_Error_InvalidValue, 2, "jobs", "4x");
+  assert(config.error_record.expected == Clags_Int32);
+  expect_error_record(&config, 3, (char *[]){"prog", "-vj", "?"},
+                      Clags_Error_InvalidValue, 2, "jobs", "?");
+  expect_error_record(&config, 3, (char *[]){"prog", "--job=1", "x"},
+                      Clags_Error_InvalidOption, 1, nullptr, "job");
+  expect_error_record(&config, 2, (char *[]){"prog", "-vq"},
+                      Clags_Error_InvalidOption, 1, nullptr, "q");
+  expect_error_record(&config, 3, (char *[]){"prog", "x", "--jobs"},
+                      Clags_Error_InvalidOption, 2, "jobs", nullptr);
+  expect_error_record(&config, 3, (char *[]){"prog", "x", "y"},
+                      Clags_Error_TooManyArguments, 2, nullptr, "y");
+  expect_error_record(&config, 2, (char *[]){"prog", "-v"},
+                      Clags_Error_TooFewArguments, 0, "target", nullptr);
+
+  clags_sb_t sb = {0};
+  assert(clags_parse(3, (char *[]){"prog", "x", "-j4x"}, &config) == &config);
+  clags_error_message(&config.error_record, &sb);
+  clags_sb_append_null(&sb);
+  assert(strcmp(sb.items, "argument value does not match expected type or "
+                          "criteria: '4x' for 'jobs', expected int32 "
+                          "(argument 2)") == 0);
+  clags_sb_free(&sb);
+
+  // a successful parse resets the record
+  assert(clags_parse(2, (char *[]){"prog", "x"}, &config) == nullptr);
+  assert(config.error_record.error == Clags_Error_Ok);
+  assert(config.error_record.token == nullptr);
+
+  // contexts and incremental parses receive the record instead
+  clags_context_t context = clags_context(nullptr);
+  assert(clags_parse_context(3, (char *[]){"prog", "x", "--jobs=z"}, &config,
+                             &context) == &config);
+  assert(context.error_record.index == 2);
+  assert(context.error_record.token[0] == 'z');
+  assert(config.error_record.error == Clags_Error_Ok);
+  clags_context_free(&context, nullptr);
+
+  clags_parser_t parser;
+  assert(clags_parser_begin(&parser, "prog", &config, nullptr) == nullptr);
+  assert(clags_parser_feed(&parser, "x") == nullptr);
+  assert(clags_parser_feed(&parser, "-j") == nullptr);
+  assert(clags_parser_end(&parser) == &config);
+  assert(config.error_record.index == 2);
+  assert(strcmp(config.error_record.arg_name, "jobs") == 0);
+}
+
+// 36. Parse instrumentation, counted only with `CLAGS_STATS` enabled
+void test_parse_stats() {
+  clags_list_t numbers = clags_int32_list();
+  clags_subcmd_t *command = nullptr;
+  bool verbose = false;
+
+  clags_config_t run_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Flag,
+                               .flag = {.short_flag = 'v',
+                                        .variable = &verbose}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+  clags_subcmd_t items[] = {{.name = "run", .config = &run_config}};
+  clags_subcmds_t subcmds = clags_subcmds(items);
+  clags_config_t config = {
+      .args = (clags_arg_t[]){
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "command",
+                       .value_type = Clags_Subcmd,
+                       .subcmds = &subcmds,
+                       .variable = &command}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "number",
+                       .value_type = Clags_Int32,
+                       .variable = &numbers,
+                       .is_list = true}},
+          },
+      .args_count = 2,
+      .options = global_options,
+  };
+  config.options.duplicate_strings = true;
+
+  clags_parse_stats_t stats = {0};
+  clags_stats_attach(&stats);
+  char *argv[] = {"prog", "--number=1", "--number=2", "--number=3",
+                  "run",  "-v"};
+  assert(clags_parse(clags_arr_len(argv), argv, &config) == nullptr);
+  clags_stats_attach(nullptr);
+  assert(command == &items[0] && verbose && numbers.count == 3);
+
+#if CLAGS_STATS
+  assert(stats.parses == 1);
+  assert(stats.validations == 2 && stats.sorts == 2);
+  assert(stats.verifier_calls[Clags_Int32] == 3);
+  assert(stats.verifier_calls[Clags_Subcmd] == 1);
+  assert(stats.verifier_calls[Clags_Bool] == 0);
+  assert(stats.list_reallocs >= 1);
+  assert(stats.strings_duplicated >= 1);
+  assert(stats.bytes_duplicated >= strlen("prog") + 1);
+  assert(stats.subcmd_descents == 1 && stats.max_subcmd_depth == 1);
+#else
+  clags_parse_stats_t empty = {0};
+  assert(memcmp(&stats, &empty, sizeof(stats)) == 0);
+#endif // CLAGS_STATS
+
+  // detached stats are left untouched
+  clags_parse_stats_t before = stats;
+  clags_list_free(&numbers);
+  assert(clags_parse(clags_arr_len(argv), argv, &config) == nullptr);
+  assert(memcmp(&stats, &before, sizeof(stats)) == 0);
+
+  clags_list_free(&numbers);
+  clags_config_free(&config);
+  clags_config_free(&run_config);
+}
+
+// 37. Environment variable fallback below argv
+void test_env_fallback() {
+  int32_t threads = 0;
+  const char *name = nullptr;
+  clags_list_t tags = clags_string_list();
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "threads",
+                       .value_type = Clags_Int32,
+                       .variable = &threads,
+                       .env = "CLAGS_TEST_THREADS"}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "name",
+                       .variable = &name,
+                       .env = "CLAGS_TEST_NAME"}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "tag",
+                       .variable = &tags,
+                       .is_list = true,
+                       .env = "CLAGS_TEST_TAGS"}},
+          },
+      .args_count = 3,
+      .options = global_options,
+  };
+  assert(setenv("CLAGS_TEST_THREADS", "4", 1) == 0);
+  assert(setenv("CLAGS_TEST_NAME", "env-name", 1) == 0);
+  assert(setenv("CLAGS_TEST_TAGS", "env-tag", 1) == 0);
+
+  // the environment fills in what argv does not give, without copies
+  char *bare[] = {"prog"};
+  assert(clags_parse(1, bare, &config) == nullptr);
+  assert(threads == 4 && strcmp(name, "env-name") == 0);
+  assert(name == getenv("CLAGS_TEST_NAME"));
+  assert(tags.count == 1 && strcmp(((char **)tags.items)[0], "env-tag") == 0);
+  clags_list_free(&tags);
+
+  // argv takes precedence, also over list values
+  char *given[] = {"prog", "--tag=a", "--threads=8", "--tag=b"};
+  assert(clags_parse(4, given, &config) == nullptr);
+  assert(threads == 8 && strcmp(name, "env-name") == 0);
+  assert(tags.count == 2 && strcmp(((char **)tags.items)[0], "a") == 0);
+  clags_list_free(&tags);
+
+  // values are copied only if strings are duplicated
+  config.options.duplicate_strings = true;
+  assert(clags_parse(1, bare, &config) == nullptr);
+  assert(strcmp(name, "env-name") == 0 && name != getenv("CLAGS_TEST_NAME"));
+  clags_config_free(&config);
+  config.options.duplicate_strings = false;
+
+  // invalid values are reported like argv values, without an argv index
+  assert(setenv("CLAGS_TEST_THREADS", "many", 1) == 0);
+  assert(clags_parse(1, bare, &config) == &config);
+  assert(config.error == Clags_Error_InvalidValue);
+  assert(config.error_record.index == 0);
+  assert(strcmp(config.error_record.arg_name, "threads") == 0);
+  assert(strcmp(config.error_record.token, "many") == 0);
+  clags_list_free(&tags);
+
+  // empty variables count as unset
+  threads = 0;
+  assert(setenv("CLAGS_TEST_THREADS", "", 1) == 0);
+  assert(clags_parse(1, bare, &config) == nullptr && threads == 0);
+  clags_list_free(&tags);
+
+  clags_sb_t usage = {0};
+  clags_usage_sb("prog", &config, &usage);
+  clags_sb_append_null(&usage);
+  assert(strstr(usage.items, "[env: CLAGS_TEST_THREADS]") != nullptr);
+  clags_sb_free(&usage);
+  clags_config_free(&config);
+
+  // a variable may be bound to one option only
+  config.args[1].opt.env = "CLAGS_TEST_THREADS";
+  assert(clags_parse(1, bare, &config) == &config);
+  assert(config.error == Clags_Error_InvalidConfig);
+
+  assert(unsetenv("CLAGS_TEST_THREADS") == 0);
+  assert(unsetenv("CLAGS_TEST_NAME") == 0);
+  assert(unsetenv("CLAGS_TEST_TAGS") == 0);
+}
+
+// 38. Config files, layered below the environment and argv
+void test_config_file() {
+  FILE *file = fopen("clags_test_config.ini", "w");
+  assert(file != nullptr);
+  fputs("# service defaults\n"
+        "jobs = 2\n"
+        "name = \" padded \"\n"
+        "tag = file-a\n"
+        "tag = file-b\n"
+        "verbose = true\r\n"
+        "\n"
+        "[run]\n"
+        "; the subcommand's own keys\n"
+        "level=3\n"
+        "[run.fast]\n"
+        "level=7\n",
+        file);
+  fclose(file);
+  file = fopen("clags_test_broken.ini", "w");
+  assert(file != nullptr);
+  fputs("jobs = 2\njobs\n", file);
+  fclose(file);
+  // sections name the whole subcommand path
+  file = fopen("clags_test_section.ini", "w");
+  assert(file != nullptr);
+  fputs("jobs = 2\n[fast]\nlevel = 1\n", file);
+  fclose(file);
+
+  int32_t jobs = 0;
+  int32_t level = 0;
+  int32_t fast_level = 0;
+  const char *name = nullptr;
+  bool verbose = false;
+  clags_list_t tags = clags_string_list();
+  clags_subcmd_t *command = nullptr;
+  clags_subcmd_t *mode = nullptr;
+  clags_config_t fast_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Option,
+                               .opt = {.long_flag = "level",
+                                       .value_type = Clags_Int32,
+                                       .variable = &fast_level}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+  clags_subcmd_t modes[] = {{.name = "fast", .config = &fast_config}};
+  clags_subcmds_t mode_subcmds = clags_subcmds(modes);
+  clags_config_t run_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Option,
+                               .opt = {.long_flag = "level",
+                                       .value_type = Clags_Int32,
+                                       .variable = &level}},
+                              {.type = Clags_Positional,
+                               .pos = {.arg_name = "mode",
+                                       .value_type = Clags_Subcmd,
+                                       .subcmds = &mode_subcmds,
+                                       .variable = &mode,
+                                       .optional = true}}},
+      .args_count = 2,
+      .options = global_options,
+  };
+  clags_subcmd_t items[] = {{.name = "run", .config = &run_config}};
+  clags_subcmds_t subcmds = clags_subcmds(items);
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "jobs",
+                       .value_type = Clags_Int32,
+                       .variable = &jobs,
+                       .env = "CLAGS_TEST_JOBS"}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "name", .variable = &name}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "tag",
+                       .variable = &tags,
+                       .is_list = true,
+                       .env = "CLAGS_TEST_TAG"}},
+              {.type = Clags_Flag,
+               .flag = {.long_flag = "verbose", .variable = &verbose}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "command",
+                       .value_type = Clags_Subcmd,
+                       .subcmds = &subcmds,
+                       .variable = &command}},
+          },
+      .args_count = 5,
+      .options = global_options,
+  };
+
+  // the file alone sets the root keys, without checking positionals
+  assert(clags_parse_file("clags_test_config.ini", &config) == nullptr);
+  assert(jobs == 2 && verbose && strcmp(name, " padded ") == 0);
+  assert(tags.count == 2 && level == 0);
+  assert(strcmp(clags_list_element(tags, char *, 1), "file-b") == 0);
+  clags_config_free(&config);
+  assert(config.mappings.count == 0);
+
+  // environment and argv take precedence, subcommands read their section
+  jobs = 0;
+  verbose = false;
+  assert(setenv("CLAGS_TEST_JOBS", "5", 1) == 0);
+  char *argv[] = {"prog", "--tag=argv", "run"};
+  assert(clags_parse_layered("clags_test_config.ini", 3, argv, &config) ==
+         nullptr);
+  assert(jobs == 5 && verbose && level == 3 && command == &items[0]);
+  assert(mode == nullptr && fast_level == 0);
+  assert(tags.count == 1);
+  assert(strcmp(clags_list_element(tags, char *, 0), "argv") == 0);
+  clags_list_free(&tags);
+
+  // nested subcommands read the section of their path only
+  level = 0;
+  char *nested[] = {"prog", "run", "fast"};
+  assert(clags_parse_layered("clags_test_config.ini", 3, nested, &config) ==
+         nullptr);
+  assert(level == 3 && fast_level == 7 && mode == &modes[0]);
+  clags_list_free(&tags);
+
+  // the environment replaces the file's list values
+  assert(setenv("CLAGS_TEST_TAG", "env", 1) == 0);
+  char *bare[] = {"prog", "run"};
+  assert(clags_parse_layered("clags_test_config.ini", 2, bare, &config) ==
+         nullptr);
+  assert(tags.count == 1);
+  assert(strcmp(clags_list_element(tags, char *, 0), "env") == 0);
+  clags_list_free(&tags);
+  assert(unsetenv("CLAGS_TEST_TAG") == 0);
+  assert(unsetenv("CLAGS_TEST_JOBS") == 0);
+  clags_config_free(&config);
+
+  // malformed or missing files and unknown keys are rejected
+  assert(clags_parse_file("clags_test_broken.ini", &config) == &config);
+  assert(config.error == Clags_Error_InvalidConfigFile);
+  assert(clags_parse_layered("clags_test_section.ini", 2, bare, &config) ==
+         &config);
+  assert(config.error == Clags_Error_InvalidConfigFile);
+  assert(clags_parse_layered("clags_test_missing.ini", 2, bare, &config) ==
+         &config);
+  assert(config.error == Clags_Error_InvalidConfigFile);
+  config.args[1].opt.long_flag = "title";
+  config.options.min_log_level = Clags_Error;
+  config.options.log_handler = record_first_error;
+  deferred_path_error[0] = '\0';
+  assert(clags_parse_file("clags_test_config.ini", &config) == &config);
+  assert(config.error == Clags_Error_InvalidOption);
+  assert(strcmp(config.error_record.token, "name") == 0);
+  assert(strstr(deferred_path_error, "'clags_test_config.ini' line 3") !=
+         nullptr);
+  clags_list_free(&tags);
+  clags_config_free(&config);
+
+  remove("clags_test_config.ini");
+  remove("clags_test_broken.ini");
+  remove("clags_test_section.ini");
+}
+
+// 39. Shell completion from the argument tables, without parsing
+void test_shell_completion() {
+  clags_choice_t modes[] = {{.value = "fast", .description = "skip checks"},
+                            {.value = "full"},
+                            {.value = "Safe"}};
+  clags_choices_t mode_choices = clags_choices(modes, .case_insensitive = true);
+  clags_choice_t mode = {0};
+  const char *output = nullptr;
+  const char *input = nullptr;
+  bool verbose = false;
+  bool force = false;
+  clags_subcmd_t *command = nullptr;
+  clags_config_t deep_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Flag,
+                               .flag = {.long_flag = "force",
+                                        .variable = &force}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+  clags_subcmd_t inner_items[] = {{.name = "deep", .config = &deep_config}};
+  clags_subcmds_t inner = clags_subcmds(inner_items);
+  clags_config_t build_config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "input",
+                       .value_type = Clags_Path,
+                       .variable = &input}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "command",
+                       .value_type = Clags_Subcmd,
+                       .subcmds = &inner,
+                       .variable = &command}},
+          },
+      .args_count = 2,
+      .options = global_options,
+  };
+  clags_subcmd_t items[] = {
+      {.name = "build", .description = "build it", .config = &build_config},
+      {.name = "bench", .config = &deep_config},
+      {.name = "clean"}};
+  clags_subcmds_t subcmds = clags_subcmds(items);
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'm',
+                       .long_flag = "mode",
+                       .value_type = Clags_Choice,
+                       .choices = &mode_choices,
+                       .variable = &mode,
+                       .description = "the mode"}},
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'o',
+                       .long_flag = "output",
+                       .variable = &output}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v',
+                        .long_flag = "verbose",
+                        .variable = &verbose}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "command",
+                       .value_type = Clags_Subcmd,
+                       .subcmds = &subcmds,
+                       .variable = &command}},
+          },
+      .args_count = 4,
+      .options = global_options,
+  };
+
+  struct {
+    char *argv[6];
+    int argc;
+    const char *expected;
+  } cases[] = {
+      {{"prog", "--m"}, 2, "--mode\tthe mode\n"},
+      {{"prog", "-"}, 2, "--mode\tthe mode\n--output\n--verbose\n-m\tthe mode\n"
+                         "-o\n-v\n"},
+      {{"prog", "--mode", "f"}, 3, "fast\tskip checks\nfull\n"},
+      {{"prog", "-vm", "s"}, 3, "Safe\n"},
+      {{"prog", "--mode=F"}, 2, "--mode=fast\tskip checks\n--mode=full\n"},
+      {{"prog", "-o", ""}, 3, ""},
+      {{"prog", "b"}, 2, "build\tbuild it\nbench\n"},
+      {{"prog", "-v", "--output", "x", "b"}, 5, "build\tbuild it\nbench\n"},
+      {{"prog", "build", "--input", "missing/file", "d"}, 5, "deep\n"},
+      {{"prog", "build", "--input=missing", "deep", "--"}, 5, "--force\n"},
+      {{"prog", "bench", "--f"}, 3, "--force\n"},
+      {{"prog", "unknown", "--"}, 3, ""},
+      {{"prog"}, 1, "build\tbuild it\nbench\nclean\n"},
+  };
+  for (size_t i = 0; i < clags_arr_len(cases); ++i) {
+    clags_sb_t out = {0};
+    assert(clags_complete(cases[i].argc, cases[i].argv, &config, &out));
+    assert(out.count == strlen(cases[i].expected));
+    assert(out.count == 0 ||
+           memcmp(out.items, cases[i].expected, out.count) == 0);
+    clags_sb_free(&out);
+  }
+  // nothing was parsed, verified or stored
+  assert(mode.value == nullptr && output == nullptr && input == nullptr);
+  assert(!verbose && !force && command == nullptr);
+  assert(config.compiled == nullptr && config.error == Clags_Error_Ok);
+
+  const char *names[] = {"bash", "zsh", "fish"};
+  for (size_t shell = 0; shell < clags_arr_len(names); ++shell) {
+    clags_sb_t out = {0};
+    clags_completion_script((clags_shell_t)shell, "./bin/my-tool", &out);
+    clags_sb_append_null(&out);
+    assert(strstr(out.items, "_clags_complete_my_tool") != nullptr);
+    assert(strstr(out.items, " my-tool") != nullptr);
+    assert(strstr(out.items, "./bin") == nullptr);
+    assert(strstr(out.items, CLAGS_COMPLETE_COMMAND) != nullptr);
+    clags_sb_free(&out);
+  }
+  clags_config_free(&config);
+}
+
+// 40. Token classification at every alignment, up to an unmapped page
+void test_token_scan() {
+  long page_size = sysconf(_SC_PAGESIZE);
+  assert(page_size > 0);
+  char *pages = mmap(nullptr, (size_t)page_size * 2, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  assert(pages != MAP_FAILED);
+  assert(mprotect(pages + page_size, (size_t)page_size, PROT_NONE) == 0);
+  char *page_end = pages + page_size;
+
+  const char *name = nullptr;
+  const char *input = nullptr;
+  bool verbose = false;
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'n',
+                       .long_flag = "name",
+                       .variable = &name}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v',
+                        .long_flag = "verbose",
+                        .variable = &verbose}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "input", .variable = &input}},
+          },
+      .args_count = 3,
+      .options = {.min_log_level = Clags_NoLogs,
+                  .ignore_prefix = "#",
+                  .list_terminator = "::"},
+  };
+  // values of every length put the '=' and the null byte at every offset
+  // within a block, the token ending right in front of the unmapped page
+  char value[40];
+  for (size_t length = 1; length < sizeof(value); ++length) {
+    memset(value, 'a' + (int)(length % 26), length);
+    value[length] = '\0';
+    char *argv[4] = {"prog"};
+    char *tokens[3] = {nullptr};
+    size_t sizes[3];
+    sizes[0] = (size_t)snprintf(nullptr, 0, "--name=%s", value) + 1;
+    sizes[1] = (size_t)snprintf(nullptr, 0, "%s=x", value) + 1;
+    sizes[2] = sizeof("-v");
+    tokens[0] = page_end - sizes[0];
+    tokens[1] = tokens[0] - sizes[1];
+    tokens[2] = tokens[1] - sizes[2];
+    snprintf(tokens[0], sizes[0], "--name=%s", value);
+    snprintf(tokens[1], sizes[1], "%s=x", value);
+    memcpy(tokens[2], "-v", sizes[2]);
+    argv[1] = tokens[2];
+    argv[2] = tokens[1];
+    argv[3] = tokens[0];
+
+    name = nullptr;
+    input = nullptr;
+    verbose = false;
+    assert(clags_parse(4, argv, &config) == nullptr);
+    assert(verbose && strcmp(name, value) == 0);
+    assert(strncmp(input, value, length) == 0);
+    assert(strcmp(input + length, "=x") == 0);
+
+    // an unknown name is cut at the first '='
+    char *unknown[] = {"prog", tokens[1] - 2};
+    memcpy(unknown[1], "--", 2);
+    assert(clags_parse(2, unknown, &config) == &config);
+    assert(config.error == Clags_Error_InvalidOption);
+    assert(config.error_record.token_length == length);
+  }
+  clags_config_free(&config);
+  assert(munmap(pages, (size_t)page_size * 2) == 0);
+}
+
+// 41. Lazy conversion on first access
+static size_t lazy_verify_calls = 0;
+
+bool verify_lazy_even(clags_config_t *config, const char *arg_name,
+                      const char *arg, void *variable) {
+  (void)config;
+  (void)arg_name;
+  lazy_verify_calls++;
+  int value = atoi(arg);
+  if (value % 2 != 0)
+    return false;
+  *(int *)variable = value;
+  return true;
+}
+
+typedef struct {
+  int32_t jobs;
+  clags_list_t ids;
+} lazy_result_t;
+
+void test_lazy_conversion() {
+  int32_t jobs = 0;
+  double ratio = 0;
+  int even = 0;
+  const char *name = nullptr;
+  const char *input = nullptr;
+  uint32_t level = 0;
+  clags_list_t ids = clags_uint64_list();
+  clags_subcmd_t *command = nullptr;
+  clags_config_t run_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Option,
+                               .opt = {.long_flag = "level",
+                                       .value_type = Clags_UInt32,
+                                       .variable = &level}}},
+      .args_count = 1,
+      .options = {.lazy_conversion = true, .min_log_level = Clags_NoLogs},
+  };
+  clags_subcmd_t items[] = {{.name = "run", .config = &run_config}};
+  clags_subcmds_t subcmds = clags_subcmds(items);
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "jobs",
+                       .value_type = Clags_Int32,
+                       .variable = &jobs}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "ratio",
+                       .value_type = Clags_Double,
+                       .variable = &ratio}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "even",
+                       .value_type = Clags_Custom,
+                       .verify = verify_lazy_even,
+                       .variable = &even}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "id",
+                       .value_type = Clags_UInt64,
+                       .variable = &ids,
+                       .is_list = true}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "name", .variable = &name}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "input",
+                       .value_type = Clags_File,
+                       .variable = &input}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "command",
+                       .value_type = Clags_Subcmd,
+                       .subcmds = &subcmds,
+                       .variable = &command}},
+          },
+      .args_count = 7,
+      .options = {.lazy_conversion = true, .min_log_level = Clags_NoLogs},
+  };
+
+  // only the syntax is checked, strings and subcommands are set right away
+  char *argv[] = {"prog",   "--jobs",  "3",      "--jobs=4",     "--ratio=x.5",
+                  "--even", "6",       "--id",   "1",            "--id=2",
+                  "--name", "n",       "--input", "missing/file", "run",
+                  "--level", "-1"};
+  assert(clags_parse(clags_arr_len(argv), argv, &config) == nullptr);
+  assert(command == &items[0] && strcmp(name, "n") == 0);
+  assert(jobs == 0 && lazy_verify_calls == 0 && ids.count == 0);
+  assert(input == nullptr && level == 0);
+
+  // conversion runs once per value, in argument order
+  assert(clags_get(&config, &jobs) && jobs == 4);
+  assert(clags_get(&config, &even) && clags_get(&config, &even));
+  assert(even == 6 && lazy_verify_calls == 1);
+  assert(clags_get(&config, &ids) && clags_get(&config, &ids));
+  assert(ids.count == 2 && clags_list_element(ids, uint64_t, 1) == 2);
+  assert(clags_get(&config, &name));
+
+  // failures are memoized and reported on every access
+  assert(!clags_get(&config, &ratio));
+  assert(config.error == Clags_Error_InvalidValue);
+  assert(strcmp(config.error_record.arg_name, "ratio") == 0);
+  assert(config.error_record.index == 4);
+  assert(strcmp(config.error_record.token, "x.5") == 0);
+  assert(config.error_record.expected == Clags_Double);
+  config.error = Clags_Error_Ok;
+  assert(!clags_get(&config, &ratio));
+  assert(config.error == Clags_Error_InvalidValue);
+  assert(!clags_get(&config, &input));
+  assert(strcmp(config.error_record.token, "missing/file") == 0);
+
+  // validating everything reports the first failure, even below a subcommand
+  assert(clags_validate_all(&config) == &config);
+  char *valid_argv[] = {"prog", "--jobs", "5", "run", "--level", "-1"};
+  assert(clags_parse(clags_arr_len(valid_argv), valid_argv, &config) ==
+         nullptr);
+  assert(clags_validate_all(&config) == &run_config);
+  assert(run_config.error == Clags_Error_InvalidValue);
+  assert(jobs == 5 && level == 0);
+  clags_config_free(&config);
+  assert(config.lazy_values.items == nullptr);
+
+  // contexts record the values of field offsets
+  clags_config_t field_config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "jobs",
+                       .value_type = Clags_Int32,
+                       .variable = clags_field(lazy_result_t, jobs)}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "ids",
+                       .value_type = Clags_UInt64,
+                       .variable = clags_field(lazy_result_t, ids),
+                       .is_list = true}},
+          },
+      .args_count = 2,
+      .options = {.lazy_conversion = true, .min_log_level = Clags_NoLogs},
+  };
+  lazy_result_t result = {.ids = clags_uint64_list()};
+  clags_context_t context = clags_context(&result);
+  char *context_argv[] = {"prog", "--jobs", "7", "8", "9"};
+  assert(clags_parse_context(5, context_argv, &field_config, &context) ==
+         nullptr);
+  assert(result.jobs == 0 && result.ids.count == 0);
+  assert(field_config.lazy_values.count == 0);
+  assert(clags_get_context(&context, &result.ids));
+  assert(result.ids.count == 2 && result.jobs == 0);
+  assert(clags_validate_all_context(&context) == nullptr);
+  assert(result.jobs == 7);
+  clags_context_free(&context, &field_config);
+}
+
+// 42. Streamed lists hand each element to a callback
+typedef struct {
+  uint64_t sum;
+  size_t calls;
+  const char *last;
+} stream_state_t;
+
+bool stream_number(clags_config_t *config, const void *element, void *data) {
+  (void)config;
+  stream_state_t *state = data;
+  state->calls++;
+  uint32_t value = *(const uint32_t *)element;
+  state->sum += value;
+  return value != 0;
+}
+
+bool stream_string(clags_config_t *config, const void *element, void *data) {
+  (void)config;
+  stream_state_t *state = data;
+  state->calls++;
+  state->last = *(const char *const *)element;
+  return true;
+}
+
+void test_streamed_lists() {
+  stream_state_t numbers_state = {0};
+  stream_state_t names_state = {0};
+  clags_list_t numbers =
+      clags_streamed_list(sizeof(uint32_t), stream_number, &numbers_state);
+  clags_list_t names =
+      clags_streamed_list(sizeof(char *), stream_string, &names_state);
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "name",
+                       .variable = &names,
+                       .is_list = true}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "numbers",
+                       .value_type = Clags_UInt32,
+                       .variable = &numbers,
+                       .is_list = true}},
+          },
+      .args_count = 2,
+      .options = {.presize_lists = true, .min_log_level = Clags_NoLogs},
+  };
+
+  char *argv[] = {"prog", "1", "--name", "a", "2", "--name=b", "3"};
+  assert(clags_parse(clags_arr_len(argv), argv, &config) == nullptr);
+  assert(numbers_state.calls == 3 && numbers_state.sum == 6);
+  assert(numbers.count == 0 && numbers.streamed == 3);
+  assert(numbers.capacity == 1);
+  assert(names_state.calls == 2 && strcmp(names_state.last, "b") == 0);
+  assert(names.count == 0 && names.streamed == 2);
+
+  // invalid and rejected elements fail the parse right away
+  char *invalid_argv[] = {"prog", "4", "x", "5"};
+  assert(clags_parse(4, invalid_argv, &config) == &config);
+  assert(config.error == Clags_Error_InvalidValue);
+  assert(numbers_state.calls == 4 && numbers.streamed == 4);
+  char *rejected_argv[] = {"prog", "0", "6"};
+  assert(clags_parse(3, rejected_argv, &config) == &config);
+  assert(config.error == Clags_Error_InvalidValue);
+  assert(config.error_record.token[0] == '0');
+  assert(numbers_state.calls == 5 && numbers.streamed == 4);
+
+  clags_config_free(&config);
+  assert(numbers.items == nullptr && numbers.streamed == 0);
+  assert(numbers.on_element == stream_number);
+}
+
+// 43. Fixed lists over caller storage never allocate
+void test_fixed_lists() {
+  int32_t storage[3] = {0};
+  const char *name_storage[2] = {nullptr};
+  clags_list_t numbers = clags_fixed_list(storage, clags_arr_len(storage));
+  clags_list_t names = clags_fixed_list(name_storage, 2);
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "name",
+                       .variable = &names,
+                       .is_list = true}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "numbers",
+                       .value_type = Clags_Int32,
+                       .variable = &numbers,
+                       .is_list = true}},
+          },
+      .args_count = 2,
+      .options = {.presize_lists = true, .min_log_level = Clags_NoLogs},
+  };
+  assert(clags_compile(&config));
+
+  char *argv[] = {"prog", "1", "--name", "a", "2", "3"};
+  clags_parse_stats_t stats = {0};
+  clags_stats_attach(&stats);
+  assert(clags_parse(clags_arr_len(argv), argv, &config) == nullptr);
+  clags_stats_attach(nullptr);
+#if CLAGS_STATS
+  assert(stats.parses == 1 && stats.allocations == 0);
+#else
+  assert(stats.parses == 0);
+#endif // CLAGS_STATS
+  assert(numbers.items == storage && numbers.count == 3);
+  assert(storage[0] == 1 && storage[2] == 3);
+  assert(names.count == 1 && strcmp(name_storage[0], "a") == 0);
+
+  // freeing empties the list but keeps the storage for the next parse
+  clags_list_free(&numbers);
+  clags_list_free(&names);
+  assert(numbers.items == storage && numbers.count == 0);
+  assert(numbers.capacity == 3);
+
+  // overflowing the capacity fails the parse instead of growing the list
+  char *overflow_argv[] = {"prog", "4", "5", "6", "7"};
+  assert(clags_parse(5, overflow_argv, &config) == &config);
+  assert(config.error == Clags_Error_InvalidValue);
+  assert(config.error_record.index == 4);
+  assert(strcmp(config.error_record.arg_name, "numbers") == 0);
+  assert(numbers.items == storage && numbers.count == 3);
+  assert(storage[2] == 6);
+
+  clags_config_free(&config);
+  clags_config_free_compiled(&config);
+  assert(numbers.items == storage && numbers.count == 0);
+}
+
+// 44. Batch parses share the tables, and report per vector
+void test_parse_batch() {
+  clags_config_t run_config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'j',
+                       .value_type = Clags_Int32,
+                       .variable = clags_field(context_result_t, jobs)}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "target",
+                       .variable = clags_field(context_result_t, target)}},
+          },
+      .args_count = 2,
+      .options = global_options,
+  };
+  clags_subcmd_t subcmds[] = {{.name = "run", .config = &run_config}};
+  clags_subcmds_t subcmd_list = clags_subcmds(subcmds);
+  clags_config_t config = {
+      .args = (clags_arg_t[]){{.type = Clags_Positional,
+                               .pos = {.arg_name = "command",
+                                       .value_type = Clags_Subcmd,
+                                       .subcmds = &subcmd_list,
+                                       .variable = clags_field(
+                                           context_result_t, command)}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+
+  // enough vectors for several threads, every 100th with an invalid value
+  enum { count = 3 * CLAGS_BATCH_SIZE };
+  static char jobs[count][8];
+  static char *argvs[count][5];
+  static clags_argv_t vectors[count];
+  static context_result_t values[count];
+  static clags_context_t results[count];
+  for (size_t i = 0; i < count; ++i) {
+    snprintf(jobs[i], sizeof(jobs[i]), i % 100 == 7 ? "x%zu" : "%zu", i);
+    argvs[i][0] = "prog";
+    argvs[i][1] = "run";
+    argvs[i][2] = "-j";
+    argvs[i][3] = jobs[i];
+    argvs[i][4] = i % 2 == 0 ? "even" : "odd";
+    vectors[i] = (clags_argv_t){.argc = 5, .argv = argvs[i]};
+    values[i] = (context_result_t){0};
+    results[i] = (clags_context_t)clags_context(&values[i]);
+  }
+  size_t failed = clags_parse_batch(&config, vectors, count, results);
+  assert(failed == (count + 92) / 100);
+  for (size_t i = 0; i < count; ++i) {
+    if (i % 100 == 7) {
+      assert(results[i].error == Clags_Error_InvalidValue);
+      assert(results[i].error_record.index == 3);
+      continue;
+    }
+    assert(results[i].error == Clags_Error_Ok);
+    assert(results[i].config == &run_config);
+    assert(values[i].command == &subcmds[0]);
+    assert(values[i].jobs == (int32_t)i);
+    assert(strcmp(values[i].target, i % 2 == 0 ? "even" : "odd") == 0);
+  }
+  // the tables compiled for the batch are gone again
+  assert(config.compiled == nullptr && run_config.compiled == nullptr);
+  assert(config.error == Clags_Error_Ok && run_config.error == Clags_Error_Ok);
+
+  // without struct variables, the vectors are parsed in order
+  int32_t level = 0;
+  clags_config_t shared = {
+      .args = (clags_arg_t[]){{.type = Clags_Option,
+                               .opt = {.short_flag = 'l',
+                                       .value_type = Clags_Int32,
+                                       .variable = &level}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+  assert(clags_compile(&shared));
+  char *first[] = {"prog", "-l", "1"};
+  char *second[] = {"prog", "-l"};
+  char *third[] = {"prog", "-l", "3"};
+  clags_argv_t shared_vectors[] = {{3, first}, {2, second}, {3, third}};
+  clags_context_t shared_results[3] = {clags_context(nullptr),
+                                       clags_context(nullptr),
+                                       clags_context(nullptr)};
+  assert(clags_parse_batch(&shared, shared_vectors, 3, shared_results) == 1);
+  assert(shared_results[0].error == Clags_Error_Ok);
+  assert(shared_results[1].error == Clags_Error_InvalidOption);
+  assert(shared_results[2].error == Clags_Error_Ok && level == 3);
+  assert(shared.compiled != nullptr);
+  clags_config_free_compiled(&shared);
+
+  // a config failing validation fails every vector, and stays invalid
+  const char *first_dup = nullptr;
+  const char *second_dup = nullptr;
+  clags_config_t invalid = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.long_flag = "dup", .variable = &first_dup}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "dup", .variable = &second_dup}},
+          },
+      .args_count = 2,
+      .options = global_options,
+  };
+  char *dup_argv[] = {"prog", "--dup", "x"};
+  clags_argv_t dup_vectors[] = {{3, dup_argv}, {3, dup_argv}};
+  clags_context_t dup_results[2] = {clags_context(nullptr),
+                                    clags_context(nullptr)};
+  for (int round = 0; round < 2; ++round) {
+    assert(clags_parse_batch(&invalid, dup_vectors, 2, dup_results) == 2);
+    assert(dup_results[0].error == Clags_Error_InvalidConfig);
+    assert(dup_results[1].error == Clags_Error_InvalidConfig);
+    assert(invalid.invalid && invalid.compiled == nullptr);
+    assert(first_dup == nullptr && second_dup == nullptr);
+  }
+
+  // so does an invalid subcommand config, even if no vector selects it
+  clags_subcmd_t broken[] = {{.name = "run", .config = &run_config},
+                             {.name = "dup", .config = &invalid}};
+  subcmd_list = (clags_subcmds_t)clags_subcmds(broken);
+  results[0] = (clags_context_t)clags_context(&values[0]);
+  assert(clags_parse_batch(&config, vectors, 1, results) == 1);
+  assert(results[0].error == Clags_Error_InvalidConfig);
+  assert(config.compiled == nullptr && run_config.compiled == nullptr);
+}
+
+// 45. Snapshots load back into the variables without parsing
+void test_snapshot() {
+  int32_t jobs = 0;
+  bool verbose = false;
+  size_t level = 0;
+  const char *output = nullptr;
+  clags_choice_t *mode = nullptr;
+  clags_subcmd_t *command = nullptr;
+  clags_list_t files = clags_string_list();
+  clags_list_t modes = clags_choice_list();
+  uint64_t limit_storage[4] = {0};
+  clags_list_t limits = clags_fixed_list(limit_storage, 4);
+  clags_choice_t mode_items[] = {{"fast", ""}, {"safe", ""}};
+  clags_choices_t choices = {.items = mode_items, .count = 2};
+
+  clags_config_t run_config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'm',
+                       .value_type = Clags_Choice,
+                       .variable = &modes,
+                       .choices = &choices,
+                       .is_list = true}},
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'l',
+                       .value_type = Clags_UInt64,
+                       .variable = &limits,
+                       .is_list = true}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "files",
+                       .variable = &files,
+                       .is_list = true}},
+          },
+      .args_count = 3,
+      .options = global_options,
+  };
+  clags_subcmd_t subcmds[] = {{.name = "run", .config = &run_config}};
+  clags_subcmds_t subcmd_list = clags_subcmds(subcmds);
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'j',
+                       .value_type = Clags_Int32,
+                       .variable = &jobs}},
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'o', .variable = &output}},
+              {.type = Clags_Option,
+               .opt = {.short_flag = 'M',
+                       .value_type = Clags_Choice,
+                       .variable = &mode,
+                       .choices = &choices}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'v', .variable = &verbose}},
+              {.type = Clags_Flag,
+               .flag = {.short_flag = 'L',
+                        .variable = &level,
+                        .type = Clags_CountFlag}},
+              {.type = Clags_Positional,
+               .pos = {.arg_name = "command",
+                       .value_type = Clags_Subcmd,
+                       .subcmds = &subcmd_list,
+                       .variable = &command}},
+          },
+      .args_count = 6,
+      .options = global_options,
+  };
+
+  char *argv[] = {"prog", "-j", "12", "-o", "out.bin", "-M", "safe", "-vLL",
+                  "run", "-m", "safe", "-l", "7", "a.c", "-m", "fast", "b.c"};
+  assert(clags_parse(clags_arr_len(argv), argv, &config) == nullptr);
+  clags_sb_t snapshot = {0};
+  assert(clags_snapshot(&config, nullptr, &snapshot));
+
+  // reset every variable, then load a moved copy of the snapshot
+  clags_list_free(&files);
+  clags_list_free(&modes);
+  clags_list_free(&limits);
+  jobs = 0, verbose = false, level = 0, output = nullptr;
+  mode = nullptr, command = nullptr;
+  char *buffer = malloc(snapshot.count);
+  assert(buffer != nullptr);
+  memcpy(buffer, snapshot.items, snapshot.count);
+  clags_context_t context = clags_context(nullptr);
+  assert(clags_snapshot_load(&config, &context, buffer, snapshot.count));
+  assert(context.config == &run_config);
+  assert(jobs == 12 && verbose && level == 2 && mode == &mode_items[1]);
+  assert(strcmp(output, "out.bin") == 0 && output != argv[4]);
+  assert(output >= buffer && output < buffer + snapshot.count);
+  assert(command == &subcmds[0]);
+  assert(files.count == 2 && files.fixed);
+  assert(strcmp(clags_list_element(files, char *, 1), "b.c") == 0);
+  assert(modes.count == 2);
+  assert(clags_list_element(modes, clags_choice_t *, 1) == &mode_items[0]);
+  assert(limits.items != limit_storage && limits.count == 1);
+  assert(clags_list_element(limits, uint64_t, 0) == 7);
+
+  // pointers are fixed up again after the buffer moved
+  char *moved = malloc(snapshot.count);
+  assert(moved != nullptr);
+  memcpy(moved, buffer, snapshot.count);
+  free(buffer);
+  assert(clags_snapshot_load(&config, nullptr, moved, snapshot.count));
+  assert(output >= moved && output < moved + snapshot.count);
+  assert(strcmp(clags_list_element(files, char *, 0), "a.c") == 0);
+
+  // damaged snapshots or other configs leave the variables untouched
+  moved[0] ^= 1;
+  jobs = 5;
+  assert(!clags_snapshot_load(&config, &context, moved, snapshot.count));
+  assert(context.error == Clags_Error_InvalidSnapshot && jobs == 5);
+  moved[0] ^= 1;
+  assert(!clags_snapshot_load(&run_config, nullptr, moved, snapshot.count));
+  assert(run_config.error == Clags_Error_InvalidSnapshot);
+  assert(!clags_snapshot_load(&config, nullptr, moved, snapshot.count - 1));
+
+  // custom values have no known layout
+  int custom = 0;
+  clags_config_t custom_config = {
+      .args = (clags_arg_t[]){{.type = Clags_Option,
+                               .opt = {.short_flag = 'c',
+                                       .value_type = Clags_Custom,
+                                       .verify = verify_lazy_even,
+                                       .variable = &custom}}},
+      .args_count = 1,
+      .options = global_options,
+  };
+  assert(!clags_snapshot(&custom_config, nullptr, &snapshot));
+  assert(custom_config.error == Clags_Error_InvalidConfig);
+
+  free(moved);
+  clags_sb_free(&snapshot);
+  clags_config_free(&config);
+}
+
+// 46. Interned duplicates share one allocation per pool
+void test_string_interning() {
+  clags_list_t tags = clags_string_list();
+  clags_config_t config = {
+      .args = (clags_arg_t[]){{.type = Clags_Positional,
+                               .pos = {.arg_name = "tags",
+                                       .variable = &tags,
+                                       .is_list = true}}},
+      .args_count = 1,
+      .options = {.duplicate_strings = true,
+                  .intern_strings = true,
+                  .min_log_level = Clags_NoLogs},
+  };
+  char names[3][8] = {"red", "green", "blue"};
+  char *argv[301] = {"prog"};
+  for (size_t i = 0; i < 300; ++i)
+    argv[i + 1] = names[i % 3];
+
+  clags_parse_stats_t stats = {0};
+  clags_stats_attach(&stats);
+  assert(clags_parse(301, argv, &config) == nullptr);
+  clags_stats_attach(nullptr);
+  assert(tags.count == 300);
+  char **items = tags.items;
+  assert(items[0] != argv[1] && strcmp(items[0], "red") == 0);
+  assert(items[0] == items[3] && items[1] == items[298]);
+  assert(items[0] != items[1]);
+  // the program name and the three distinct tags
+  assert(config.allocs.count == 4 && config.interned.count == 4);
+#if CLAGS_STATS
+  assert(stats.strings_duplicated == 301 && stats.strings_interned == 297);
+  assert(stats.bytes_interned == 99 * 4 + 99 * 6 + 99 * 5);
+#endif // CLAGS_STATS
+  clags_config_free(&config);
+  assert(config.interned.slots == nullptr && config.interned.count == 0);
+
+  // an arena interns into its own table, forgotten with its strings
+  clags_arena_t arena = {0};
+  config.options.arena = &arena;
+  assert(clags_parse(301, argv, &config) == nullptr);
+  items = tags.items;
+  assert(items[0] == items[3] && config.allocs.count == 0);
+  assert(arena.interned.count == 4);
+  clags_config_free(&config);
+  clags_arena_reset(&arena);
+  assert(arena.interned.slots == nullptr);
+
+  // contexts keep their own pool
+  config.options.arena = nullptr;
+  config.args[0].pos.variable = clags_field(context_result_t, files);
+  context_result_t result = {.files = clags_string_list()};
+  clags_context_t context = clags_context(&result);
+  assert(clags_parse_context(301, argv, &config, &context) == nullptr);
+  items = result.files.items;
+  assert(items[2] == items[5] && context.allocs.count == 4);
+  assert(context.interned.count == 4 && config.interned.count == 0);
+  clags_context_free(&context, &config);
+  assert(context.interned.slots == nullptr);
+  clags_arena_free(&arena);
+}
+
+// 47. Doubles round like strtod in the "C" locale, whatever LC_NUMERIC says
+void test_double_parsing() {
+  clags_config_t config = {.options = {.min_log_level = Clags_NoLogs}};
+  static const char *const values[] = {
+      "0.5",      "-0",     "1e22",       "9007199254740993",
+      "1e23",     "3e37",   "0.1",        "2.2250738585072014e-308",
+      "1e-400",   "1e400",  "0x1.8p1",    "123456789012345678901234",
+      "  +7.25",  "5.",     ".125",       "1.7976931348623157e308",
+      "4.9e-324", "1e-22",  "0.30000000000000004",
+  };
+  static const char *const invalid[] = {"", ".", "e5", "1e", "1.5x", "inf",
+                                        "nan", "1,5"};
+  char buffer[64];
+  uint64_t seed = 0x2545'F491'4F6C'DD1DULL;
+  for (size_t i = 0; i < clags_arr_len(values) + 20'000; ++i) {
+    const char *arg = buffer;
+    if (i < clags_arr_len(values)) {
+      arg = values[i];
+    } else {
+      // up to 19 random digits with a decimal point and an exponent
+      seed ^= seed << 13, seed ^= seed >> 7, seed ^= seed << 17;
+      char digits[24];
+      int length = snprintf(digits, sizeof(digits), "%" PRIu64, seed >> 1);
+      int used = 1 + (int)(seed % 19) % length;
+      int point = (int)((seed >> 8) % (uint64_t)(used + 1));
+      int exponent = (int)((seed >> 16) % 80) - 40;
+      snprintf(buffer, sizeof(buffer), "%.*s.%.*se%d", point, digits,
+               used - point, digits + point, exponent);
+    }
+    errno = 0;
+    char *end;
+    double expected = strtod(arg, &end);
+    bool valid = *end == '\0' && errno != ERANGE && isfinite(expected);
+    double value = 0.0;
+    assert(clags__verify_double(&config, "d", arg, &value, nullptr) == valid);
+    assert(!valid || memcmp(&value, &expected, sizeof(value)) == 0);
+  }
+  for (size_t i = 0; i < clags_arr_len(invalid); ++i) {
+    assert(!clags__verify_double(&config, "d", invalid[i], nullptr, nullptr));
+  }
+
+  // fractional durations share the parser
+  clags_time_t time = 0;
+  assert(clags__verify_time_ns(&config, "t", "1.5ms", &time, nullptr) &&
+         time == 1500000);
+  assert(clags__verify_time_s(&config, "t", "2.25h", &time, nullptr) &&
+         time == 8100);
+  assert(clags__verify_time_ns(&config, "t", "2.5e-3s", &time, nullptr) &&
+         time == 2500000);
+
+  // a comma locale must not change how '.' is read
+  if (setlocale(LC_NUMERIC, "de_DE.UTF-8") != nullptr) {
+    double value = 0.0;
+    assert(clags__verify_double(&config, "d", "0.5", &value, nullptr) &&
+           value == 0.5);
+    assert(clags__verify_double(&config, "d", "0.1e400", &value, nullptr) ==
+           false);
+    assert(clags__verify_time_ns(&config, "t", "1.5ms", &time, nullptr) &&
+           time == 1500000);
+    // also past the fast path, and never with the locale's decimal point
+    assert(clags__verify_double(&config, "d", "12345678901234567890.5",
+                                &value, nullptr) &&
+           value == 12345678901234567890.5);
+    assert(clags__verify_double(&config, "d", "0x1.8p1", &value, nullptr) &&
+           value == 3.0);
+    assert(!clags__verify_double(&config, "d", "12345678901234567890,5",
+                                 &value, nullptr));
+    assert(!clags__verify_double(&config, "d", "0x1,8p1", &value, nullptr));
+    assert(!clags__verify_double(&config, "d", "1,5", &value, nullptr));
+    setlocale(LC_NUMERIC, "C");
+  }
+}
+
+// 48. Unique prefixes of long flags with abbreviations enabled
+void test_long_flag_abbreviation() {
+  bool verbose = false;
+  bool version = false;
+  const char *output = nullptr;
+  const char *out = nullptr;
+  clags_list_t inputs = clags_string_list();
+  clags_config_t config = {
+      .args =
+          (clags_arg_t[]){
+              {.type = Clags_Flag,
+               .flag = {.long_flag = "verbose", .variable = &verbose}},
+              {.type = Clags_Flag,
+               .flag = {.long_flag = "version", .variable = &version}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "output", .variable = &output}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "out", .variable = &out}},
+              {.type = Clags_Option,
+               .opt = {.long_flag = "input",
+                       .variable = &inputs,
+                       .is_list = true}},
+          },
+      .args_count = 5,
+      .options = {.abbreviate_long_flags = true,
+                  .presize_lists = true,
+                  .min_log_level = Clags_NoLogs},
+  };
+
+  for (int compiled = 0; compiled < 2; ++compiled) {
+    if (compiled)
+      assert(clags_compile(&config));
+    verbose = false, output = out = nullptr;
+    // prefixes resolve to the only candidate, exact names beat longer ones
+    char *argv[] = {"prog", "--verb", "--outp=a", "--out", "b", "--in", "x",
+                    "--i=y"};
+    assert(clags_parse(8, argv, &config) == nullptr);
+    assert(verbose && !version);
+    assert(strcmp(output, "a") == 0 && strcmp(out, "b") == 0);
+    assert(inputs.count == 2 && inputs.capacity == 2);
+    assert(strcmp(clags_list_element(inputs, char *, 1), "y") == 0);
+    clags_list_free(&inputs);
+
+    // ambiguous prefixes fail with the prefix as the offending token
+    char *ambiguous[] = {"prog", "--in", "x", "--ver"};
+    assert(clags_parse(4, ambiguous, &config) == &config);
+    assert(config.error == Clags_Error_InvalidOption);
+    assert(config.error_record.index == 3);
+    assert(config.error_record.token_length == 3);
+    assert(strncmp(config.error_record.token, "ver", 3) == 0);
+    char *unknown[] = {"prog", "--vx"};
+    assert(clags_parse(2, unknown, &config) == &config);
+    clags_config_free(&config);
+  }
+
+  // without the option only exact names match
+  config.options.abbreviate_long_flags = false;
+  char *argv[] = {"prog", "--verb"};
+  assert(clags_parse(2, argv, &config) == &config);
+  clags_config_free(&config);
+  clags_config_free_compiled(&config);
+}
+
 int main() {
   test_int_option();
   printf("- Test 'int option' passed!\n");
@@ -439,6 +2716,73 @@ int main() {
   printf("- Test 'subcommand cycle rejection' passed!\n");
   test_duplicate_string_cleanup_clears_name();
   printf("- Test 'duplicate-string cleanup name reset' passed!\n");
+  test_long_option_shared_prefix();
+  printf("- Test 'long option shared prefix' passed!\n");
+  test_duplicate_long_flag_rejected();
+  printf("- Test 'duplicate long flag rejection' passed!\n");
+
+  test_combined_short_flags();
+  printf("- Test 'combined short flags' passed!\n");
+  test_duplicate_short_flag_rejected();
+  printf("- Test 'duplicate short flag rejection' passed!\n");
+
+  test_compiled_config_reuse();
+  printf("- Test 'compiled config reuse' passed!\n");
+  test_compile_invalid_config();
+  printf("- Test 'invalid config compilation' passed!\n");
+
+  test_context_parse_offsets();
+  printf("- Test 'context parse with field offsets' passed!\n");
+  test_arena_allocation();
+  printf("- Test 'arena allocation' passed!\n");
+  test_presize_lists();
+  printf("- Test 'presized lists' passed!\n");
+  test_response_files();
+  printf("- Test 'response files' passed!\n");
+  test_incremental_parser();
+  printf("- Test 'incremental parser' passed!\n");
+  test_numeric_parsing_edge_cases();
+  printf("- Test 'numeric parsing edge cases' passed!\n");
+  test_choice_hash_index();
+  printf("- Test 'choice hash index' passed!\n");
+  test_deferred_path_checks();
+  printf("- Test 'deferred path checks' passed!\n");
+  test_subcmd_dispatch_index();
+  printf("- Test 'subcommand dispatch index' passed!\n");
+  test_generated_tables();
+  printf("- Test 'generated tables' passed!\n");
+  test_usage_sb();
+  printf("- Test 'usage string builder' passed!\n");
+  test_cached_usage();
+  printf("- Test 'cached usage' passed!\n");
+  test_error_records();
+  printf("- Test 'error records' passed!\n");
+  test_parse_stats();
+  printf("- Test 'parse instrumentation' passed!\n");
+  test_env_fallback();
+  printf("- Test 'environment variable fallback' passed!\n");
+  test_config_file();
+  printf("- Test 'config file layer' passed!\n");
+  test_shell_completion();
+  printf("- Test 'shell completion' passed!\n");
+  test_token_scan();
+  printf("- Test 'token classification' passed!\n");
+  test_lazy_conversion();
+  printf("- Test 'lazy conversion' passed!\n");
+  test_streamed_lists();
+  printf("- Test 'streamed lists' passed!\n");
+  test_fixed_lists();
+  printf("- Test 'fixed lists' passed!\n");
+  test_parse_batch();
+  printf("- Test 'parse batch' passed!\n");
+  test_snapshot();
+  printf("- Test 'snapshot' passed!\n");
+  test_string_interning();
+  printf("- Test 'string interning' passed!\n");
+  test_double_parsing();
+  printf("- Test 'double parsing' passed!\n");
+  test_long_flag_abbreviation();
+  printf("- Test 'long flag abbreviation' passed!\n");
 
   printf("\nAll tests passed!\n");
   return 0;